@@ -0,0 +1,147 @@
+// Spectrogram drawing throughput: the palette blitter in spectro_blit.c
+// against the per-pixel get_heatmap_color() + lv_canvas_set_px() loop it
+// replaced, on a 640 x 240 recorder spectrogram.
+#include <stdint.h>
+#include <stdlib.h>
+#include "host_test.h"
+#include "spectro_blit.h"
+
+#define W       640
+#define H       240
+#define FRAMES  50
+
+// The removed colour function, returning the lv_color_t fields
+typedef struct {
+    uint8_t blue;
+    uint8_t green;
+    uint8_t red;
+} color_t;
+
+static color_t get_heatmap_color(float intensity)
+{
+    if (intensity < 0.0f) intensity = 0.0f;
+    if (intensity > 1.0f) intensity = 1.0f;
+    uint8_t r = 0, g = 0, b = 0;
+
+    if (intensity < 0.25f) {
+        float t = intensity / 0.25f;
+        b = (uint8_t)(t * 255.0f);
+    } else if (intensity < 0.5f) {
+        float t = (intensity - 0.25f) / 0.25f;
+        r = (uint8_t)(t * 255.0f);
+        b = (uint8_t)((1.0f - t) * 255.0f);
+    } else if (intensity < 0.75f) {
+        float t = (intensity - 0.5f) / 0.25f;
+        r = 255;
+        g = (uint8_t)(t * 255.0f);
+    } else {
+        float t = (intensity - 0.75f) / 0.25f;
+        r = 255;
+        g = 255;
+        b = (uint8_t)(t * 255.0f);
+    }
+    return (color_t){ .blue = b, .green = g, .red = r };
+}
+
+// What lv_canvas_set_px() does per call on an RGB565 canvas: look up the
+// buffer, switch on its colour format, find the pixel from the stride and
+// convert the colour. Kept out of line, as the LVGL call is.
+typedef struct {
+    int cf;
+    uint32_t stride;    // bytes
+    uint8_t *data;
+} canvas_t;
+
+enum { CF_RGB565 = 0x12, CF_RGB888 = 0x0f, CF_ARGB8888 = 0x10 };
+
+__attribute__((noinline)) static void canvas_set_px(canvas_t *c, int x, int y, color_t color, uint8_t opa)
+{
+    if (c->cf == CF_RGB565) {
+        uint16_t * px = (uint16_t *)(c->data + c->stride * y) + x;
+        *px = (uint16_t)(((color.red & 0xf8) << 8) | ((color.green & 0xfc) << 3) | (color.blue >> 3));
+    } else if (c->cf == CF_RGB888 || c->cf == CF_ARGB8888) {
+        uint32_t px_size = c->cf == CF_RGB888 ? 3 : 4;
+        uint8_t * px = c->data + c->stride * y + x * px_size;
+        px[0] = color.blue;
+        px[1] = color.green;
+        px[2] = color.red;
+        if (px_size == 4) px[3] = opa;
+    }
+}
+
+static int channel_diff(uint16_t a, uint16_t b)
+{
+    int dr = abs((a >> 11) - (b >> 11));
+    int dg = abs(((a >> 5) & 0x3f) - ((b >> 5) & 0x3f));
+    int db = abs((a & 0x1f) - (b & 0x1f));
+    return dr > dg ? (dr > db ? dr : db) : (dg > db ? dg : db);
+}
+
+int main(void)
+{
+    static uint16_t old_fb[W * H], new_fb[W * H];
+    static float intensity[W * H];     // column-major, as the FFT produces it
+    static uint8_t levels[W * H];
+    canvas_t canvas = { .cf = CF_RGB565, .stride = W * 2, .data = (uint8_t *)old_fb };
+
+    srand(7);
+    for (int i = 0; i < W * H; i++) intensity[i] = (float)(rand() % 1200) / 1000.0f - 0.1f;
+
+    // Old: colour computed and set through the canvas API per pixel
+    double t0 = host_now();
+    for (int f = 0; f < FRAMES; f++) {
+        for (int x = 0; x < W; x++) {
+            for (int y = 0; y < H; y++) canvas_set_px(&canvas, x, y, get_heatmap_color(intensity[x * H + y]), 255);
+        }
+        bench_sink += old_fb[f];
+    }
+    double t1 = host_now();
+
+    // New: quantize a column and blit it through the palette
+    spectro_set_palette(SPECTRO_PALETTE_HEATMAP);
+    for (int f = 0; f < FRAMES; f++) {
+        for (int x = 0; x < W; x++) {
+            uint8_t * col = levels + x * H;
+            for (int y = 0; y < H; y++) col[y] = spectro_quantize(intensity[x * H + y]);
+            spectro_blit_column(new_fb, W, x, col, H);
+        }
+        bench_sink += new_fb[f];
+    }
+    double t2 = host_now();
+
+    // Recolour from the stored levels, as a palette change does
+    for (int f = 0; f < FRAMES; f++) {
+        spectro_blit(new_fb, W, levels, W, H);
+        bench_sink += new_fb[f];
+    }
+    double t3 = host_now();
+
+    double px = (double)FRAMES * W * H;
+    printf("%dx%d spectrogram, %d frames\n", W, H, FRAMES);
+    printf("get_heatmap_color + set_px %8.1f Mpx/s\n", px / (t1 - t0) * 1e-6);
+    printf("quantize + column blit     %8.1f Mpx/s (%.1fx)\n", px / (t2 - t1) * 1e-6, (t1 - t0) / (t2 - t1));
+    printf("palette recolour           %8.1f Mpx/s (%.1fx)\n", px / (t3 - t2) * 1e-6, (t1 - t0) / (t3 - t2));
+
+    // Same picture: the 8-bit levels may move a colour by one palette step,
+    // which is at most a couple of RGB565 steps in one channel
+    int worst = 0, exact = 0;
+    for (int i = 0; i < W * H; i++) {
+        int d = channel_diff(old_fb[i], new_fb[i]);
+        if (d > worst) worst = d;
+        exact += d == 0;
+    }
+    printf("identical pixels %.1f%%, largest channel difference %d\n", 100.0 * exact / (W * H), worst);
+    CHECK(worst <= 2);
+
+    // On the palette levels themselves the heatmap matches exactly
+    int level_bad = 0;
+    for (int i = 0; i < 256; i++) {
+        uint8_t level = (uint8_t)i;
+        float t = (float)i / 255.0f;
+        canvas_set_px(&canvas, 0, 0, get_heatmap_color(t), 255);
+        spectro_blit_column(new_fb, W, 0, &level, 1);
+        level_bad += old_fb[0] != new_fb[0];
+    }
+    CHECK(level_bad == 0);
+    return test_result("bench_blit");
+}
@@ -0,0 +1,182 @@
+// Spectrogram FFT cost and accuracy: the table-driven real-input FFT in
+// fft.c against the complex compute_fft and per-sample cosf() window the
+// recorder spectrogram used before it.
+#include <math.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include "host_test.h"
+#include "fft.h"
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+#define COLUMNS 640     // one recorder spectrogram, one FFT per pixel column
+
+// The removed routine, unchanged
+static void compute_fft(float *vReal, float *vImag, uint16_t n)
+{
+    uint16_t j = 0;
+    for (uint16_t i = 0; i < n - 1; i++) {
+        if (i < j) {
+            float tempReal = vReal[i];
+            float tempImag = vImag[i];
+            vReal[i] = vReal[j];
+            vImag[i] = vImag[j];
+            vReal[j] = tempReal;
+            vImag[j] = tempImag;
+        }
+        uint16_t k = n / 2;
+        while (k <= j) {
+            j -= k;
+            k /= 2;
+        }
+        j += k;
+    }
+    for (uint16_t step = 1; step < n; step *= 2) {
+        float arg = M_PI / step;
+        float c = cosf(arg);
+        float s = -sinf(arg);
+        float uReal = 1.0f;
+        float uImag = 0.0f;
+        for (uint16_t j2 = 0; j2 < step; j2++) {
+            for (uint16_t i = j2; i < n; i += 2 * step) {
+                float tReal = uReal * vReal[i + step] - uImag * vImag[i + step];
+                float tImag = uReal * vImag[i + step] + uImag * vReal[i + step];
+                vReal[i + step] = vReal[i] - tReal;
+                vImag[i + step] = vImag[i] - tImag;
+                vReal[i] += tReal;
+                vImag[i] += tImag;
+            }
+            float tempReal = uReal * c - uImag * s;
+            uImag = uReal * s + uImag * c;
+            uReal = tempReal;
+        }
+    }
+}
+
+// One old spectrogram column: window, transform, magnitudes
+static void old_column(const float *in, float *re, float *im, float *mags, int n)
+{
+    for (int i = 0; i < n; i++) {
+        float mult = 0.5f * (1.0f - cosf(2.0f * M_PI * i / (n - 1)));
+        re[i] = in[i] * mult;
+        im[i] = 0.0f;
+    }
+    compute_fft(re, im, (uint16_t)n);
+    for (int i = 0; i < n / 2; i++) mags[i] = sqrtf(re[i] * re[i] + im[i] * im[i]);
+}
+
+static void new_column(const fft_plan_t *p, const float *in, float *data, float *mags)
+{
+    for (int i = 0; i < p->n; i++) data[i] = in[i];
+    fft_magnitude(p, data, mags);
+}
+
+// Largest bin error against a double DFT, relative to the largest bin
+static void dft_errors(int n, const float *x, double *old_err, double *new_err)
+{
+    float * re = malloc(n * sizeof(float));
+    float * im = malloc(n * sizeof(float));
+    float * packed = malloc(n * sizeof(float));
+    double peak = 0.0, eo = 0.0, en = 0.0;
+
+    for (int i = 0; i < n; i++) {
+        re[i] = packed[i] = x[i];
+        im[i] = 0.0f;
+    }
+    compute_fft(re, im, (uint16_t)n);
+    fft_real(fft_plan_get(n), packed);
+
+    for (int k = 0; k <= n / 2; k++) {
+        double sr = 0.0, si = 0.0;
+        for (int i = 0; i < n; i++) {
+            double a = 2.0 * M_PI * (double)((int64_t)k * i % n) / n;
+            sr += x[i] * cos(a);
+            si -= x[i] * sin(a);
+        }
+        double nr, ni;
+        if (k == 0) { nr = packed[0]; ni = 0.0; }
+        else if (k == n / 2) { nr = packed[1]; ni = 0.0; }
+        else { nr = packed[2 * k]; ni = packed[2 * k + 1]; }
+        peak = fmax(peak, hypot(sr, si));
+        eo = fmax(eo, hypot(re[k] - sr, im[k] - si));
+        en = fmax(en, hypot(nr - sr, ni - si));
+    }
+    *old_err = eo / peak;
+    *new_err = en / peak;
+    free(re);
+    free(im);
+    free(packed);
+}
+
+int main(void)
+{
+    static const int sizes[] = { 256, 1024, 4096 };
+    srand(99);
+
+    printf("%d columns per spectrogram\n", COLUMNS);
+    printf("size   old us/column   new us/column   speedup   largest magnitude difference\n");
+    for (size_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++) {
+        int n = sizes[s];
+        const fft_plan_t * p = fft_plan_get(n);
+        CHECK(p != NULL);
+        if (!p) continue;
+
+        // Recorder-like input: a few tones plus noise at 16-bit scale
+        int total = n + COLUMNS * 16;
+        float * in = malloc(total * sizeof(float));
+        for (int i = 0; i < total; i++) {
+            in[i] = 8000.0f * sinf(0.05f * i) + 3000.0f * sinf(0.71f * i) +
+                    (float)(rand() % 2001 - 1000);
+        }
+        float * re = malloc(n * sizeof(float));
+        float * im = malloc(n * sizeof(float));
+        float * data = malloc(n * sizeof(float));
+        float * old_mags = malloc(n / 2 * sizeof(float));
+        float * new_mags = malloc(n / 2 * sizeof(float));
+
+        double t0 = host_now();
+        for (int c = 0; c < COLUMNS; c++) {
+            old_column(in + c * 16, re, im, old_mags, n);
+            bench_sink += old_mags[c % (n / 2)];
+        }
+        double t1 = host_now();
+        for (int c = 0; c < COLUMNS; c++) {
+            new_column(p, in + c * 16, data, new_mags);
+            bench_sink += new_mags[c % (n / 2)];
+        }
+        double t2 = host_now();
+
+        // Both paths must draw the same picture: compare the last column
+        float peak = 0.0f, diff = 0.0f;
+        for (int k = 0; k < n / 2; k++) {
+            peak = fmaxf(peak, old_mags[k]);
+            diff = fmaxf(diff, fabsf(old_mags[k] - new_mags[k]));
+        }
+        printf("%5d %15.1f %15.1f %8.1fx %14.2e of peak\n", n, (t1 - t0) * 1e6 / COLUMNS,
+               (t2 - t1) * 1e6 / COLUMNS, (t1 - t0) / (t2 - t1), diff / peak);
+        CHECK(diff / peak < 1e-4f);
+
+        free(in);
+        free(re);
+        free(im);
+        free(data);
+        free(old_mags);
+        free(new_mags);
+    }
+
+    printf("size   error vs double DFT: old        new\n");
+    for (int bits = FFT_MIN_BITS; bits <= FFT_MAX_BITS; bits++) {
+        int n = 1 << bits;
+        float * x = malloc(n * sizeof(float));
+        for (int i = 0; i < n; i++) x[i] = (float)(rand() % 65536 - 32768);
+        double old_err, new_err;
+        dft_errors(n, x, &old_err, &new_err);
+        printf("%5d %27.2e %10.2e\n", n, old_err, new_err);
+        CHECK(new_err < 1e-5);
+        CHECK(new_err <= old_err);
+        free(x);
+    }
+    return test_result("bench_fft");
+}
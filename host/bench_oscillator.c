@@ -0,0 +1,125 @@
+// Oscillator cost and aliasing: the band-limited wavetables against the
+// per-sample sinf() and naive square/saw the synth used before them.
+#include <math.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include "host_test.h"
+#include "wavetable.h"
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+#define RATE    16000.0f
+#define BLOCK   256
+#define VOICES  16
+#define BLOCKS  2000
+#define DFT_N   4096
+
+// The old audio_task inner loop, minus the envelope: every voice is visited
+// per sample and the waveform is picked by a branch
+typedef struct {
+    float phase;
+    float freq;
+} old_voice_t;
+
+static void old_render(old_voice_t *v, int voices, int wave, float *out, int n)
+{
+    for (int i = 0; i < n; i++) {
+        float mixed = 0.0f;
+        for (int k = 0; k < voices; k++) {
+            float s = 0.0f;
+            if (wave == 0) s = sinf(2.0f * (float)M_PI * v[k].phase);
+            else if (wave == 1) s = v[k].phase < 0.5f ? 1.0f : -1.0f;
+            else if (wave == 2) s = 2.0f * v[k].phase - 1.0f;
+            mixed += s;
+            v[k].phase += v[k].freq / RATE;
+            if (v[k].phase >= 1.0f) v[k].phase -= 1.0f;
+        }
+        out[i] = mixed;
+    }
+}
+
+// The same work the block renderer in synth.c does per voice
+static void wt_render(uint32_t *phase, const uint32_t *inc, int voices, int wave, float *out, int n)
+{
+    for (int i = 0; i < n; i++) out[i] = 0.0f;
+    for (int k = 0; k < voices; k++) {
+        const float *table = wavetable_select(wave, inc[k]);
+        uint32_t p = phase[k];
+        for (int i = 0; i < n; i++) out[i] += wavetable_read(table, p + (uint32_t)i * inc[k]);
+        phase[k] = p + (uint32_t)n * inc[k];
+    }
+}
+
+// Share of the power outside the harmonics of bin `fund`, in dB. With a
+// prime bin number, harmonics folded back from above Nyquist never land on
+// a harmonic bin, so this is the aliasing.
+static double alias_db(const float *x, int fund)
+{
+    double harm = 0.0, other = 0.0;
+    for (int k = 1; k < DFT_N / 2; k++) {
+        double re = 0.0, im = 0.0;
+        for (int i = 0; i < DFT_N; i++) {
+            double a = 2.0 * M_PI * (double)((int64_t)k * i % DFT_N) / DFT_N;
+            re += x[i] * cos(a);
+            im -= x[i] * sin(a);
+        }
+        double p = re * re + im * im;
+        if (k % fund == 0) harm += p;
+        else other += p;
+    }
+    return 10.0 * log10(other / harm);
+}
+
+int main(void)
+{
+    CHECK(wavetable_init());
+    static const char * const names[] = { "sine", "square", "saw" };
+    static float out[BLOCK];
+
+    printf("%d voices, %d-sample blocks at %.0f Hz\n", VOICES, BLOCK, RATE);
+    printf("wave     old ns/sample/voice   wavetable   speedup\n");
+    for (int wave = 0; wave < WT_NUM_WAVES; wave++) {
+        old_voice_t ov[VOICES];
+        uint32_t phase[VOICES], inc[VOICES];
+        for (int k = 0; k < VOICES; k++) {
+            ov[k].phase = 0.0f;
+            ov[k].freq = 261.63f * powf(2.0f, (float)k / 12.0f);
+            phase[k] = 0;
+            inc[k] = wavetable_phase_inc(ov[k].freq, RATE);
+        }
+
+        double t0 = host_now();
+        for (int b = 0; b < BLOCKS; b++) {
+            old_render(ov, VOICES, wave, out, BLOCK);
+            bench_sink += out[b % BLOCK];
+        }
+        double t1 = host_now();
+        for (int b = 0; b < BLOCKS; b++) {
+            wt_render(phase, inc, VOICES, wave, out, BLOCK);
+            bench_sink += out[b % BLOCK];
+        }
+        double t2 = host_now();
+
+        double per = 1e9 / ((double)BLOCKS * BLOCK * VOICES);
+        printf("%-8s %10.2f %20.2f %9.1fx\n", names[wave], (t1 - t0) * per, (t2 - t1) * per,
+               (t1 - t0) / (t2 - t1));
+    }
+
+    // A saw high enough that its naive form folds many harmonics back
+    int fund = 509;
+    float freq = RATE * (float)fund / DFT_N;
+    static float naive[DFT_N], table[DFT_N];
+    old_voice_t ov = { .phase = 0.0f, .freq = freq };
+    old_render(&ov, 1, 2, naive, DFT_N);
+    uint32_t phase = 0, inc = wavetable_phase_inc(freq, RATE);
+    wt_render(&phase, &inc, 1, 2, table, DFT_N);
+
+    double naive_db = alias_db(naive, fund);
+    double table_db = alias_db(table, fund);
+    printf("saw at %.0f Hz, power off the harmonics: naive %.1f dB, wavetable %.1f dB\n",
+           freq, naive_db, table_db);
+    CHECK(table_db < naive_db - 20.0);
+    return test_result("bench_oscillator");
+}
@@ -0,0 +1,217 @@
+// Pen-up stroke clean-up on synthetic handwriting: point counts before and
+// after stroke_simplify at the editor's width-dependent tolerance, the
+// largest deviation it leaves, its cost, and what stroke_smooth adds back.
+// Strokes captured on the board (STROKE_DUMP in notes_app.c) are read from
+// the files named on the command line and measured the same way.
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include "host_test.h"
+#include "stroke_simplify.h"
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+#define STROKES      300        // per kind
+#define MAX_PTS      4096
+#define READ_PERIOD  0.033f     // s between indev reads (CONFIG_LV_DEF_REFR_PERIOD)
+#define SMOOTH_STEPS 8          // STROKE_SMOOTH_STEPS in notes_app.c
+
+typedef enum { KIND_LOOPS = 0, KIND_SWEEPS, KIND_STRAIGHT, KIND_COUNT } kind_t;
+
+static float frand(float lo, float hi)
+{
+    return lo + (hi - lo) * (float)rand() / (float)RAND_MAX;
+}
+
+// Pen position at parameter t in [0, 1]
+static void pen_at(kind_t kind, const float *k, float t, float *x, float *y)
+{
+    switch (kind) {
+        case KIND_LOOPS: {
+            // Cursive loops: a trochoid drifting to the right
+            float a = t * k[0] * 2.0f * (float)M_PI;
+            *x = k[1] * a / (2.0f * (float)M_PI) * 1.2f - k[1] * sinf(a);
+            *y = k[1] * cosf(a);
+            break;
+        }
+        case KIND_SWEEPS: {
+            float a = k[1] * t;
+            *x = k[0] * cosf(a);
+            *y = k[0] * sinf(a);
+            break;
+        }
+        default:
+            *x = k[0] * t * cosf(k[1]);
+            *y = k[0] * t * sinf(k[1]);
+            break;
+    }
+}
+
+// Samples one stroke the way the editor sees it: the pen moves at a steady
+// speed, the indev is read every READ_PERIOD, touch coordinates jitter by
+// up to a pixel and the editor skips points less than 2 px from the last
+static uint32_t make_stroke(kind_t kind, lv_point_precise_t *pts)
+{
+    float k[2];
+    switch (kind) {
+        case KIND_LOOPS:  k[0] = frand(3.0f, 8.0f); k[1] = frand(15.0f, 40.0f); break;
+        case KIND_SWEEPS: k[0] = frand(80.0f, 300.0f); k[1] = frand(1.0f, 3.1f); break;
+        default:          k[0] = frand(100.0f, 500.0f); k[1] = frand(0.0f, 6.28f); break;
+    }
+    float step = frand(60.0f, 300.0f) * READ_PERIOD;
+
+    uint32_t n = 0;
+    float px, py, walked = 0.0f, next = 0.0f;
+    pen_at(kind, k, 0.0f, &px, &py);
+    for (int i = 0; i <= 20000 && n < MAX_PTS; i++) {
+        float x, y;
+        pen_at(kind, k, (float)i / 20000.0f, &x, &y);
+        walked += hypotf(x - px, y - py);
+        px = x;
+        py = y;
+        if (walked < next && i < 20000) continue;
+        next += step;
+
+        int lx = (int)lrintf(x + frand(-1.0f, 1.0f)) + 400;
+        int ly = (int)lrintf(y + frand(-1.0f, 1.0f)) + 300;
+        if (n > 0 && abs(pts[n - 1].x - lx) < 2 && abs(pts[n - 1].y - ly) < 2) continue;
+        pts[n].x = lx;
+        pts[n].y = ly;
+        n++;
+    }
+    return n;
+}
+
+static float seg_dist(const lv_point_precise_t *p, const lv_point_precise_t *a, const lv_point_precise_t *b)
+{
+    float dx = (float)(b->x - a->x), dy = (float)(b->y - a->y);
+    float px = (float)(p->x - a->x), py = (float)(p->y - a->y);
+    float len2 = dx * dx + dy * dy;
+    float t = len2 > 0.0f ? (px * dx + py * dy) / len2 : 0.0f;
+    t = t < 0.0f ? 0.0f : t > 1.0f ? 1.0f : t;
+    return hypotf(px - t * dx, py - t * dy);
+}
+
+// Largest distance from a raw point to the simplified polyline
+static float max_deviation(const lv_point_precise_t *raw, uint32_t n, const lv_point_precise_t *s, uint32_t m)
+{
+    float worst = 0.0f;
+    for (uint32_t i = 0; i < n; i++) {
+        float best = m == 1 ? hypotf((float)(raw[i].x - s[0].x), (float)(raw[i].y - s[0].y)) : INFINITY;
+        for (uint32_t j = 0; j + 1 < m; j++) best = fminf(best, seg_dist(&raw[i], &s[j], &s[j + 1]));
+        worst = fmaxf(worst, best);
+    }
+    return worst;
+}
+
+static const int widths[] = { 2, 5, 10, 20 };
+
+// Reads the console output of STROKE_DUMP: a "stroke <width>" line, then
+// one "x y" line per point. Other lines are ignored, so a whole console log
+// can be used. Returns the number of points, or 0 at the end of the file.
+static uint32_t read_stroke(FILE *f, lv_point_precise_t *pts)
+{
+    char line[128];
+    int width;
+    while (fgets(line, sizeof(line), f)) {
+        if (sscanf(line, "stroke %d", &width) == 1) break;
+    }
+    uint32_t n = 0;
+    long pos = ftell(f);
+    int x, y;
+    while (n < MAX_PTS && fgets(line, sizeof(line), f) && sscanf(line, "%d %d", &x, &y) == 2) {
+        pts[n].x = x;
+        pts[n].y = y;
+        n++;
+        pos = ftell(f);
+    }
+    // The line that ended the stroke may start the next one
+    fseek(f, pos, SEEK_SET);
+    return n;
+}
+
+static void bench_captured(const char *path)
+{
+    static lv_point_precise_t raw[MAX_PTS], pts[MAX_PTS];
+    FILE * f = fopen(path, "r");
+    CHECK(f != NULL);
+    if (!f) return;
+
+    printf("%s\n", path);
+    for (size_t w = 0; w < sizeof(widths) / sizeof(widths[0]); w++) {
+        float tol = fmaxf(1.0f, (float)widths[w] / 4.0f);
+        float worst_dev = 0.0f;
+        long strokes = 0, raw_total = 0, simple_total = 0;
+        rewind(f);
+        uint32_t n;
+        while ((n = read_stroke(f, raw)) > 0) {
+            memcpy(pts, raw, n * sizeof(lv_point_precise_t));
+            uint32_t m = stroke_simplify(pts, n, tol);
+            CHECK(m >= (n < 2 ? n : 2) && m <= n);
+            worst_dev = fmaxf(worst_dev, max_deviation(raw, n, pts, m));
+            strokes++;
+            raw_total += n;
+            simple_total += m;
+        }
+        CHECK(strokes > 0);
+        if (!strokes) break;
+        printf("%5d %5.2f  %ld strokes  %ld -> %ld points  %5.1fx  max dev %.2f\n", widths[w], tol,
+               strokes, raw_total, simple_total, (double)raw_total / simple_total, worst_dev);
+        CHECK(worst_dev <= tol + 1e-3f);
+    }
+    fclose(f);
+}
+
+int main(int argc, char **argv)
+{
+    static const char * const kind_names[] = { "loops", "sweeps", "straight" };
+    static lv_point_precise_t raw[MAX_PTS], pts[MAX_PTS];
+    lv_point_precise_t * smooth = malloc(stroke_smooth_max(MAX_PTS, SMOOTH_STEPS) * sizeof(lv_point_precise_t));
+
+    printf("%d strokes per kind; raw -> simplified point ratio (smoothed in brackets)\n", STROKES);
+    printf("width  tol    %-16s %-16s %-16s max dev   us/stroke\n", kind_names[0], kind_names[1], kind_names[2]);
+    for (size_t w = 0; w < sizeof(widths) / sizeof(widths[0]); w++) {
+        float tol = fmaxf(1.0f, (float)widths[w] / 4.0f);
+        float worst_dev = 0.0f;
+        double time = 0.0;
+        long strokes = 0;
+        printf("%5d %5.2f ", widths[w], tol);
+
+        for (int kind = 0; kind < KIND_COUNT; kind++) {
+            srand(1000 + kind);
+            long raw_total = 0, simple_total = 0, smooth_total = 0;
+            for (int s = 0; s < STROKES; s++) {
+                uint32_t n = make_stroke((kind_t)kind, raw);
+                memcpy(pts, raw, n * sizeof(lv_point_precise_t));
+
+                double t0 = host_now();
+                uint32_t m = stroke_simplify(pts, n, tol);
+                time += host_now() - t0;
+                strokes++;
+
+                CHECK(m >= (n < 2 ? n : 2) && m <= n);
+                CHECK(pts[0].x == raw[0].x && pts[0].y == raw[0].y);
+                CHECK(pts[m - 1].x == raw[n - 1].x && pts[m - 1].y == raw[n - 1].y);
+                worst_dev = fmaxf(worst_dev, max_deviation(raw, n, pts, m));
+
+                uint32_t k = stroke_smooth(pts, m, tol * 0.5f, SMOOTH_STEPS, smooth);
+                CHECK(k >= m && k <= stroke_smooth_max(m, SMOOTH_STEPS));
+
+                raw_total += n;
+                simple_total += m;
+                smooth_total += k;
+            }
+            printf(" %5.1fx (%4.1fx)    ", (double)raw_total / simple_total, (double)raw_total / smooth_total);
+        }
+        printf("%6.2f %10.1f\n", worst_dev, time * 1e6 / strokes);
+        // Integer points and float distances: allow rounding at the edge
+        CHECK(worst_dev <= tol + 1e-3f);
+    }
+    free(smooth);
+
+    if (argc < 2) printf("No captured strokes given\n");
+    for (int i = 1; i < argc; i++) bench_captured(argv[i]);
+    return test_result("bench_simplify");
+}
@@ -0,0 +1,114 @@
+// Block renderer throughput: N sustained voices rendered for M blocks
+// through synth_render, next to the per-sample voice loop it replaced.
+#include <math.h>
+#include <string.h>
+#include "host_test.h"
+#include "synth.h"
+#include "synth_events.h"
+#include "wavetable.h"
+
+#define RATE    16000.0f
+#define BLOCKS  1000
+
+// The pre-block audio_task loop: every voice visited per sample, with the
+// ADSR switch evaluated each time (square wave, 0.1 s attack)
+typedef struct {
+    float phase;
+    float freq;
+    int env_state;      // 1 attack, 2 decay, 3 sustain
+    float env_val;
+} old_voice_t;
+
+static void old_render(old_voice_t *v, int voices, float *out, int n)
+{
+    float a_rate = 1.0f / (0.1f * RATE);
+    float d_rate = 0.5f / (0.1f * RATE);
+    for (int i = 0; i < n; i++) {
+        float mixed = 0.0f;
+        for (int k = 0; k < voices; k++) {
+            switch (v[k].env_state) {
+                case 1:
+                    v[k].env_val += a_rate;
+                    if (v[k].env_val >= 1.0f) { v[k].env_val = 1.0f; v[k].env_state = 2; }
+                    break;
+                case 2:
+                    v[k].env_val -= d_rate;
+                    if (v[k].env_val <= 0.5f) { v[k].env_val = 0.5f; v[k].env_state = 3; }
+                    break;
+                default:
+                    v[k].env_val = 0.5f;
+                    break;
+            }
+            mixed += (v[k].phase < 0.5f ? 1.0f : -1.0f) * v[k].env_val;
+            v[k].phase += v[k].freq / RATE;
+            if (v[k].phase >= 1.0f) v[k].phase -= 1.0f;
+        }
+        out[i] = mixed * 0.2f;
+    }
+}
+
+static float note_freq(int k)
+{
+    return 130.81f * powf(2.0f, (float)(k % 36) / 12.0f);
+}
+
+int main(void)
+{
+    static const int counts[] = { 5, 16, 32, 64 };
+    static float out[SYNTH_BLOCK_SIZE];
+    double deadline_us = SYNTH_BLOCK_SIZE / RATE * 1e6;
+
+    CHECK(wavetable_init());
+    printf("%d-sample blocks at %.0f Hz (deadline %.0f us), %d blocks per run\n",
+           SYNTH_BLOCK_SIZE, RATE, deadline_us, BLOCKS);
+    printf("voices  old us/block  block us/block  ns/voice-sample  speedup  x real time\n");
+
+    for (size_t c = 0; c < sizeof(counts) / sizeof(counts[0]); c++) {
+        int voices = counts[c];
+
+        old_voice_t ov[64];
+        for (int k = 0; k < voices; k++) {
+            ov[k] = (old_voice_t){ .phase = 0.0f, .freq = note_freq(k), .env_state = 1, .env_val = 0.0f };
+        }
+        double t0 = host_now();
+        for (int b = 0; b < BLOCKS; b++) {
+            old_render(ov, voices, out, SYNTH_BLOCK_SIZE);
+            bench_sink += out[b % SYNTH_BLOCK_SIZE];
+        }
+        double old_s = host_now() - t0;
+
+        synth_init(RATE);
+        for (int k = 0; k < voices; k++) {
+            synth_event_t ev = {
+                .time_us = 0,
+                .type = SYNTH_EV_NOTE_ON,
+                .note_idx = (int16_t)k,
+                .value = note_freq(k),
+            };
+            CHECK(synth_events_push(&ev));
+        }
+        bool audible = false, finite = true;
+        t0 = host_now();
+        for (int b = 0; b < BLOCKS; b++) {
+            synth_render(out, SYNTH_BLOCK_SIZE, (int64_t)b * 16000, NULL, 0);
+            bench_sink += out[b % SYNTH_BLOCK_SIZE];
+            audible |= out[SYNTH_BLOCK_SIZE - 1] != 0.0f;
+            finite &= isfinite(out[0]) != 0;
+        }
+        double new_s = host_now() - t0;
+        CHECK(audible);
+        CHECK(finite);
+
+        // Release everything so the next run starts from a free pool
+        for (int k = 0; k < voices; k++) {
+            synth_event_t ev = { .type = SYNTH_EV_NOTE_OFF, .note_idx = (int16_t)k };
+            synth_events_push(&ev);
+        }
+
+        double block_us = new_s / BLOCKS * 1e6;
+        printf("%6d %13.1f %15.1f %16.2f %8.1fx %11.0f\n", voices, old_s / BLOCKS * 1e6, block_us,
+               new_s * 1e9 / ((double)BLOCKS * SYNTH_BLOCK_SIZE * voices), old_s / new_s,
+               deadline_us / block_us);
+    }
+    return test_result("bench_voices");
+}
@@ -0,0 +1,34 @@
+#pragma once
+
+// Shared helpers for the host tests and benchmarks. CHECK prints and counts
+// failures instead of stopping, and test_result() turns the count into the
+// exit code ctest looks at.
+
+#include <stdio.h>
+#include <time.h>
+
+static int test_failures = 0;
+
+#define CHECK(cond) do { \
+    if (!(cond)) { \
+        printf("%s:%d: CHECK failed: %s\n", __FILE__, __LINE__, #cond); \
+        test_failures++; \
+    } \
+} while (0)
+
+static inline int test_result(const char *name)
+{
+    if (test_failures) printf("%s: %d check(s) failed\n", name, test_failures);
+    else printf("%s: passed\n", name);
+    return test_failures ? 1 : 0;
+}
+
+static inline double host_now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+// Keeps the optimizer from dropping a benchmark loop whose result is unused
+static volatile float bench_sink;
@@ -0,0 +1,25 @@
+#pragma once
+
+// Just enough of FreeRTOS for the host tests to build the modules in main/
+// that hand work to a task through a queue. Tasks are pthreads and queues
+// are a mutex and two condition variables; see freertos_shim.c.
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+typedef uint32_t TickType_t;
+typedef int BaseType_t;
+typedef unsigned UBaseType_t;
+typedef void * TaskHandle_t;
+typedef void (*TaskFunction_t)(void *);
+
+#define pdTRUE                  1
+#define pdFALSE                 0
+#define pdPASS                  pdTRUE
+#define portMAX_DELAY           0xffffffffu
+#define portTICK_PERIOD_MS      1
+#define pdMS_TO_TICKS(ms)       ((TickType_t)(ms))
+#define tskNO_AFFINITY          0x7fffffff
+#define portNUM_PROCESSORS      2
+#define configMAX_TASK_NAME_LEN 16
@@ -0,0 +1,17 @@
+#pragma once
+
+#include "freertos/FreeRTOS.h"
+
+typedef struct host_queue * QueueHandle_t;
+
+// Timeouts are in ticks of 1 ms; portMAX_DELAY waits for ever
+QueueHandle_t xQueueCreate(UBaseType_t length, UBaseType_t item_size);
+BaseType_t xQueueSend(QueueHandle_t q, const void *item, TickType_t timeout);
+BaseType_t xQueueReceive(QueueHandle_t q, void *item, TickType_t timeout);
+
+// Host only: while paused, receivers wait as if the queue were empty. Lets
+// a test stand in for a slow consumer, e.g. a card that stalls on a write.
+void host_queue_pause(QueueHandle_t q, bool paused);
+// Host only: the queue made by the latest xQueueCreate, for reaching a
+// module's private queue after its init call
+extern QueueHandle_t host_last_queue;
@@ -0,0 +1,141 @@
+// pthread stand-ins for the FreeRTOS queue and task calls used by the
+// modules under test, and for task_topology_start().
+#include <errno.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/queue.h"
+#include "freertos/task.h"
+#include "task_topology.h"
+
+struct host_queue {
+    pthread_mutex_t lock;
+    pthread_cond_t not_empty;
+    pthread_cond_t not_full;
+    UBaseType_t length;
+    UBaseType_t item_size;
+    UBaseType_t head;
+    UBaseType_t count;
+    bool paused;
+    uint8_t *items;
+};
+
+QueueHandle_t host_last_queue = NULL;
+
+static void deadline(struct timespec *ts, TickType_t ticks)
+{
+    clock_gettime(CLOCK_REALTIME, ts);
+    ts->tv_sec += ticks / 1000;
+    ts->tv_nsec += (long)(ticks % 1000) * 1000000L;
+    if (ts->tv_nsec >= 1000000000L) {
+        ts->tv_sec++;
+        ts->tv_nsec -= 1000000000L;
+    }
+}
+
+// Waits on cond until ready() holds or the timeout runs out
+static bool wait_for(QueueHandle_t q, pthread_cond_t *cond, bool (*ready)(QueueHandle_t), TickType_t timeout)
+{
+    struct timespec ts;
+    if (timeout != portMAX_DELAY) deadline(&ts, timeout);
+    while (!ready(q)) {
+        if (timeout == 0) return false;
+        if (timeout == portMAX_DELAY) pthread_cond_wait(cond, &q->lock);
+        else if (pthread_cond_timedwait(cond, &q->lock, &ts) == ETIMEDOUT) return ready(q);
+    }
+    return true;
+}
+
+static bool has_room(QueueHandle_t q) { return q->count < q->length; }
+static bool has_item(QueueHandle_t q) { return q->count > 0 && !q->paused; }
+
+QueueHandle_t xQueueCreate(UBaseType_t length, UBaseType_t item_size)
+{
+    QueueHandle_t q = calloc(1, sizeof(*q));
+    if (!q) return NULL;
+    q->items = calloc(length, item_size);
+    if (!q->items) {
+        free(q);
+        return NULL;
+    }
+    q->length = length;
+    q->item_size = item_size;
+    pthread_mutex_init(&q->lock, NULL);
+    pthread_cond_init(&q->not_empty, NULL);
+    pthread_cond_init(&q->not_full, NULL);
+    host_last_queue = q;
+    return q;
+}
+
+BaseType_t xQueueSend(QueueHandle_t q, const void *item, TickType_t timeout)
+{
+    pthread_mutex_lock(&q->lock);
+    bool ok = wait_for(q, &q->not_full, has_room, timeout);
+    if (ok) {
+        memcpy(q->items + (size_t)((q->head + q->count) % q->length) * q->item_size, item, q->item_size);
+        q->count++;
+        pthread_cond_signal(&q->not_empty);
+    }
+    pthread_mutex_unlock(&q->lock);
+    return ok ? pdTRUE : pdFALSE;
+}
+
+BaseType_t xQueueReceive(QueueHandle_t q, void *item, TickType_t timeout)
+{
+    pthread_mutex_lock(&q->lock);
+    bool ok = wait_for(q, &q->not_empty, has_item, timeout);
+    if (ok) {
+        memcpy(item, q->items + (size_t)q->head * q->item_size, q->item_size);
+        q->head = (q->head + 1) % q->length;
+        q->count--;
+        pthread_cond_signal(&q->not_full);
+    }
+    pthread_mutex_unlock(&q->lock);
+    return ok ? pdTRUE : pdFALSE;
+}
+
+void host_queue_pause(QueueHandle_t q, bool paused)
+{
+    pthread_mutex_lock(&q->lock);
+    q->paused = paused;
+    pthread_cond_broadcast(&q->not_empty);
+    pthread_mutex_unlock(&q->lock);
+}
+
+void vTaskDelay(TickType_t ticks)
+{
+    struct timespec ts = { .tv_sec = ticks / 1000, .tv_nsec = (long)(ticks % 1000) * 1000000L };
+    nanosleep(&ts, NULL);
+}
+
+typedef struct {
+    TaskFunction_t fn;
+    void *arg;
+} task_start_t;
+
+static void * task_entry(void *p)
+{
+    task_start_t start = *(task_start_t *)p;
+    free(p);
+    start.fn(start.arg);
+    return NULL;
+}
+
+// Cores and priorities mean nothing here; every task is a detached thread
+bool task_topology_start(task_id_t id, TaskFunction_t fn, void *arg)
+{
+    (void)id;
+    task_start_t * start = malloc(sizeof(*start));
+    if (!start) return false;
+    start->fn = fn;
+    start->arg = arg;
+    pthread_t thread;
+    if (pthread_create(&thread, NULL, task_entry, start) != 0) {
+        free(start);
+        return false;
+    }
+    pthread_detach(thread);
+    return true;
+}
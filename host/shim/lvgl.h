@@ -0,0 +1,33 @@
+#pragma once
+
+// The few LVGL types the portable drawing helpers and the note codec in
+// main/ use, so they build on the host without LVGL. Matches LVGL 9 with
+// LV_USE_FLOAT off.
+
+#include <stdint.h>
+
+typedef int32_t lv_value_precise_t;
+
+typedef struct {
+    lv_value_precise_t x;
+    lv_value_precise_t y;
+} lv_point_precise_t;
+
+typedef struct {
+    uint8_t blue;
+    uint8_t green;
+    uint8_t red;
+} lv_color_t;
+
+typedef struct _lv_obj_t lv_obj_t;
+
+static inline lv_color_t lv_color_make(uint8_t r, uint8_t g, uint8_t b)
+{
+    lv_color_t c = { .blue = b, .green = g, .red = r };
+    return c;
+}
+
+static inline lv_color_t lv_color_black(void)
+{
+    return lv_color_make(0, 0, 0);
+}
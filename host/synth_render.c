@@ -0,0 +1,339 @@
+// Offline renderer for the synth core. Plays a scripted scene through
+// audio_engine_render exactly as audio_task would, writes the result as a
+// WAV file and/or compares it against a golden file, and reports how much
+// faster than real time the render ran.
+//
+//   synth_render [-o out.wav] [-g golden.wav] [-t tolerance] scene.txt
+//
+// Scene files hold one command per line, '#' starts a comment:
+//   rate 16000            sample rate (default 16000)
+//   block 256             samples per audio_engine_render call
+//   length 2.5            seconds to render
+//   <time> on <note>      key press, note 0 = C4 (UI note indices)
+//   <time> off <note>
+//   <time> param <name> <value>   waveform, attack, decay, sustain,
+//                                 release or volume
+//   <time> seq <mode>     off, pattern, up, down or updown
+//   <time> bpm <value>
+//   <time> step <step> <note|rest>
+//   <time> hold <note> / <time> unhold <note>   arpeggiator keys
+//   <time> fx <node> <on|off>     node name as shown on the diag screen
+// Times are in seconds. Key and parameter events go through the synth event
+// queue with their timestamp; the rest are UI-side writes that take effect
+// from the block they fall in, as on the device.
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <time.h>
+#include "audio_engine.h"
+#include "sequencer.h"
+#include "synth.h"
+#include "synth_events.h"
+#include "wav_io.h"
+
+#define SCENE_MAX_EVENTS 4096
+
+typedef enum {
+    CMD_NOTE_ON = 0,
+    CMD_NOTE_OFF,
+    CMD_PARAM,
+    CMD_SEQ_MODE,
+    CMD_SEQ_BPM,
+    CMD_SEQ_STEP,
+    CMD_HOLD,
+    CMD_UNHOLD,
+    CMD_FX
+} scene_cmd_t;
+
+typedef struct {
+    int64_t time_us;
+    int line;           // keeps events at the same time in file order
+    scene_cmd_t cmd;
+    int a;
+    float value;
+    char name[32];
+} scene_event_t;
+
+typedef struct {
+    int sample_rate;
+    int block;
+    float length;
+    int count;
+    scene_event_t events[SCENE_MAX_EVENTS];
+} scene_t;
+
+static const char * const param_names[] = {
+    [SYNTH_PARAM_WAVEFORM] = "waveform",
+    [SYNTH_PARAM_ATTACK] = "attack",
+    [SYNTH_PARAM_DECAY] = "decay",
+    [SYNTH_PARAM_SUSTAIN] = "sustain",
+    [SYNTH_PARAM_RELEASE] = "release",
+    [SYNTH_PARAM_VOLUME] = "volume",
+};
+
+static const char * const mode_names[] = {
+    [SEQ_MODE_OFF] = "off",
+    [SEQ_MODE_PATTERN] = "pattern",
+    [SEQ_MODE_ARP_UP] = "up",
+    [SEQ_MODE_ARP_DOWN] = "down",
+    [SEQ_MODE_ARP_UPDOWN] = "updown",
+};
+
+static int lookup(const char *name, const char * const *names, int count)
+{
+    for (int i = 0; i < count; i++) {
+        if (strcasecmp(name, names[i]) == 0) return i;
+    }
+    return -1;
+}
+
+static int event_cmp(const void *a, const void *b)
+{
+    const scene_event_t * x = a;
+    const scene_event_t * y = b;
+    if (x->time_us != y->time_us) return x->time_us < y->time_us ? -1 : 1;
+    return x->line - y->line;
+}
+
+static bool parse_event(scene_event_t *ev, const char *cmd, int argc, const char *a1, const char *a2)
+{
+    if (strcmp(cmd, "on") == 0 || strcmp(cmd, "off") == 0 ||
+        strcmp(cmd, "hold") == 0 || strcmp(cmd, "unhold") == 0) {
+        if (argc < 1) return false;
+        ev->cmd = cmd[0] == 'h' ? CMD_HOLD : cmd[0] == 'u' ? CMD_UNHOLD :
+                  cmd[1] == 'n' ? CMD_NOTE_ON : CMD_NOTE_OFF;
+        ev->a = atoi(a1);
+        return true;
+    }
+    if (strcmp(cmd, "param") == 0) {
+        ev->cmd = CMD_PARAM;
+        ev->a = argc == 2 ? lookup(a1, param_names, sizeof(param_names) / sizeof(param_names[0])) : -1;
+        ev->value = argc == 2 ? strtof(a2, NULL) : 0.0f;
+        return ev->a >= 0;
+    }
+    if (strcmp(cmd, "seq") == 0) {
+        ev->cmd = CMD_SEQ_MODE;
+        ev->a = argc == 1 ? lookup(a1, mode_names, sizeof(mode_names) / sizeof(mode_names[0])) : -1;
+        return ev->a >= 0;
+    }
+    if (strcmp(cmd, "bpm") == 0) {
+        ev->cmd = CMD_SEQ_BPM;
+        ev->value = argc == 1 ? strtof(a1, NULL) : 0.0f;
+        return argc == 1;
+    }
+    if (strcmp(cmd, "step") == 0) {
+        ev->cmd = CMD_SEQ_STEP;
+        ev->a = atoi(a1);
+        ev->value = argc == 2 && strcmp(a2, "rest") != 0 ? (float)atoi(a2) : (float)SEQ_REST;
+        return argc == 2;
+    }
+    if (strcmp(cmd, "fx") == 0) {
+        ev->cmd = CMD_FX;
+        snprintf(ev->name, sizeof(ev->name), "%s", a1);
+        ev->a = argc == 2 && strcmp(a2, "on") == 0;
+        return argc == 2;
+    }
+    return false;
+}
+
+static bool scene_load(const char *path, scene_t *s)
+{
+    FILE * f = fopen(path, "r");
+    if (!f) {
+        printf("synth_render: Cannot open %s\n", path);
+        return false;
+    }
+
+    s->sample_rate = 16000;
+    s->block = SYNTH_BLOCK_SIZE;
+    s->length = 0.0f;
+    s->count = 0;
+
+    char line[256];
+    int line_no = 0;
+    bool ok = true;
+    while (ok && fgets(line, sizeof(line), f)) {
+        line_no++;
+        char * hash = strchr(line, '#');
+        if (hash) *hash = '\0';
+
+        char w[4][32];
+        int argc = sscanf(line, "%31s %31s %31s %31s", w[0], w[1], w[2], w[3]);
+        if (argc <= 0) continue;
+
+        if (strcmp(w[0], "rate") == 0 && argc == 2) {
+            s->sample_rate = atoi(w[1]);
+        } else if (strcmp(w[0], "block") == 0 && argc == 2) {
+            s->block = atoi(w[1]);
+        } else if (strcmp(w[0], "length") == 0 && argc == 2) {
+            s->length = strtof(w[1], NULL);
+        } else if (argc >= 2 && s->count < SCENE_MAX_EVENTS) {
+            scene_event_t * ev = &s->events[s->count];
+            memset(ev, 0, sizeof(*ev));
+            ev->time_us = llround(strtod(w[0], NULL) * 1e6);
+            ev->line = line_no;
+            ok = parse_event(ev, w[1], argc - 2, w[2], w[3]);
+            s->count++;
+        } else {
+            ok = false;
+        }
+        if (!ok) printf("synth_render: %s:%d: cannot parse this line\n", path, line_no);
+    }
+    fclose(f);
+
+    if (ok && (s->sample_rate <= 0 || s->block <= 0 || s->block > SYNTH_BLOCK_SIZE || s->length <= 0.0f)) {
+        printf("synth_render: %s needs a length, a positive rate and a block of at most %d\n",
+               path, SYNTH_BLOCK_SIZE);
+        ok = false;
+    }
+    qsort(s->events, s->count, sizeof(s->events[0]), event_cmp);
+    return ok;
+}
+
+static void apply_event(const scene_event_t *ev)
+{
+    synth_event_t sev = { .time_us = ev->time_us, .note_idx = (int16_t)ev->a };
+    switch (ev->cmd) {
+        case CMD_NOTE_ON:
+            sev.type = SYNTH_EV_NOTE_ON;
+            sev.value = sequencer_note_freq(ev->a);
+            synth_events_push(&sev);
+            break;
+        case CMD_NOTE_OFF:
+            sev.type = SYNTH_EV_NOTE_OFF;
+            synth_events_push(&sev);
+            break;
+        case CMD_PARAM:
+            sev.type = SYNTH_EV_PARAM;
+            sev.param = (uint8_t)ev->a;
+            sev.note_idx = 0;
+            sev.value = ev->value;
+            synth_events_push(&sev);
+            break;
+        case CMD_SEQ_MODE:
+            sequencer_set_mode((seq_mode_t)ev->a);
+            break;
+        case CMD_SEQ_BPM:
+            sequencer_set_bpm(ev->value);
+            break;
+        case CMD_SEQ_STEP:
+            sequencer_set_step(ev->a, (int)ev->value);
+            break;
+        case CMD_HOLD:
+        case CMD_UNHOLD:
+            sequencer_hold(ev->a, ev->cmd == CMD_HOLD);
+            break;
+        case CMD_FX: {
+            dsp_graph_t * fx = audio_engine_fx();
+            for (int i = 0; i < fx->count; i++) {
+                if (strcasecmp(fx->nodes[i]->name, ev->name) == 0) fx->nodes[i]->enabled = ev->a;
+            }
+            break;
+        }
+    }
+}
+
+static double now_sec(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+// Renders the whole scene and returns the seconds spent in the engine
+static double scene_render(const scene_t *s, int16_t *out, int total)
+{
+    double busy = 0.0;
+    int e = 0;
+    for (int pos = 0; pos < total; pos += s->block) {
+        int n = total - pos < s->block ? total - pos : s->block;
+        int64_t start_us = (int64_t)pos * 1000000 / s->sample_rate;
+        int64_t end_us = (int64_t)(pos + n) * 1000000 / s->sample_rate;
+
+        // Everything stamped inside this block is queued before it renders
+        for (; e < s->count && s->events[e].time_us < end_us; e++) apply_event(&s->events[e]);
+
+        double t0 = now_sec();
+        audio_engine_render(out + pos, n, start_us);
+        busy += now_sec() - t0;
+    }
+    return busy;
+}
+
+static bool golden_compare(const char *path, const int16_t *out, int total, int sample_rate, int tolerance)
+{
+    int16_t * ref;
+    int n, rate;
+    if (!wav_read(path, &ref, &n, &rate)) {
+        printf("synth_render: Cannot read golden file %s\n", path);
+        return false;
+    }
+    if (n != total || rate != sample_rate) {
+        printf("synth_render: %s has %d samples at %d Hz, rendered %d at %d Hz\n",
+               path, n, rate, total, sample_rate);
+        free(ref);
+        return false;
+    }
+
+    int max_diff = 0, max_at = 0, over = 0;
+    double sq = 0.0;
+    for (int i = 0; i < n; i++) {
+        int d = abs((int)out[i] - (int)ref[i]);
+        if (d > max_diff) {
+            max_diff = d;
+            max_at = i;
+        }
+        if (d > tolerance) over++;
+        sq += (double)d * d;
+    }
+    free(ref);
+
+    printf("golden: max diff %d at sample %d, rms diff %.3f, %d samples over %d\n",
+           max_diff, max_at, sqrt(sq / n), over, tolerance);
+    return over == 0;
+}
+
+int main(int argc, char **argv)
+{
+    const char * out_path = NULL;
+    const char * golden_path = NULL;
+    const char * scene_path = NULL;
+    int tolerance = 4;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-o") == 0 && i + 1 < argc) out_path = argv[++i];
+        else if (strcmp(argv[i], "-g") == 0 && i + 1 < argc) golden_path = argv[++i];
+        else if (strcmp(argv[i], "-t") == 0 && i + 1 < argc) tolerance = atoi(argv[++i]);
+        else scene_path = argv[i];
+    }
+    if (!scene_path) {
+        printf("usage: synth_render [-o out.wav] [-g golden.wav] [-t tolerance] scene.txt\n");
+        return 2;
+    }
+
+    static scene_t scene;
+    if (!scene_load(scene_path, &scene)) return 2;
+    if (!audio_engine_init((float)scene.sample_rate)) {
+        printf("synth_render: audio_engine_init failed\n");
+        return 1;
+    }
+
+    int total = (int)lroundf(scene.length * (float)scene.sample_rate);
+    int16_t * out = calloc(total, sizeof(int16_t));
+    if (!out) return 1;
+
+    double busy = scene_render(&scene, out, total);
+    printf("%s: %d samples in %.2f ms, %.1fx real time, %.2f Msamples/s\n", scene_path, total,
+           busy * 1e3, (double)scene.length / busy, (double)total / busy * 1e-6);
+
+    bool ok = true;
+    if (out_path && !wav_write(out_path, out, total, scene.sample_rate)) {
+        printf("synth_render: Cannot write %s\n", out_path);
+        ok = false;
+    }
+    if (golden_path) ok = golden_compare(golden_path, out, total, scene.sample_rate, tolerance) && ok;
+    free(out);
+    return ok ? 0 : 1;
+}
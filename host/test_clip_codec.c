@@ -0,0 +1,199 @@
+// Clip codecs and library: round-trip SNR per codec on tones, a
+// speech-like signal and noise, block-by-block reverse playback against
+// the forward decode, library wrap-around and the persistent image.
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include "host_test.h"
+#include "clip_codec.h"
+#include "clip_library.h"
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+#define RATE    16000
+#define SECONDS 4
+#define N       (RATE * SECONDS + 123)    // not a whole number of blocks
+
+typedef enum { SIG_TONES = 0, SIG_SPEECH, SIG_NOISE, SIG_COUNT } signal_t;
+
+static void make_signal(signal_t sig, int16_t *out, int n)
+{
+    srand(5 + sig);
+    double ph = 0.0;
+    for (int i = 0; i < n; i++) {
+        double t = (double)i / RATE;
+        double v;
+        if (sig == SIG_TONES) {
+            v = 12000.0 * sin(2.0 * M_PI * 440.0 * t) + 6000.0 * sin(2.0 * M_PI * 1375.0 * t);
+        } else if (sig == SIG_SPEECH) {
+            // A gliding pitch with harmonics under a syllable-rate envelope
+            ph += 2.0 * M_PI * (140.0 + 40.0 * sin(2.0 * M_PI * 0.7 * t)) / RATE;
+            double env = 0.15 + 0.85 * fabs(sin(2.0 * M_PI * 2.5 * t));
+            v = 0.0;
+            for (int h = 1; h <= 12; h++) v += sin(h * ph) / h;
+            v *= 9000.0 * env;
+        } else {
+            v = (double)(rand() % 16001 - 8000);
+        }
+        out[i] = (int16_t)lrint(v);
+    }
+}
+
+static double snr_db(const int16_t *ref, const int16_t *got, int n)
+{
+    double sig = 0.0, err = 0.0;
+    for (int i = 0; i < n; i++) {
+        double d = (double)got[i] - ref[i];
+        sig += (double)ref[i] * ref[i];
+        err += d * d;
+    }
+    return err > 0.0 ? 10.0 * log10(sig / err) : 200.0;
+}
+
+static int decode_all(clip_codec_t codec, const uint8_t *data, int n, int16_t *out)
+{
+    int blocks = (n + CLIP_BLOCK_SAMPLES - 1) / CLIP_BLOCK_SAMPLES, total = 0;
+    for (int b = 0; b < blocks; b++) total += clip_decode_block(codec, data, n, b, out + b * CLIP_BLOCK_SAMPLES);
+    return total;
+}
+
+static void test_round_trip(void)
+{
+    static const char * const codec_names[] = { "raw", "ADPCM", "u-law" };
+    static const char * const signal_names[] = { "tones", "speech-like", "noise" };
+    // Lowest acceptable SNR per codec and signal
+    static const double min_snr[CLIP_CODEC_COUNT][SIG_COUNT] = {
+        { 150.0, 150.0, 150.0 },
+        { 30.0, 30.0, 12.0 },     // ADPCM cannot follow white noise
+        { 33.0, 33.0, 33.0 },
+    };
+    static int16_t pcm[N], dec[N + CLIP_BLOCK_SAMPLES], rev[N];
+    static uint8_t coded[N * 2 + 4096];
+
+    printf("codec   ratio   ");
+    for (int s = 0; s < SIG_COUNT; s++) printf("%-14s", signal_names[s]);
+    printf("decode Msamples/s\n");
+
+    for (int c = 0; c < CLIP_CODEC_COUNT; c++) {
+        size_t bytes = clip_codec_bytes((clip_codec_t)c, N);
+        printf("%-7s %4.2f:1 ", codec_names[c], (double)(N * 2) / bytes);
+        double decode_s = 0.0;
+        for (int s = 0; s < SIG_COUNT; s++) {
+            make_signal((signal_t)s, pcm, N);
+            memset(coded, 0xa5, sizeof(coded));
+            CHECK(clip_encode((clip_codec_t)c, pcm, N, coded) == bytes);
+            // Nothing past the coded size is written
+            CHECK(coded[bytes] == 0xa5);
+
+            double t0 = host_now();
+            for (int rep = 0; rep < 10; rep++) CHECK(decode_all((clip_codec_t)c, coded, N, dec) == N);
+            decode_s += host_now() - t0;
+
+            double snr = snr_db(pcm, dec, N);
+            printf("%6.1f dB     ", snr);
+            CHECK(snr >= min_snr[c][s]);
+
+            // Reverse playback in odd-sized reads gives the forward decode
+            // backwards, sample for sample
+            clip_player_t player;
+            clip_player_start_reverse(&player, (clip_codec_t)c, coded, N);
+            int got = 0, step = 1;
+            while (got < N) {
+                int r = clip_player_read_reverse(&player, rev + got, step);
+                got += r;
+                if (r < step) break;
+                step = step % 300 + 37;
+            }
+            CHECK(got == N);
+            int bad = 0;
+            for (int i = 0; i < N && i < got; i++) bad += rev[i] != dec[N - 1 - i];
+            CHECK(bad == 0);
+            int16_t tail;
+            CHECK(clip_player_read_reverse(&player, &tail, 1) == 0);
+        }
+        printf("%8.0f\n", 10.0 * SIG_COUNT * N / decode_s * 1e-6);
+    }
+}
+
+// Stands in for a take; sample i of clip k
+static int16_t take_sample(int k, int i)
+{
+    return (int16_t)((k * 977 + i * 13) % 20000 - 10000);
+}
+
+static bool clip_matches(int idx, int k, int n)
+{
+    static int16_t dec[RATE + CLIP_BLOCK_SAMPLES];
+    const clip_info_t * c = clip_library_get(idx);
+    if (!c || (int)c->samples != n || c->codec != CLIP_CODEC_PCM16) return false;
+    decode_all(CLIP_CODEC_PCM16, clip_library_data(c), n, dec);
+    for (int i = 0; i < n; i++) {
+        if (dec[i] != take_sample(k, i)) return false;
+    }
+    return true;
+}
+
+static void test_library(void)
+{
+    static int16_t pcm[RATE];
+    int n = RATE / 2;
+    size_t clip_bytes = clip_codec_bytes(CLIP_CODEC_PCM16, n);
+
+    // Room for four and a bit clips, so the fifth wraps to the start
+    CHECK(clip_library_init(clip_bytes * 4 + clip_bytes / 2));
+    for (int k = 1; k <= 12; k++) {
+        for (int i = 0; i < n; i++) pcm[i] = take_sample(k, i);
+        int idx = clip_library_add(CLIP_CODEC_PCM16, pcm, n, RATE, 1.0f);
+        CHECK(idx == clip_library_count() - 1);
+
+        // No two clips share arena bytes, and every clip left is intact
+        bool ok = clip_library_used() <= clip_library_capacity();
+        int count = clip_library_count();
+        for (int a = 0; a < count; a++) {
+            const clip_info_t * ca = clip_library_get(a);
+            ok = ok && ca->offset + ca->bytes <= clip_library_capacity();
+            for (int b = a + 1; b < count; b++) {
+                const clip_info_t * cb = clip_library_get(b);
+                ok = ok && (ca->offset + ca->bytes <= cb->offset || cb->offset + cb->bytes <= ca->offset);
+            }
+            ok = ok && clip_matches(a, (int)ca->id, n);
+        }
+        CHECK(ok);
+    }
+    int count = clip_library_count();
+    printf("library after 12 takes: %d clips, ids %u..%u\n", count,
+           (unsigned)clip_library_get(0)->id, (unsigned)clip_library_get(count - 1)->id);
+    CHECK(clip_library_get(count - 1)->id == 12);
+    CHECK(count >= 3 && count <= 4);
+
+    // Too big for the whole arena
+    static int16_t big[RATE * 3];
+    CHECK(clip_library_add(CLIP_CODEC_PCM16, big, RATE * 3, RATE, 1.0f) == -1);
+
+    // Image round trip, and a damaged image is refused without touching
+    // the library
+    size_t len = clip_library_image_bytes();
+    uint8_t * image = malloc(len);
+    CHECK(clip_library_image_write(image) == len);
+    CHECK(clip_library_image_peek(image, CLIP_IMAGE_HEADER_BYTES) == len);
+    clip_library_clear();
+    CHECK(clip_library_image_read(image, len));
+    CHECK(clip_library_count() == count);
+    for (int a = 0; a < count; a++) CHECK(clip_matches(a, (int)clip_library_get(a)->id, n));
+
+    image[len / 2] ^= 0x40;
+    CHECK(!clip_library_image_read(image, len));
+    image[len / 2] ^= 0x40;
+    CHECK(!clip_library_image_read(image, len - 1));
+    CHECK(clip_library_count() == count);
+    free(image);
+}
+
+int main(void)
+{
+    test_round_trip();
+    test_library();
+    return test_result("test_clip_codec");
+}
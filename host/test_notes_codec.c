@@ -0,0 +1,341 @@
+// Note record codec: format 3 round trips exactly for any coordinates,
+// formats 1 and 2 still read, and damaged records (truncated, bit-flipped
+// or random) are refused without reading past the record or leaking the
+// strokes read so far. Also reports the compression ratio and encode and
+// decode throughput on handwriting. Built with the address sanitizer where
+// available, which slows the timings down.
+#include <stdlib.h>
+#include <string.h>
+#include "host_test.h"
+#include "notes_codec.h"
+
+#define FUZZ_ROUNDS 20000
+#define SPEED_NOTES 32
+#define SPEED_REPS  20
+
+static uint32_t rng = 12345;
+
+static uint32_t rnd(void)
+{
+    rng ^= rng << 13;
+    rng ^= rng >> 17;
+    rng ^= rng << 5;
+    return rng;
+}
+
+static void note_clear(note_data_t *note)
+{
+    notes_codec_free(note);
+    memset(note, 0, sizeof(*note));
+}
+
+// Colours as format 3 keeps them: RGB565 widened back to 8 bits
+static lv_color_t color_565(uint32_t v)
+{
+    uint8_t r = (v >> 11) & 0x1f, g = (v >> 5) & 0x3f, b = v & 0x1f;
+    return lv_color_make((r << 3) | (r >> 2), (g << 2) | (g >> 4), (b << 3) | (b >> 2));
+}
+
+// Handwriting-like strokes, with a few pathological ones mixed in when wild
+// is set: empty strokes, single points and coordinates at the int32 limits
+static void make_note(note_data_t *note, uint32_t strokes, bool wild)
+{
+    memset(note, 0, sizeof(*note));
+    note->in_use = true;
+    note->stroke_cnt = strokes;
+    for (uint32_t s = 0; s < strokes; s++) {
+        note_stroke_t * st = &note->strokes[s];
+        uint32_t kind = wild ? rnd() % 5 : 0;
+        uint32_t n = kind == 1 ? 0 : kind == 2 ? 1 : 2 + rnd() % 200;
+        st->points = malloc((n ? n : 1) * sizeof(lv_point_precise_t));
+        st->point_cnt = st->point_cap = n;
+        st->width = 1 + rnd() % 255;
+        st->color = color_565(rnd() & 0xffff);
+
+        int32_t x = rnd() % 700, y = rnd() % 580;
+        for (uint32_t k = 0; k < n; k++) {
+            if (kind == 3) {
+                x = (int32_t)rnd();
+                y = (int32_t)rnd();
+            } else if (kind == 4) {
+                x = (rnd() & 1) ? INT32_MAX : INT32_MIN;
+                y = (rnd() & 1) ? INT32_MIN : INT32_MAX;
+            } else {
+                x += (int32_t)(rnd() % 13) - 6;
+                y += (int32_t)(rnd() % 13) - 6;
+            }
+            st->points[k].x = x;
+            st->points[k].y = y;
+        }
+    }
+}
+
+static bool notes_equal(const note_data_t *a, const note_data_t *b)
+{
+    if (a->stroke_cnt != b->stroke_cnt) return false;
+    for (uint32_t s = 0; s < a->stroke_cnt; s++) {
+        const note_stroke_t * sa = &a->strokes[s];
+        const note_stroke_t * sb = &b->strokes[s];
+        if (sa->point_cnt != sb->point_cnt || sa->width != sb->width ||
+            sa->color.red != sb->color.red || sa->color.green != sb->color.green ||
+            sa->color.blue != sb->color.blue || sb->edit_line_obj != NULL) {
+            return false;
+        }
+        if (sa->point_cnt &&
+            memcmp(sa->points, sb->points, sa->point_cnt * sizeof(lv_point_precise_t)) != 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Encodes into a buffer of exactly the written size, so any read past the
+// record is caught by the sanitizer
+static uint8_t * encode(const note_data_t *note, size_t *len)
+{
+    size_t max = notes_codec_max_bytes(note);
+    uint8_t * tmp = malloc(max);
+    *len = notes_codec_write(note, tmp) - tmp;
+    CHECK(*len <= max);
+    uint8_t * rec = malloc(*len ? *len : 1);
+    memcpy(rec, tmp, *len);
+    free(tmp);
+    return rec;
+}
+
+// Decodes from an exact-size copy. A refused record must leave no strokes;
+// an accepted one must end inside the record.
+static bool decode(note_data_t *out, uint32_t version, const uint8_t *data, size_t len)
+{
+    uint8_t * rec = malloc(len ? len : 1);
+    memcpy(rec, data, len);
+    memset(out, 0, sizeof(*out));
+    out->stroke_cnt = 7;
+    const uint8_t * end = notes_codec_read(out, version, rec, rec + len);
+    if (!end) CHECK(out->stroke_cnt == 0);
+    else CHECK(end <= rec + len && out->stroke_cnt <= MAX_STROKES_PER_NOTE);
+    for (uint32_t s = 0; end && s < out->stroke_cnt; s++) {
+        CHECK(out->strokes[s].point_cnt <= out->strokes[s].point_cap);
+    }
+    free(rec);
+    return end != NULL;
+}
+
+static void test_varint(void)
+{
+    static const uint64_t values[] = { 0, 1, 127, 128, 16383, 16384, 0xffffffffull, UINT64_MAX };
+    uint8_t buf[NOTES_VARINT_MAX_BYTES + 1];
+    for (size_t i = 0; i < sizeof(values) / sizeof(values[0]); i++) {
+        size_t n = notes_put_varint(buf, values[i]) - buf;
+        uint64_t v = 0;
+        CHECK(n <= NOTES_VARINT_MAX_BYTES);
+        CHECK(notes_get_varint(buf, buf + n, &v) == buf + n && v == values[i]);
+        CHECK(notes_get_varint(buf, buf + n - 1, &v) == NULL);
+    }
+    // Longer than any value can be
+    memset(buf, 0x80, sizeof(buf));
+    buf[NOTES_VARINT_MAX_BYTES] = 0;
+    uint64_t v;
+    CHECK(notes_get_varint(buf, buf + sizeof(buf), &v) == NULL);
+}
+
+static void test_round_trip(void)
+{
+    note_data_t note, back;
+    long points = 0, bytes = 0;
+
+    for (int round = 0; round < 200; round++) {
+        bool wild = round >= 100;
+        make_note(&note, round % (MAX_STROKES_PER_NOTE + 1), wild);
+        size_t len;
+        uint8_t * rec = encode(&note, &len);
+        CHECK(decode(&back, NOTE_FORMAT_VERSION, rec, len));
+        CHECK(notes_equal(&note, &back));
+
+        // Every shorter record is refused
+        bool prefix_ok = true;
+        for (size_t cut = 0; cut < len; cut += 1 + len / 64) {
+            note_data_t part;
+            prefix_ok = prefix_ok && !decode(&part, NOTE_FORMAT_VERSION, rec, cut);
+            note_clear(&part);
+        }
+        CHECK(prefix_ok);
+
+        if (!wild) {
+            for (uint32_t s = 0; s < note.stroke_cnt; s++) points += note.strokes[s].point_cnt;
+            bytes += (long)len;
+        }
+        free(rec);
+        note_clear(&note);
+        note_clear(&back);
+    }
+    printf("handwriting: %.2f bytes per point (raw format 2: %d)\n", (double)bytes / points,
+           (int)sizeof(lv_point_precise_t));
+    CHECK((double)bytes / points < 2.5);
+
+    // Widths past a byte are clamped, not wrapped
+    make_note(&note, 1, false);
+    note.strokes[0].width = 300;
+    size_t len;
+    uint8_t * rec = encode(&note, &len);
+    CHECK(decode(&back, NOTE_FORMAT_VERSION, rec, len) && back.strokes[0].width == 255);
+    free(rec);
+    note_clear(&note);
+    note_clear(&back);
+}
+
+// Times notes_codec_write and notes_codec_read over a set of full
+// handwritten notes
+static void test_speed(void)
+{
+    static note_data_t notes[SPEED_NOTES];
+    note_data_t back;
+    uint8_t * recs[SPEED_NOTES];
+    size_t lens[SPEED_NOTES];
+    long points = 0, bytes = 0;
+
+    for (int i = 0; i < SPEED_NOTES; i++) {
+        make_note(&notes[i], MAX_STROKES_PER_NOTE, false);
+        for (uint32_t s = 0; s < notes[i].stroke_cnt; s++) points += notes[i].strokes[s].point_cnt;
+        recs[i] = malloc(notes_codec_max_bytes(&notes[i]));
+    }
+
+    double t0 = host_now();
+    for (int rep = 0; rep < SPEED_REPS; rep++) {
+        for (int i = 0; i < SPEED_NOTES; i++) lens[i] = notes_codec_write(&notes[i], recs[i]) - recs[i];
+    }
+    double encode_s = host_now() - t0;
+    for (int i = 0; i < SPEED_NOTES; i++) bytes += (long)lens[i];
+
+    bool ok = true;
+    double decode_s = 0.0;
+    for (int rep = 0; rep < SPEED_REPS; rep++) {
+        for (int i = 0; i < SPEED_NOTES; i++) {
+            memset(&back, 0, sizeof(back));
+            t0 = host_now();
+            const uint8_t * end = notes_codec_read(&back, NOTE_FORMAT_VERSION, recs[i], recs[i] + lens[i]);
+            decode_s += host_now() - t0;
+            ok = ok && end == recs[i] + lens[i] && (rep > 0 || notes_equal(&notes[i], &back));
+            note_clear(&back);
+        }
+    }
+    CHECK(ok);
+
+    double raw_mb = (double)points * sizeof(lv_point_precise_t) * SPEED_REPS * 1e-6;
+    double pts = (double)points * SPEED_REPS;
+    printf("handwriting: %ld points in %d notes, %.2f:1 against raw format 2\n", points, SPEED_NOTES,
+           (double)points * sizeof(lv_point_precise_t) / bytes);
+    printf("encode: %.1f Mpoints/s (%.0f MB/s of points)   decode: %.1f Mpoints/s (%.0f MB/s of points)\n",
+           pts / encode_s * 1e-6, raw_mb / encode_s, pts / decode_s * 1e-6, raw_mb / decode_s);
+
+    for (int i = 0; i < SPEED_NOTES; i++) {
+        free(recs[i]);
+        note_clear(&notes[i]);
+    }
+}
+
+// Writes a note in the raw layout of formats 1 and 2
+static size_t encode_raw(const note_data_t *note, uint32_t version, uint8_t *out)
+{
+    uint8_t * ptr = out;
+    memcpy(ptr, &note->stroke_cnt, 4); ptr += 4;
+    for (uint32_t s = 0; s < note->stroke_cnt; s++) {
+        const note_stroke_t * st = &note->strokes[s];
+        memcpy(ptr, &st->point_cnt, 4); ptr += 4;
+        memcpy(ptr, &st->width, 2); ptr += 2;
+        if (version == 2) {
+            *ptr++ = st->color.red;
+            *ptr++ = st->color.green;
+            *ptr++ = st->color.blue;
+        }
+        memcpy(ptr, st->points, st->point_cnt * sizeof(lv_point_precise_t));
+        ptr += st->point_cnt * sizeof(lv_point_precise_t);
+    }
+    return ptr - out;
+}
+
+static void test_legacy(void)
+{
+    static uint8_t raw[MAX_STROKES_PER_NOTE * (10 + 201 * sizeof(lv_point_precise_t)) + 4];
+    note_data_t note, back;
+
+    for (uint32_t version = 1; version <= 2; version++) {
+        make_note(&note, 20, true);
+        if (version == 1) {
+            for (uint32_t s = 0; s < note.stroke_cnt; s++) note.strokes[s].color = lv_color_black();
+        }
+        size_t len = encode_raw(&note, version, raw);
+        CHECK(decode(&back, version, raw, len));
+        CHECK(notes_equal(&note, &back));
+        note_clear(&back);
+
+        note_data_t part;
+        CHECK(!decode(&part, version, raw, len - 1));
+        note_clear(&part);
+
+        // A point count whose byte size wraps a 32-bit size_t
+        uint32_t huge = 0x20000001;
+        memcpy(raw + 4, &huge, 4);
+        CHECK(!decode(&part, version, raw, len));
+        note_clear(&part);
+        note_clear(&note);
+    }
+
+    // Unknown versions are refused
+    note_data_t part;
+    CHECK(!decode(&part, 0, raw, 16));
+    CHECK(!decode(&part, NOTE_FORMAT_VERSION + 1, raw, 16));
+}
+
+// Damaged records: any outcome is fine as long as it is safe, so this
+// relies on the checks in decode() and on the sanitizer
+static void test_fuzz(void)
+{
+    static uint8_t buf[4096];
+    note_data_t note, back;
+    int accepted = 0;
+
+    make_note(&note, 12, true);
+    size_t len;
+    uint8_t * rec = encode(&note, &len);
+    note_clear(&note);
+
+    for (int round = 0; round < FUZZ_ROUNDS; round++) {
+        size_t n;
+        uint32_t version = NOTE_FORMAT_VERSION;
+        switch (round % 3) {
+            case 0:
+                // A few flipped bits
+                n = len < sizeof(buf) ? len : sizeof(buf);
+                memcpy(buf, rec, n);
+                for (int f = 1 + rnd() % 4; f > 0; f--) buf[rnd() % n] ^= (uint8_t)(1u << (rnd() % 8));
+                break;
+            case 1:
+                // Random bytes after a plausible stroke count
+                n = 1 + rnd() % 256;
+                for (size_t i = 0; i < n; i++) buf[i] = (uint8_t)rnd();
+                buf[0] = (uint8_t)(rnd() % (MAX_STROKES_PER_NOTE + 4));
+                version = 1 + rnd() % 3;
+                break;
+            default:
+                // Runs of continuation bytes and large counts
+                n = 1 + rnd() % 64;
+                for (size_t i = 0; i < n; i++) buf[i] = (rnd() & 1) ? 0xff : (uint8_t)rnd();
+                break;
+        }
+        accepted += decode(&back, version, buf, n);
+        note_clear(&back);
+    }
+    printf("fuzz: %d damaged records, %d decoded to something, none unsafe\n", FUZZ_ROUNDS, accepted);
+    free(rec);
+}
+
+int main(void)
+{
+    test_varint();
+    test_round_trip();
+    test_speed();
+    test_legacy();
+    test_fuzz();
+    return test_result("test_notes_codec");
+}
@@ -0,0 +1,189 @@
+// The streaming recorder end to end: recorder.c runs unchanged against the
+// FreeRTOS shim, with its writer task on a pthread and a host directory in
+// place of the FAT volume. Checks the WAV it leaves behind, the 8.3 take
+// names and the drop counter when the writer falls behind.
+#include <ctype.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "host_test.h"
+#include "freertos/queue.h"
+#include "recorder.h"
+#include "wav_io.h"
+
+#define RATE 16000
+
+static char dir[] = "/tmp/recXXXXXX";
+
+// Test signal: a different value at every sample position of the take
+static int16_t sample_at(int i)
+{
+    return (int16_t)(i * 7 - 20000);
+}
+
+// The microphone delivers far slower than the card takes data, so with
+// paced set each block waits until every buffer handed over so far is on
+// the card, as it would be at 16 kHz. Unpaced, the test outruns the writer
+// on purpose.
+static void write_blocks(int *pos, int total, int block, bool paced)
+{
+    static int16_t buf[4096];
+    recorder_stats_t st;
+    while (total > 0) {
+        int n = total < block ? total : block;
+        for (int i = 0; paced && i < 2000; i++) {
+            recorder_get_stats(&st);
+            if (st.blocks_written >= st.samples / RECORDER_BUF_SAMPLES) break;
+            usleep(1000);
+        }
+        for (int i = 0; i < n; i++) buf[i] = sample_at(*pos + i);
+        recorder_write(buf, n);
+        *pos += n;
+        total -= n;
+    }
+}
+
+static bool wait_finalized(recorder_stats_t *st)
+{
+    for (int i = 0; i < 2000; i++) {
+        recorder_get_stats(st);
+        if (!st->active) return true;
+        usleep(1000);
+    }
+    return false;
+}
+
+static bool is_8_3_take_name(const char *path)
+{
+    const char * base = strrchr(path, '/');
+    base = base ? base + 1 : path;
+    if (strlen(base) != 12 || strncmp(base, "REC", 3) != 0 || strcmp(base + 8, ".WAV") != 0) return false;
+    for (int i = 3; i < 8; i++) {
+        if (!isdigit((unsigned char)base[i])) return false;
+    }
+    return true;
+}
+
+static void expect_take(const char *path, int first, int count)
+{
+    int16_t * samples = NULL;
+    int n = 0, rate = 0;
+    CHECK(wav_read(path, &samples, &n, &rate));
+    CHECK(rate == RATE);
+    CHECK(n == count);
+    int bad = 0;
+    for (int i = 0; i < n && i < count; i++) bad += samples[i] != sample_at(first + i);
+    CHECK(bad == 0);
+    free(samples);
+}
+
+// A take spanning several buffer flushes, in blocks that do not divide the
+// buffer size
+static void test_take(void)
+{
+    recorder_stats_t st;
+    int pos = 0;
+    int total = RECORDER_BUF_SAMPLES * 3 + 1234;
+
+    CHECK(recorder_start());
+    write_blocks(&pos, total, 1000, true);
+    recorder_stop();
+    CHECK(wait_finalized(&st));
+
+    char want[64];
+    snprintf(want, sizeof(want), "%s/REC00001.WAV", dir);
+    printf("take 1: %s, %llu samples, %u flushes\n", st.path, (unsigned long long)st.samples,
+           (unsigned)st.blocks_written);
+    CHECK(strcmp(st.path, want) == 0);
+    CHECK(is_8_3_take_name(st.path));
+    CHECK(st.samples == (uint64_t)total);
+    CHECK(st.blocks_written == 4);
+    CHECK(st.dropped == 0 && st.write_errors == 0);
+    expect_take(st.path, 0, total);
+}
+
+// The next take skips names already on the card
+static void test_naming(void)
+{
+    char taken[64];
+    snprintf(taken, sizeof(taken), "%s/REC00002.WAV", dir);
+    FILE * f = fopen(taken, "wb");
+    CHECK(f != NULL);
+    if (f) fclose(f);
+
+    recorder_stats_t st;
+    int pos = 0;
+    CHECK(recorder_start());
+    write_blocks(&pos, 500, 500, true);
+    recorder_stop();
+    CHECK(wait_finalized(&st));
+
+    char want[64];
+    snprintf(want, sizeof(want), "%s/REC00003.WAV", dir);
+    printf("take 2: %s\n", st.path);
+    CHECK(strcmp(st.path, want) == 0);
+    CHECK(is_8_3_take_name(st.path));
+    expect_take(st.path, 0, 500);
+}
+
+// With the writer stalled, both buffers fill and further blocks are
+// dropped whole; what was accepted still lands in the file, in order
+static void test_drops(void)
+{
+    recorder_stats_t st;
+    int pos = 0;
+
+    CHECK(recorder_start());
+    host_queue_pause(host_last_queue, true);
+    write_blocks(&pos, 2 * RECORDER_BUF_SAMPLES, 512, false);
+    int accepted = pos;
+    for (int i = 0; i < 3; i++) {
+        int skipped = pos;
+        write_blocks(&skipped, 512, 512, false);
+    }
+    recorder_get_stats(&st);
+    CHECK(st.dropped == 3);
+    CHECK(st.samples == (uint64_t)accepted);
+
+    host_queue_pause(host_last_queue, false);
+    // Once a buffer is back, blocks are accepted again
+    for (int i = 0; i < 2000; i++) {
+        recorder_get_stats(&st);
+        if (st.blocks_written == 2) break;
+        usleep(1000);
+    }
+    write_blocks(&pos, 512, 512, true);
+    recorder_stop();
+    CHECK(wait_finalized(&st));
+
+    printf("stalled take: %u blocks dropped, %llu samples kept\n", (unsigned)st.dropped,
+           (unsigned long long)st.samples);
+    CHECK(st.dropped == 3);
+    CHECK(st.samples == (uint64_t)pos);
+    CHECK(st.write_errors == 0);
+    expect_take(st.path, 0, pos);
+}
+
+static void remove_dir(void)
+{
+    char path[64];
+    for (int i = 1; i <= 4; i++) {
+        snprintf(path, sizeof(path), "%s/REC%05d.WAV", dir, i);
+        unlink(path);
+    }
+    rmdir(dir);
+}
+
+int main(void)
+{
+    CHECK(mkdtemp(dir) != NULL);
+    CHECK(recorder_init(dir, RATE));
+    CHECK(host_last_queue != NULL);
+
+    test_take();
+    test_naming();
+    test_drops();
+
+    remove_dir();
+    return test_result("test_recorder");
+}
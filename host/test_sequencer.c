@@ -0,0 +1,142 @@
+// Sequencer timing and note routing: every step starts on the exact sample
+// its tempo puts it on, whatever the block sizes, and sequencer notes play
+// next to held keys without releasing or retriggering them.
+#include <math.h>
+#include <stdlib.h>
+#include "host_test.h"
+#include "sequencer.h"
+#include "synth.h"
+#include "synth_events.h"
+#include "wavetable.h"
+
+#define RATE        16000.0f
+#define MAX_ONSETS  512
+
+// Runs the pattern for `seconds` with blocks of `block` samples, or of
+// random sizes when block is 0, and records the absolute sample of every
+// note-on and note-off
+static int run_pattern(float bpm, int block, float seconds, int64_t *on, int64_t *off, int *offs)
+{
+    synth_timed_event_t ev[64];
+    int ons = 0;
+    *offs = 0;
+    sequencer_set_mode(SEQ_MODE_OFF);
+    sequencer_init(RATE);
+    sequencer_set_bpm(bpm);
+    sequencer_set_mode(SEQ_MODE_PATTERN);
+
+    int64_t clock = 0, end = (int64_t)(seconds * RATE);
+    int last_offset = 0;
+    while (clock < end) {
+        int n = block ? block : 1 + rand() % SYNTH_BLOCK_SIZE;
+        if (n > end - clock) n = (int)(end - clock);
+        int count = sequencer_render(ev, 64, n);
+        last_offset = 0;
+        for (int i = 0; i < count; i++) {
+            const synth_event_t *e = &ev[i].ev;
+            CHECK(ev[i].offset >= last_offset && ev[i].offset < n);
+            last_offset = ev[i].offset;
+            // Sequencer notes sit above the keys, at the step's note
+            CHECK(e->note_idx >= SEQ_NOTE_BASE && e->note_idx < SEQ_NOTE_BASE + SEQ_MAX_NOTES);
+            if (e->type == SYNTH_EV_NOTE_ON && ons < MAX_ONSETS) {
+                CHECK(e->value == sequencer_note_freq(e->note_idx - SEQ_NOTE_BASE));
+                on[ons++] = clock + ev[i].offset;
+            } else if (e->type == SYNTH_EV_NOTE_OFF && *offs < MAX_ONSETS) {
+                off[(*offs)++] = clock + ev[i].offset;
+            }
+        }
+        clock += n;
+    }
+    sequencer_set_mode(SEQ_MODE_OFF);
+    return ons;
+}
+
+static void test_onsets(float bpm)
+{
+    static int64_t on[MAX_ONSETS], off[MAX_ONSETS], on2[MAX_ONSETS], off2[MAX_ONSETS];
+    int offs, offs2;
+
+    // Every step holds a note, so step k sounds at k * step length
+    for (int s = 0; s < SEQ_STEPS; s++) sequencer_set_step(s, s % 13);
+    int ons = run_pattern(bpm, 0, 20.0f, on, off, &offs);
+    int ons2 = run_pattern(bpm, SYNTH_BLOCK_SIZE, 20.0f, on2, off2, &offs2);
+
+    double len = RATE * 60.0 / (bpm * 4.0);
+    int expected = (int)ceil(20.0 * RATE / len);
+    CHECK(ons == expected && ons2 == expected);
+
+    int late = 0, moved = 0;
+    for (int k = 0; k < ons && k < ons2; k++) {
+        // The first whole sample at or after the step position; the
+        // 16-bit fixed point may only differ right at a sample boundary
+        double pos = k * len;
+        int64_t want = (int64_t)ceil(pos);
+        if (on[k] != want && fabs(pos - round(pos)) > 1e-3) late++;
+        if (on[k] != on2[k]) moved++;
+    }
+    for (int k = 0; k < offs && k < offs2; k++) {
+        if (off[k] != off2[k]) moved++;
+        // Gate at half the step, and always before the next note starts
+        CHECK(off[k] >= on[k] && (k + 1 >= ons || off[k] <= on[k + 1]));
+        CHECK(llabs(off[k] - on[k] - (int64_t)(len * 0.5)) <= 1);
+    }
+    printf("%.0f BPM: %d steps, %d off their sample, %d moved by the block size\n", bpm, ons, late, moved);
+    CHECK(late == 0);
+    CHECK(moved == 0);
+}
+
+// Renders 1.5 s with key 0 held and/or the pattern running on note 0
+static void render_mix(bool key, bool seq, float *out, int total)
+{
+    synth_timed_event_t ev[64];
+    synth_init(RATE);
+    sequencer_set_mode(SEQ_MODE_OFF);
+    sequencer_init(RATE);
+    sequencer_set_bpm(137.0f);
+    for (int s = 0; s < SEQ_STEPS; s++) sequencer_set_step(s, s % 2 ? SEQ_REST : 0);
+    if (seq) sequencer_set_mode(SEQ_MODE_PATTERN);
+    if (key) {
+        synth_event_t on = { .type = SYNTH_EV_NOTE_ON, .note_idx = 0, .value = sequencer_note_freq(0) };
+        CHECK(synth_events_push(&on));
+    }
+
+    for (int done = 0; done < total; ) {
+        int n = total - done < 100 ? total - done : 100;
+        int count = sequencer_render(ev, 64, n);
+        synth_render(out + done, n, 0, ev, count);
+        done += n;
+    }
+    sequencer_set_mode(SEQ_MODE_OFF);
+    sequencer_render(ev, 64, 1);
+    if (key) {
+        synth_event_t off = { .type = SYNTH_EV_NOTE_OFF, .note_idx = 0 };
+        CHECK(synth_events_push(&off));
+    }
+}
+
+// The synth mix is linear, so with the sequencer on its own notes the key
+// and the pattern together sound exactly like the two rendered apart
+static void test_key_and_pattern_independent(void)
+{
+    enum { TOTAL = 24000 };
+    static float both[TOTAL], key[TOTAL], seq[TOTAL];
+    render_mix(true, true, both, TOTAL);
+    render_mix(true, false, key, TOTAL);
+    render_mix(false, true, seq, TOTAL);
+
+    float worst = 0.0f;
+    for (int i = 0; i < TOTAL; i++) worst = fmaxf(worst, fabsf(both[i] - key[i] - seq[i]));
+    printf("held key under the pattern: largest difference from the separate renders %.2e\n", worst);
+    CHECK(worst < 1e-5f);
+}
+
+int main(void)
+{
+    CHECK(wavetable_init());
+    srand(4711);
+    test_onsets(120.0f);
+    test_onsets(137.0f);
+    test_onsets(173.0f);
+    test_key_and_pattern_independent();
+    return test_result("test_sequencer");
+}
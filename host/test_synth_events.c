@@ -0,0 +1,92 @@
+// The UI-to-audio event queue under load: one pthread pushes numbered
+// events as fast as it can while another pops them, and every event must
+// arrive once, in order and intact.
+#include <pthread.h>
+#include <sched.h>
+#include <stdint.h>
+#include "host_test.h"
+#include "synth_events.h"
+
+#define STRESS_EVENTS 2000000
+
+static void make_event(synth_event_t *ev, uint32_t seq)
+{
+    ev->time_us = (int64_t)seq * 3 + 7;
+    ev->type = (uint8_t)(seq % 3);
+    ev->param = (uint8_t)(seq % 6);
+    ev->note_idx = (int16_t)(seq & 0x7fff);
+    ev->value = (float)(seq & 0xffff);
+}
+
+static bool event_ok(const synth_event_t *ev, uint32_t seq)
+{
+    synth_event_t want;
+    make_event(&want, seq);
+    return ev->time_us == want.time_us && ev->type == want.type && ev->param == want.param &&
+           ev->note_idx == want.note_idx && ev->value == want.value;
+}
+
+static volatile uint32_t producer_full = 0;
+
+static void * producer(void *arg)
+{
+    (void)arg;
+    synth_event_t ev;
+    for (uint32_t seq = 0; seq < STRESS_EVENTS; seq++) {
+        make_event(&ev, seq);
+        while (!synth_events_push(&ev)) {
+            producer_full++;
+            sched_yield();
+        }
+    }
+    return NULL;
+}
+
+static void * consumer(void *arg)
+{
+    uint32_t * bad = arg;
+    synth_event_t ev;
+    uint32_t seq = 0;
+    while (seq < STRESS_EVENTS) {
+        if (!synth_events_pop(&ev)) {
+            sched_yield();
+            continue;
+        }
+        if (!event_ok(&ev, seq)) (*bad)++;
+        seq++;
+    }
+    return NULL;
+}
+
+int main(void)
+{
+    synth_event_t ev;
+
+    // Capacity and order on one thread
+    CHECK(!synth_events_pop(&ev));
+    for (uint32_t i = 0; i < SYNTH_EVENT_QUEUE_LEN; i++) {
+        make_event(&ev, i);
+        CHECK(synth_events_push(&ev));
+    }
+    make_event(&ev, SYNTH_EVENT_QUEUE_LEN);
+    CHECK(!synth_events_push(&ev));
+    for (uint32_t i = 0; i < SYNTH_EVENT_QUEUE_LEN; i++) {
+        CHECK(synth_events_pop(&ev) && event_ok(&ev, i));
+    }
+    CHECK(!synth_events_pop(&ev));
+
+    uint32_t bad = 0;
+    pthread_t prod, cons;
+    double t0 = host_now();
+    CHECK(pthread_create(&cons, NULL, consumer, &bad) == 0);
+    CHECK(pthread_create(&prod, NULL, producer, NULL) == 0);
+    pthread_join(prod, NULL);
+    pthread_join(cons, NULL);
+    double t = host_now() - t0;
+
+    printf("%d events through the queue in %.2f s (%.1f M/s), producer found it full %u times\n",
+           STRESS_EVENTS, t, STRESS_EVENTS / t * 1e-6, (unsigned)producer_full);
+    CHECK(bad == 0);
+    CHECK(!synth_events_pop(&ev));
+    return test_result("test_synth_events");
+}
@@ -0,0 +1,209 @@
+// Voice allocation policy: free voices first, then the oldest releasing
+// voice, then the oldest sounding one; released voices are reused; and no
+// voice is ever lost or doubled over long random note sequences. Also
+// checks that voices stolen in a burst fade out instead of cutting off.
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include "host_test.h"
+#include "synth.h"
+#include "synth_events.h"
+#include "voice_alloc.h"
+#include "wavetable.h"
+
+// Every voice is on exactly one list, the lists are consistently linked
+// and the counts match
+static bool lists_consistent(const voice_alloc_t *va)
+{
+    int seen[VOICE_ALLOC_MAX] = { 0 };
+    int total = 0;
+    for (int l = 0; l < VOICE_LIST_COUNT; l++) {
+        int count = 0, prev = VOICE_NONE;
+        for (int v = va->head[l]; v != VOICE_NONE; v = va->next[v]) {
+            if (v < 0 || v >= va->num_voices || seen[v] || va->list[v] != l || va->prev[v] != prev) return false;
+            seen[v] = 1;
+            prev = v;
+            if (++count > va->num_voices) return false;
+        }
+        if (va->tail[l] != prev || va->count[l] != count) return false;
+        total += count;
+    }
+    return total == va->num_voices;
+}
+
+static void test_steal_order(void)
+{
+    voice_alloc_t va;
+    bool stolen;
+    voice_alloc_init(&va, 4);
+
+    // Free voices go out first, none of them stolen
+    int v[4];
+    for (int i = 0; i < 4; i++) {
+        v[i] = voice_alloc_note_on(&va, &stolen);
+        CHECK(v[i] != VOICE_NONE && !stolen);
+    }
+    CHECK(va.count[VOICE_LIST_FREE] == 0 && va.count[VOICE_LIST_SOUNDING] == 4);
+
+    // Pool full and nothing releasing: the oldest sounding voice is taken
+    int s = voice_alloc_note_on(&va, &stolen);
+    CHECK(s == v[0] && stolen);
+    // ...and it is now the youngest, so the next steal takes v[1]
+    s = voice_alloc_note_on(&va, &stolen);
+    CHECK(s == v[1] && stolen);
+
+    // Releasing voices are stolen before sounding ones, oldest release first
+    voice_alloc_release(&va, v[3]);
+    voice_alloc_release(&va, v[2]);
+    s = voice_alloc_note_on(&va, &stolen);
+    CHECK(s == v[3] && stolen);
+    s = voice_alloc_note_on(&va, &stolen);
+    CHECK(s == v[2] && stolen);
+    CHECK(va.count[VOICE_LIST_RELEASING] == 0);
+
+    // Release of a voice that is not sounding, and double frees, do nothing
+    voice_alloc_release(&va, v[0]);
+    voice_alloc_release(&va, v[0]);
+    voice_alloc_free(&va, v[0]);
+    voice_alloc_free(&va, v[0]);
+    voice_alloc_release(&va, v[0]);
+    CHECK(va.list[v[0]] == VOICE_LIST_FREE);
+    CHECK(lists_consistent(&va));
+}
+
+static void test_release_reuse(void)
+{
+    voice_alloc_t va;
+    bool stolen;
+    voice_alloc_init(&va, 8);
+
+    int v[8];
+    for (int i = 0; i < 8; i++) v[i] = voice_alloc_note_on(&va, &stolen);
+
+    // A voice whose release has finished is handed out again before any
+    // steal, and it is not reported as stolen
+    voice_alloc_release(&va, v[5]);
+    voice_alloc_free(&va, v[5]);
+    int r = voice_alloc_note_on(&va, &stolen);
+    CHECK(r == v[5] && !stolen);
+
+    // Freed voices come back in the order they were freed
+    voice_alloc_release(&va, v[2]);
+    voice_alloc_release(&va, v[6]);
+    voice_alloc_free(&va, v[6]);
+    voice_alloc_free(&va, v[2]);
+    CHECK(voice_alloc_note_on(&va, &stolen) == v[6] && !stolen);
+    CHECK(voice_alloc_note_on(&va, &stolen) == v[2] && !stolen);
+    CHECK(lists_consistent(&va));
+}
+
+// Random note on/off/finish sequences against a simple model of which
+// voices are in use
+static void test_random_sequences(void)
+{
+    voice_alloc_t va;
+    bool stolen;
+    srand(12345);
+
+    for (int run = 0; run < 20; run++) {
+        int voices = 1 + rand() % VOICE_ALLOC_MAX;
+        voice_alloc_init(&va, voices);
+        uint8_t state[VOICE_ALLOC_MAX] = { 0 };  // model: 0 free, 1 sounding, 2 releasing
+        bool ok = true;
+
+        for (int op = 0; op < 100000 && ok; op++) {
+            int r = rand() % 10;
+            int v = rand() % voices;
+            if (r < 4) {
+                int busy = 0;
+                for (int i = 0; i < voices; i++) busy += state[i] != 0;
+                int got = voice_alloc_note_on(&va, &stolen);
+                ok = got >= 0 && got < voices && stolen == (busy == voices) &&
+                     (stolen || state[got] == 0);
+                if (ok) state[got] = 1;
+            } else if (r < 7) {
+                voice_alloc_release(&va, v);
+                if (state[v] == 1) state[v] = 2;
+            } else {
+                // The renderer frees a voice once its envelope has run out
+                if (state[v] == 2) {
+                    voice_alloc_free(&va, v);
+                    state[v] = 0;
+                }
+            }
+            for (int i = 0; ok && i < voices; i++) {
+                static const uint8_t list_of[] = { VOICE_LIST_FREE, VOICE_LIST_SOUNDING, VOICE_LIST_RELEASING };
+                ok = va.list[i] == list_of[state[i]];
+            }
+            if (op % 1000 == 0) ok = ok && lists_consistent(&va);
+        }
+        CHECK(ok);
+        CHECK(lists_consistent(&va));
+    }
+}
+
+static void push(uint8_t type, int note, float value, uint8_t param)
+{
+    synth_event_t ev = { .time_us = 0, .type = type, .param = param, .note_idx = (int16_t)note, .value = value };
+    CHECK(synth_events_push(&ev));
+}
+
+// Largest jump between neighbouring output samples
+static float max_step(const float *out, int n, float prev)
+{
+    float m = 0.0f;
+    for (int i = 0; i < n; i++) {
+        m = fmaxf(m, fabsf(out[i] - prev));
+        prev = out[i];
+    }
+    return m;
+}
+
+// Fills the pool with a slow sine, then steals a burst of voices on one
+// sample. Each stolen voice must fade over its 32 samples, so the output
+// may only slope down, never step.
+static void test_steal_burst_fades(int burst)
+{
+    static float out[SYNTH_BLOCK_SIZE];
+    synth_init(16000.0f);
+    push(SYNTH_EV_PARAM, 0, WT_SINE, SYNTH_PARAM_WAVEFORM);
+    push(SYNTH_EV_PARAM, 0, 0.01f, SYNTH_PARAM_ATTACK);
+    push(SYNTH_EV_PARAM, 0, 0.01f, SYNTH_PARAM_DECAY);
+    push(SYNTH_EV_PARAM, 0, 0.5f, SYNTH_PARAM_SUSTAIN);
+    for (int k = 0; k < SYNTH_MAX_VOICES; k++) push(SYNTH_EV_NOTE_ON, k, 1.0f, 0);
+
+    // A quarter second in, the 1 Hz sine is at its peak
+    float prev = 0.0f;
+    for (int b = 0; b < 16; b++) {
+        synth_render(out, SYNTH_BLOCK_SIZE, 0, NULL, 0);
+        prev = out[SYNTH_BLOCK_SIZE - 1];
+    }
+    float steady = max_step(out, SYNTH_BLOCK_SIZE, prev);
+
+    for (int k = 0; k < burst; k++) push(SYNTH_EV_NOTE_ON, SYNTH_MAX_VOICES + k, 1.0f, 0);
+    synth_render(out, SYNTH_BLOCK_SIZE, 0, NULL, 0);
+    float step = max_step(out, SYNTH_BLOCK_SIZE, prev);
+
+    // One voice at sustain contributes 0.5 * volume / 2 = 0.1, so each fade
+    // moves the output by 0.1 / 32 per sample; a hard cut of even one voice
+    // would add a step of 0.1
+    float limit = steady + (float)burst * 0.1f / 32.0f + 0.005f;
+    printf("burst of %2d steals: largest step %.4f (limit %.4f)\n", burst, step, limit);
+    CHECK(step < limit);
+
+    for (int k = 0; k < SYNTH_MAX_VOICES + burst; k++) push(SYNTH_EV_NOTE_OFF, k, 0.0f, 0);
+    synth_render(out, SYNTH_BLOCK_SIZE, 0, NULL, 0);
+}
+
+int main(void)
+{
+    CHECK(wavetable_init());
+    test_steal_order();
+    test_release_reuse();
+    test_random_sequences();
+    test_steal_burst_fades(4);
+    test_steal_burst_fades(5);
+    test_steal_burst_fades(8);
+    test_steal_burst_fades(SYNTH_MAX_VOICES);
+    return test_result("test_voice_alloc");
+}
@@ -0,0 +1,86 @@
+#include "wav_io.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static void put_u16(uint8_t *p, uint16_t v)
+{
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+}
+
+static void put_u32(uint8_t *p, uint32_t v)
+{
+    put_u16(p, (uint16_t)v);
+    put_u16(p + 2, (uint16_t)(v >> 16));
+}
+
+static uint16_t get_u16(const uint8_t *p)
+{
+    return (uint16_t)(p[0] | (p[1] << 8));
+}
+
+static uint32_t get_u32(const uint8_t *p)
+{
+    return get_u16(p) | ((uint32_t)get_u16(p + 2) << 16);
+}
+
+bool wav_write(const char *path, const int16_t *samples, int n, int sample_rate)
+{
+    uint32_t data_bytes = (uint32_t)n * 2;
+    uint8_t h[44];
+    memcpy(h, "RIFF", 4);
+    put_u32(h + 4, 36 + data_bytes);
+    memcpy(h + 8, "WAVEfmt ", 8);
+    put_u32(h + 16, 16);
+    put_u16(h + 20, 1);                     // PCM
+    put_u16(h + 22, 1);                     // mono
+    put_u32(h + 24, (uint32_t)sample_rate);
+    put_u32(h + 28, (uint32_t)sample_rate * 2);
+    put_u16(h + 32, 2);
+    put_u16(h + 34, 16);
+    memcpy(h + 36, "data", 4);
+    put_u32(h + 40, data_bytes);
+
+    FILE * f = fopen(path, "wb");
+    if (!f) return false;
+    bool ok = fwrite(h, 1, sizeof(h), f) == sizeof(h);
+    for (int i = 0; ok && i < n; i++) {
+        uint8_t b[2];
+        put_u16(b, (uint16_t)samples[i]);
+        ok = fwrite(b, 1, 2, f) == 2;
+    }
+    return fclose(f) == 0 && ok;
+}
+
+bool wav_read(const char *path, int16_t **samples, int *n, int *sample_rate)
+{
+    FILE * f = fopen(path, "rb");
+    if (!f) return false;
+
+    uint8_t h[44];
+    bool ok = fread(h, 1, sizeof(h), f) == sizeof(h) &&
+              memcmp(h, "RIFF", 4) == 0 && memcmp(h + 8, "WAVEfmt ", 8) == 0 &&
+              get_u32(h + 16) == 16 && get_u16(h + 20) == 1 && get_u16(h + 22) == 1 &&
+              get_u16(h + 34) == 16 && memcmp(h + 36, "data", 4) == 0;
+    uint32_t count = ok ? get_u32(h + 40) / 2 : 0;
+    int16_t * buf = ok ? malloc((count ? count : 1) * sizeof(int16_t)) : NULL;
+    for (uint32_t i = 0; buf && i < count; i++) {
+        uint8_t b[2];
+        if (fread(b, 1, 2, f) != 2) {
+            ok = false;
+            break;
+        }
+        buf[i] = (int16_t)get_u16(b);
+    }
+    fclose(f);
+
+    if (!ok || !buf) {
+        free(buf);
+        return false;
+    }
+    *samples = buf;
+    *n = (int)count;
+    *sample_rate = (int)get_u32(h + 24);
+    return true;
+}
@@ -0,0 +1,12 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// 16-bit mono PCM WAV files, as written by the offline renderer and by
+// main/recorder.c on the card.
+bool wav_write(const char *path, const int16_t *samples, int n, int sample_rate);
+
+// Reads a 16-bit mono PCM file into a malloc'd buffer. Returns false if the
+// file is missing or in any other format.
+bool wav_read(const char *path, int16_t **samples, int *n, int *sample_rate);
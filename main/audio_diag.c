@@ -0,0 +1,99 @@
+#include "audio_diag.h"
+#include "audio_platform.h"
+#include <string.h>
+
+static volatile audio_diag_stats_t stats = { .min_us = UINT32_MAX };
+
+static volatile uint32_t load_hist[AUDIO_DIAG_LOAD_BINS];
+static volatile float load_avg = 0.0f;
+static volatile float load_peak = 0.0f;
+static volatile uint32_t load_blocks = 0;
+static volatile uint32_t deadline_misses = 0;
+
+void audio_diag_record_latency(int64_t latency_us)
+{
+    if (latency_us < 0) latency_us = 0;
+    if (latency_us > UINT32_MAX) latency_us = UINT32_MAX;
+    uint32_t lat = (uint32_t)latency_us;
+
+    uint32_t bin = lat / AUDIO_DIAG_LAT_BIN_US;
+    if (bin >= AUDIO_DIAG_LAT_BINS) bin = AUDIO_DIAG_LAT_BINS - 1;
+    stats.hist[bin]++;
+    stats.count++;
+    stats.last_us = lat;
+    if (lat < stats.min_us) stats.min_us = lat;
+    if (lat > stats.max_us) stats.max_us = lat;
+}
+
+void audio_diag_count_underrun(void)
+{
+    stats.underruns++;
+}
+
+void audio_diag_record_load(uint32_t cycles, int block_size, int sample_rate)
+{
+    float period_cycles = (float)block_size / (float)sample_rate * AUDIO_CPU_HZ;
+    float load = (float)cycles / period_cycles;
+
+    int bin = (int)(load * 100.0f);
+    if (bin >= AUDIO_DIAG_LOAD_BINS) bin = AUDIO_DIAG_LOAD_BINS - 1;
+    load_hist[bin]++;
+    load_blocks++;
+    if (load > 1.0f) deadline_misses++;
+    if (load > load_peak) load_peak = load;
+    // About a quarter second of smoothing at the normal block size
+    load_avg += (load - load_avg) * 0.0625f;
+}
+
+static float load_percentile(float fraction)
+{
+    uint32_t total = load_blocks;
+    if (total == 0) return 0.0f;
+    uint32_t target = (uint32_t)((float)total * fraction);
+    uint32_t acc = 0;
+    for (int i = 0; i < AUDIO_DIAG_LOAD_BINS; i++) {
+        acc += load_hist[i];
+        if (acc > target) return (float)(i + 1) / 100.0f;
+    }
+    return load_peak;
+}
+
+void audio_diag_get_load(audio_load_stats_t *out)
+{
+    out->avg = load_avg;
+    out->peak = load_peak;
+    out->p95 = load_percentile(0.95f);
+    out->p99 = load_percentile(0.99f);
+    out->blocks = load_blocks;
+    out->deadline_misses = deadline_misses;
+    out->underruns = stats.underruns;
+}
+
+void audio_diag_get(audio_diag_stats_t *out)
+{
+    memcpy(out, (const void *)&stats, sizeof(*out));
+}
+
+void audio_diag_reset(void)
+{
+    memset((void *)&stats, 0, sizeof(stats));
+    stats.min_us = UINT32_MAX;
+
+    memset((void *)load_hist, 0, sizeof(load_hist));
+    load_avg = 0.0f;
+    load_peak = 0.0f;
+    load_blocks = 0;
+    deadline_misses = 0;
+}
+
+uint32_t audio_diag_latency_percentile(const audio_diag_stats_t *s, float fraction)
+{
+    if (s->count == 0) return 0;
+    uint32_t target = (uint32_t)((float)s->count * fraction);
+    uint32_t acc = 0;
+    for (int i = 0; i < AUDIO_DIAG_LAT_BINS; i++) {
+        acc += s->hist[i];
+        if (acc > target) return (uint32_t)(i + 1) * AUDIO_DIAG_LAT_BIN_US;
+    }
+    return s->max_us;
+}
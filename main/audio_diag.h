@@ -0,0 +1,46 @@
+#pragma once
+
+#include <stdint.h>
+
+// Key-to-sound latency histogram, 2 ms per bin; the last bin collects overflow
+#define AUDIO_DIAG_LAT_BINS   80
+#define AUDIO_DIAG_LAT_BIN_US 2000
+
+typedef struct {
+    uint32_t hist[AUDIO_DIAG_LAT_BINS];
+    uint32_t count;
+    uint32_t last_us;
+    uint32_t min_us;
+    uint32_t max_us;
+    uint32_t underruns;
+} audio_diag_stats_t;
+
+// Render load histogram, 1% of the block period per bin; the last bin
+// collects everything at or above AUDIO_DIAG_LOAD_BINS - 1 percent
+#define AUDIO_DIAG_LOAD_BINS 200
+
+typedef struct {
+    float avg;                // exponential average, 1.0 = whole block period
+    float peak;
+    float p95;
+    float p99;
+    uint32_t blocks;
+    uint32_t deadline_misses; // blocks whose render took longer than the period
+    uint32_t underruns;
+} audio_load_stats_t;
+
+// Audio thread side
+void audio_diag_record_latency(int64_t latency_us);
+void audio_diag_count_underrun(void);
+// Cycles spent rendering one block of block_size samples
+void audio_diag_record_load(uint32_t cycles, int block_size, int sample_rate);
+
+// UI side. Fields are updated without locking, so a snapshot may mix values
+// from adjacent blocks; that is fine for display.
+void audio_diag_get(audio_diag_stats_t *out);
+void audio_diag_get_load(audio_load_stats_t *out);
+void audio_diag_reset(void);
+
+// Value below which the given fraction (0.0 to 1.0) of latency samples fall,
+// in microseconds, resolved to the histogram bin width.
+uint32_t audio_diag_latency_percentile(const audio_diag_stats_t *stats, float fraction);
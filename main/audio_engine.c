@@ -0,0 +1,58 @@
+#include "audio_engine.h"
+#include "dsp_effects.h"
+#include "sequencer.h"
+#include "synth.h"
+#include "wavetable.h"
+
+static dsp_graph_t fx_graph;
+static float mix_buffer[SYNTH_BLOCK_SIZE];
+static synth_timed_event_t seq_events[16];
+
+bool audio_engine_init(float sample_rate)
+{
+    // The voice pool and sequencer are set up even if the tables cannot be
+    // had, so audio_engine_render stays safe to call; voices without a
+    // table render silence
+    synth_init(sample_rate);
+    sequencer_init(sample_rate);
+    bool tables_ok = wavetable_init();
+
+    // Synth bus effects. Delay and reverb start bypassed.
+    dsp_graph_init(&fx_graph);
+    dsp_graph_add(&fx_graph, dsp_svf_create(DSP_SVF_LOWPASS, 6000.0f, 0.707f, sample_rate));
+    dsp_node_t * fx_delay = dsp_delay_create(1.0f, 0.3f, 0.35f, 0.3f, sample_rate);
+    if (fx_delay) fx_delay->enabled = false;
+    dsp_graph_add(&fx_graph, fx_delay);
+    dsp_node_t * fx_reverb = dsp_reverb_create(0.6f, 0.4f, 0.25f, sample_rate);
+    if (fx_reverb) fx_reverb->enabled = false;
+    dsp_graph_add(&fx_graph, fx_reverb);
+    dsp_graph_add(&fx_graph, dsp_softclip_create(0.6f));
+    return tables_ok;
+}
+
+void audio_engine_render(int16_t *out, int n, int64_t window_start_us)
+{
+    if (n > SYNTH_BLOCK_SIZE) n = SYNTH_BLOCK_SIZE;
+
+    // The sequencer clock is the running sample count, so its notes land on
+    // exact offsets regardless of UI or scheduling jitter
+    int seq_count = sequencer_render(seq_events, sizeof(seq_events) / sizeof(seq_events[0]), n);
+    synth_render(mix_buffer, n, window_start_us, seq_events, seq_count);
+    dsp_graph_process(&fx_graph, mix_buffer, n);
+
+    for (int i = 0; i < n; i++) {
+        float s = mix_buffer[i];
+
+        // The limiter keeps the bus inside [-1.0, 1.0]; this only guards
+        // against it being switched off
+        if (s > 1.0f) s = 1.0f;
+        else if (s < -1.0f) s = -1.0f;
+
+        out[i] = (int16_t)(s * 32767.0f);
+    }
+}
+
+dsp_graph_t * audio_engine_fx(void)
+{
+    return &fx_graph;
+}
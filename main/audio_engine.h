@@ -0,0 +1,18 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "dsp_graph.h"
+
+// Codec-independent synthesis core: voices, effects bus and conversion to
+// 16-bit output. The caller owns the audio device and the clock, so the same
+// code runs in audio_task and in an offline renderer.
+// Returns false if the wavetables could not be allocated. The engine can
+// still be rendered then; it only plays silence.
+bool audio_engine_init(float sample_rate);
+
+// Renders n mono samples (up to SYNTH_BLOCK_SIZE). window_start_us is the
+// timestamp that synth events are placed against, see synth_render().
+void audio_engine_render(int16_t *out, int n, int64_t window_start_us);
+
+dsp_graph_t * audio_engine_fx(void);
@@ -0,0 +1,191 @@
+#include "audio_io.h"
+#include <stdio.h>
+#include "driver/i2s_std.h"
+#include "bsp/esp-bsp.h"
+#include "esp_codec_dev_defaults.h"
+
+#define AUDIO_IO_OUT_VOL 70
+
+// Codec control, made once; only the I2S side is rebuilt
+static const audio_codec_gpio_if_t * gpio_if = NULL;
+static const audio_codec_ctrl_if_t * ctrl_if = NULL;
+static const audio_codec_if_t * spk_if = NULL;
+static const audio_codec_if_t * mic_if = NULL;
+
+static i2s_chan_handle_t tx_chan = NULL;
+static i2s_chan_handle_t rx_chan = NULL;
+static const audio_codec_data_if_t * data_if = NULL;
+static esp_codec_dev_handle_t spk_dev = NULL;
+static esp_codec_dev_handle_t mic_dev = NULL;
+
+static int io_rate = 16000;
+static int io_block = 0;
+
+static void io_close(void)
+{
+    if (spk_dev) {
+        esp_codec_dev_close(spk_dev);
+        esp_codec_dev_delete(spk_dev);
+        spk_dev = NULL;
+    }
+    if (mic_dev) {
+        esp_codec_dev_close(mic_dev);
+        esp_codec_dev_delete(mic_dev);
+        mic_dev = NULL;
+    }
+    if (data_if) {
+        audio_codec_delete_data_if(data_if);
+        data_if = NULL;
+    }
+    // Disabling a channel the codec layer already stopped only reports
+    // that it was not running
+    if (tx_chan) {
+        i2s_channel_disable(tx_chan);
+        i2s_del_channel(tx_chan);
+        tx_chan = NULL;
+    }
+    if (rx_chan) {
+        i2s_channel_disable(rx_chan);
+        i2s_del_channel(rx_chan);
+        rx_chan = NULL;
+    }
+    io_block = 0;
+}
+
+// The channel setup of bsp_audio_init, with the DMA depth set
+static bool io_open(int block_frames)
+{
+    i2s_chan_config_t chan_cfg = I2S_CHANNEL_DEFAULT_CONFIG(CONFIG_BSP_I2S_NUM, I2S_ROLE_MASTER);
+    chan_cfg.dma_desc_num = AUDIO_IO_DMA_BLOCKS;
+    chan_cfg.dma_frame_num = block_frames;
+    chan_cfg.auto_clear = true;
+    if (i2s_new_channel(&chan_cfg, &tx_chan, &rx_chan) != ESP_OK) {
+        tx_chan = rx_chan = NULL;
+        return false;
+    }
+
+    i2s_std_config_t std_cfg = BSP_I2S_DUPLEX_MONO_CFG(io_rate);
+    if (i2s_channel_init_std_mode(tx_chan, &std_cfg) != ESP_OK ||
+        i2s_channel_init_std_mode(rx_chan, &std_cfg) != ESP_OK ||
+        i2s_channel_enable(tx_chan) != ESP_OK || i2s_channel_enable(rx_chan) != ESP_OK) {
+        io_close();
+        return false;
+    }
+
+    audio_codec_i2s_cfg_t i2s_cfg = {
+        .port = CONFIG_BSP_I2S_NUM,
+        .tx_handle = tx_chan,
+        .rx_handle = rx_chan,
+    };
+    data_if = audio_codec_new_i2s_data(&i2s_cfg);
+    if (!data_if) {
+        io_close();
+        return false;
+    }
+
+    esp_codec_dev_cfg_t spk_cfg = {
+        .dev_type = ESP_CODEC_DEV_TYPE_OUT,
+        .codec_if = spk_if,
+        .data_if = data_if,
+    };
+    esp_codec_dev_cfg_t mic_cfg = {
+        .dev_type = ESP_CODEC_DEV_TYPE_IN,
+        .codec_if = mic_if,
+        .data_if = data_if,
+    };
+    spk_dev = esp_codec_dev_new(&spk_cfg);
+    mic_dev = esp_codec_dev_new(&mic_cfg);
+
+    esp_codec_dev_sample_info_t fs = {
+        .sample_rate = io_rate,
+        .channel = 1,
+        .bits_per_sample = 16,
+    };
+    if (!spk_dev || esp_codec_dev_open(spk_dev, &fs) != ESP_CODEC_DEV_OK) {
+        io_close();
+        return false;
+    }
+    esp_codec_dev_set_out_vol(spk_dev, AUDIO_IO_OUT_VOL);
+    // The speaker is what the app cannot do without; a microphone that
+    // will not open is left out
+    if (mic_dev && esp_codec_dev_open(mic_dev, &fs) != ESP_CODEC_DEV_OK) {
+        esp_codec_dev_delete(mic_dev);
+        mic_dev = NULL;
+    }
+
+    io_block = block_frames;
+    return true;
+}
+
+bool audio_io_init(int sample_rate, int block_frames)
+{
+    io_rate = sample_rate;
+    if (bsp_i2c_init() != ESP_OK) return false;
+
+    gpio_if = audio_codec_new_gpio();
+    audio_codec_i2c_cfg_t i2c_cfg = {
+        .port = BSP_I2C_NUM,
+        .addr = ES8311_CODEC_DEFAULT_ADDR,
+        .bus_handle = bsp_i2c_get_handle(),
+    };
+    ctrl_if = audio_codec_new_i2c_ctrl(&i2c_cfg);
+    if (!gpio_if || !ctrl_if) return false;
+
+    // As the BSP configures the ES8311: DAC driving the speaker amplifier,
+    // ADC for the microphone, both clocked from MCLK
+    es8311_codec_cfg_t es8311_cfg = {
+        .ctrl_if = ctrl_if,
+        .gpio_if = gpio_if,
+        .codec_mode = ESP_CODEC_DEV_WORK_MODE_DAC,
+        .pa_pin = BSP_POWER_AMP_IO,
+        .pa_reverted = false,
+        .master_mode = false,
+        .use_mclk = true,
+        .digital_mic = false,
+        .invert_mclk = false,
+        .invert_sclk = false,
+        .hw_gain = {
+            .pa_voltage = 5.0,
+            .codec_dac_voltage = 3.3,
+        },
+    };
+    spk_if = es8311_codec_new(&es8311_cfg);
+    es8311_cfg.codec_mode = ESP_CODEC_DEV_WORK_MODE_ADC;
+    es8311_cfg.pa_pin = GPIO_NUM_NC;
+    mic_if = es8311_codec_new(&es8311_cfg);
+    if (!spk_if || !mic_if) return false;
+
+    if (!io_open(block_frames)) {
+        printf("Audio: Could not open I2S with %d-frame DMA buffers\n", block_frames);
+        return false;
+    }
+    return true;
+}
+
+bool audio_io_set_block(int block_frames)
+{
+    if (!spk_if || block_frames == io_block) return io_block != 0;
+
+    int prev = io_block;
+    io_close();
+    if (io_open(block_frames)) return true;
+
+    printf("Audio: Could not reopen I2S with %d-frame DMA buffers\n", block_frames);
+    if (prev) io_open(prev);
+    return false;
+}
+
+esp_codec_dev_handle_t audio_io_speaker(void)
+{
+    return spk_dev;
+}
+
+esp_codec_dev_handle_t audio_io_mic(void)
+{
+    return mic_dev;
+}
+
+int audio_io_queue_frames(void)
+{
+    return AUDIO_IO_DMA_BLOCKS * io_block;
+}
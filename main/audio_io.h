@@ -0,0 +1,25 @@
+#pragma once
+
+#include <stdbool.h>
+#include "esp_codec_dev.h"
+
+// Speaker and microphone on the board's ES8311, set up here instead of
+// through bsp_audio_init so the I2S DMA queue can follow the audio block
+// size. The BSP fixes it at 6 x 240 frames (90 ms at 16 kHz); here it is
+// AUDIO_IO_DMA_BLOCKS descriptors of one block each, which leaves the
+// render loop a little under that many blocks of slack.
+#define AUDIO_IO_DMA_BLOCKS 3
+
+bool audio_io_init(int sample_rate, int block_frames);
+
+// Rebuilds the I2S channels and both codec devices with a queue for
+// block_frames. Neither device may be in use while this runs, and the
+// handles from before are gone afterwards. On failure the previous size
+// is restored if possible.
+bool audio_io_set_block(int block_frames);
+
+esp_codec_dev_handle_t audio_io_speaker(void);
+esp_codec_dev_handle_t audio_io_mic(void);
+
+// Frames the TX DMA queue holds ahead of the codec
+int audio_io_queue_frames(void);
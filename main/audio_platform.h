@@ -0,0 +1,59 @@
+#pragma once
+
+// The synthesis core (wavetable, synth, voice_alloc, dsp_*, audio_engine)
+// reaches the platform only through this header, so it also builds with a
+// plain libc on a host machine.
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+#ifdef ESP_PLATFORM
+#include "esp_heap_caps.h"
+#include "esp_cpu.h"
+#include "sdkconfig.h"
+
+#define AUDIO_MEM_FAST  (MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT)
+#define AUDIO_MEM_BULK  MALLOC_CAP_SPIRAM
+#define AUDIO_CPU_HZ    ((float)CONFIG_ESP_DEFAULT_CPU_FREQ_MHZ * 1e6f)
+
+static inline void * audio_calloc(size_t n, size_t size, uint32_t caps)
+{
+    return heap_caps_calloc(n, size, caps);
+}
+
+static inline void audio_free(void *p)
+{
+    heap_caps_free(p);
+}
+
+static inline uint32_t audio_cycles(void)
+{
+    return esp_cpu_get_cycle_count();
+}
+#else
+#include <time.h>
+
+#define AUDIO_MEM_FAST  0
+#define AUDIO_MEM_BULK  0
+// Host builds count nanoseconds instead of CPU cycles
+#define AUDIO_CPU_HZ    1e9f
+
+static inline void * audio_calloc(size_t n, size_t size, uint32_t caps)
+{
+    (void)caps;
+    return calloc(n, size);
+}
+
+static inline void audio_free(void *p)
+{
+    free(p);
+}
+
+static inline uint32_t audio_cycles(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint32_t)((uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec);
+}
+#endif
@@ -0,0 +1,83 @@
+#include "audio_ring.h"
+#include "audio_platform.h"
+#include <string.h>
+
+bool audio_ring_init(audio_ring_t *r, uint32_t size)
+{
+    if (size == 0 || (size & (size - 1)) != 0) return false;
+
+    r->buf = audio_calloc(size, sizeof(int16_t), AUDIO_MEM_FAST);
+    if (!r->buf) return false;
+    r->size = size;
+    atomic_init(&r->head, 0);
+    atomic_init(&r->tail, 0);
+    r->overflows = 0;
+    return true;
+}
+
+// Both copies split at the wrap point of the buffer
+static void ring_put(audio_ring_t *r, unsigned pos, const int16_t *src, int n)
+{
+    unsigned idx = pos & (r->size - 1);
+    int first = (int)(r->size - idx);
+    if (first > n) first = n;
+    memcpy(&r->buf[idx], src, first * sizeof(int16_t));
+    memcpy(r->buf, src + first, (n - first) * sizeof(int16_t));
+}
+
+static void ring_get(audio_ring_t *r, unsigned pos, int16_t *dst, int n)
+{
+    unsigned idx = pos & (r->size - 1);
+    int first = (int)(r->size - idx);
+    if (first > n) first = n;
+    memcpy(dst, &r->buf[idx], first * sizeof(int16_t));
+    memcpy(dst + first, r->buf, (n - first) * sizeof(int16_t));
+}
+
+int audio_ring_write(audio_ring_t *r, const int16_t *src, int n)
+{
+    unsigned h = atomic_load_explicit(&r->head, memory_order_relaxed);
+    unsigned t = atomic_load_explicit(&r->tail, memory_order_acquire);
+    int space = (int)(r->size - (h - t));
+    if (n > space) {
+        r->overflows += n - space;
+        n = space;
+    }
+    if (n <= 0) return 0;
+
+    ring_put(r, h, src, n);
+    // Publish the samples only after they are written
+    atomic_store_explicit(&r->head, h + n, memory_order_release);
+    return n;
+}
+
+int audio_ring_read(audio_ring_t *r, int16_t *dst, int n)
+{
+    unsigned t = atomic_load_explicit(&r->tail, memory_order_relaxed);
+    unsigned h = atomic_load_explicit(&r->head, memory_order_acquire);
+    int avail = (int)(h - t);
+    if (n > avail) n = avail;
+    if (n <= 0) return 0;
+
+    ring_get(r, t, dst, n);
+    // Hand the space back only after the samples are copied out
+    atomic_store_explicit(&r->tail, t + n, memory_order_release);
+    return n;
+}
+
+void audio_ring_skip(audio_ring_t *r, int n)
+{
+    unsigned t = atomic_load_explicit(&r->tail, memory_order_relaxed);
+    unsigned h = atomic_load_explicit(&r->head, memory_order_acquire);
+    int avail = (int)(h - t);
+    if (n > avail) n = avail;
+    if (n <= 0) return;
+    atomic_store_explicit(&r->tail, t + n, memory_order_release);
+}
+
+int audio_ring_available(audio_ring_t *r)
+{
+    unsigned h = atomic_load_explicit(&r->head, memory_order_acquire);
+    unsigned t = atomic_load_explicit(&r->tail, memory_order_acquire);
+    return (int)(h - t);
+}
@@ -0,0 +1,28 @@
+#pragma once
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+// Single-producer / single-consumer sample FIFO, lock-free. One task may
+// write and one other task may read.
+typedef struct {
+    int16_t * buf;
+    uint32_t size;          // power of two
+    atomic_uint head;       // next sample to write, owned by the producer
+    atomic_uint tail;       // next sample to read, owned by the consumer
+    volatile uint32_t overflows; // samples the producer could not store
+} audio_ring_t;
+
+// size must be a power of two; the buffer is allocated in internal RAM
+bool audio_ring_init(audio_ring_t *r, uint32_t size);
+
+// Producer side. Stores as many samples as fit and returns that count.
+int audio_ring_write(audio_ring_t *r, const int16_t *src, int n);
+
+// Consumer side. Reads up to n samples and returns the number read.
+int audio_ring_read(audio_ring_t *r, int16_t *dst, int n);
+// Discards up to n of the oldest samples, e.g. to bound latency
+void audio_ring_skip(audio_ring_t *r, int n);
+
+int audio_ring_available(audio_ring_t *r);
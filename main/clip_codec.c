@@ -0,0 +1,213 @@
+#include "clip_codec.h"
+#include <string.h>
+
+// ---------------------------------------------------------------------
+// IMA-ADPCM
+// ---------------------------------------------------------------------
+
+// Each block starts with the predictor and step index it was encoded
+// from, so blocks decode independently
+#define ADPCM_HEADER_BYTES 4
+
+static const int16_t adpcm_steps[89] = {
+    7, 8, 9, 10, 11, 12, 13, 14, 16, 17, 19, 21, 23, 25, 28, 31, 34, 37, 41, 45,
+    50, 55, 60, 66, 73, 80, 88, 97, 107, 118, 130, 143, 157, 173, 190, 209, 230,
+    253, 279, 307, 337, 371, 408, 449, 494, 544, 598, 658, 724, 796, 876, 963,
+    1060, 1166, 1282, 1411, 1552, 1707, 1878, 2066, 2272, 2499, 2749, 3024, 3327,
+    3660, 4026, 4428, 4871, 5358, 5894, 6484, 7132, 7845, 8630, 9493, 10442,
+    11487, 12635, 13899, 15289, 16818, 18500, 20350, 22385, 24623, 27086, 29794,
+    32767
+};
+
+static const int8_t adpcm_index_adjust[8] = { -1, -1, -1, -1, 2, 4, 6, 8 };
+
+typedef struct {
+    int32_t predictor;
+    int index;
+} adpcm_state_t;
+
+// Reconstructs the next sample from a 4-bit code, exactly as the decoder will
+static inline int16_t adpcm_step(adpcm_state_t *st, int code)
+{
+    int step = adpcm_steps[st->index];
+    int diff = step >> 3;
+    if (code & 4) diff += step;
+    if (code & 2) diff += step >> 1;
+    if (code & 1) diff += step >> 2;
+    st->predictor += (code & 8) ? -diff : diff;
+    if (st->predictor > 32767) st->predictor = 32767;
+    else if (st->predictor < -32768) st->predictor = -32768;
+
+    st->index += adpcm_index_adjust[code & 7];
+    if (st->index < 0) st->index = 0;
+    else if (st->index > 88) st->index = 88;
+    return (int16_t)st->predictor;
+}
+
+static int adpcm_code(const adpcm_state_t *st, int sample)
+{
+    int step = adpcm_steps[st->index];
+    int diff = sample - st->predictor;
+    int code = 0;
+    if (diff < 0) {
+        code = 8;
+        diff = -diff;
+    }
+    if (diff >= step) { code |= 4; diff -= step; }
+    step >>= 1;
+    if (diff >= step) { code |= 2; diff -= step; }
+    step >>= 1;
+    if (diff >= step) code |= 1;
+    return code;
+}
+
+static void adpcm_encode_block(adpcm_state_t *st, const int16_t *pcm, int n, uint8_t *out)
+{
+    out[0] = (uint8_t)(st->predictor & 0xFF);
+    out[1] = (uint8_t)((st->predictor >> 8) & 0xFF);
+    out[2] = (uint8_t)st->index;
+    out[3] = 0;
+    uint8_t * codes = out + ADPCM_HEADER_BYTES;
+    memset(codes, 0, CLIP_BLOCK_SAMPLES / 2);
+
+    // Low nibble first
+    for (int i = 0; i < n; i++) {
+        int code = adpcm_code(st, pcm[i]);
+        adpcm_step(st, code);
+        codes[i >> 1] |= (uint8_t)(code << ((i & 1) * 4));
+    }
+}
+
+static void adpcm_decode_block(const uint8_t *in, int n, int16_t *out)
+{
+    adpcm_state_t st = {
+        .predictor = (int16_t)(in[0] | (in[1] << 8)),
+        .index = in[2] > 88 ? 88 : in[2],
+    };
+    const uint8_t * codes = in + ADPCM_HEADER_BYTES;
+    for (int i = 0; i < n; i++) {
+        out[i] = adpcm_step(&st, (codes[i >> 1] >> ((i & 1) * 4)) & 0x0F);
+    }
+}
+
+// ---------------------------------------------------------------------
+// G.711 mu-law
+// ---------------------------------------------------------------------
+
+#define ULAW_BIAS 0x84
+#define ULAW_CLIP 32635
+
+static uint8_t ulaw_encode(int16_t pcm)
+{
+    int v = pcm;
+    int sign = 0;
+    if (v < 0) {
+        sign = 0x80;
+        v = -v;
+    }
+    if (v > ULAW_CLIP) v = ULAW_CLIP;
+    v += ULAW_BIAS;
+
+    int exponent = 7;
+    for (int mask = 0x4000; (v & mask) == 0 && exponent > 0; mask >>= 1) exponent--;
+    int mantissa = (v >> (exponent + 3)) & 0x0F;
+    return (uint8_t)~(sign | (exponent << 4) | mantissa);
+}
+
+static inline int16_t ulaw_decode(uint8_t u)
+{
+    u = ~u;
+    int t = (((u & 0x0F) << 3) + ULAW_BIAS) << ((u & 0x70) >> 4);
+    return (int16_t)((u & 0x80) ? (ULAW_BIAS - t) : (t - ULAW_BIAS));
+}
+
+// ---------------------------------------------------------------------
+// Common
+// ---------------------------------------------------------------------
+
+size_t clip_codec_block_bytes(clip_codec_t codec)
+{
+    switch (codec) {
+        case CLIP_CODEC_ADPCM: return ADPCM_HEADER_BYTES + CLIP_BLOCK_SAMPLES / 2;
+        case CLIP_CODEC_ULAW:  return CLIP_BLOCK_SAMPLES;
+        default:               return CLIP_BLOCK_SAMPLES * sizeof(int16_t);
+    }
+}
+
+size_t clip_codec_bytes(clip_codec_t codec, int n)
+{
+    int blocks = (n + CLIP_BLOCK_SAMPLES - 1) / CLIP_BLOCK_SAMPLES;
+    return (size_t)blocks * clip_codec_block_bytes(codec);
+}
+
+size_t clip_encode(clip_codec_t codec, const int16_t *pcm, int n, uint8_t *out)
+{
+    size_t block_bytes = clip_codec_block_bytes(codec);
+    adpcm_state_t st = { 0, 0 };
+    size_t written = 0;
+
+    for (int start = 0; start < n; start += CLIP_BLOCK_SAMPLES) {
+        int count = n - start < CLIP_BLOCK_SAMPLES ? n - start : CLIP_BLOCK_SAMPLES;
+        uint8_t * dst = out + written;
+        switch (codec) {
+            case CLIP_CODEC_ADPCM:
+                adpcm_encode_block(&st, &pcm[start], count, dst);
+                break;
+            case CLIP_CODEC_ULAW:
+                for (int i = 0; i < count; i++) dst[i] = ulaw_encode(pcm[start + i]);
+                memset(dst + count, 0xFF, block_bytes - count);
+                break;
+            default:
+                memcpy(dst, &pcm[start], count * sizeof(int16_t));
+                memset(dst + count * sizeof(int16_t), 0, block_bytes - count * sizeof(int16_t));
+                break;
+        }
+        written += block_bytes;
+    }
+    return written;
+}
+
+int clip_decode_block(clip_codec_t codec, const uint8_t *data, int n, int b, int16_t *out)
+{
+    int start = b * CLIP_BLOCK_SAMPLES;
+    if (b < 0 || start >= n) return 0;
+    int count = n - start < CLIP_BLOCK_SAMPLES ? n - start : CLIP_BLOCK_SAMPLES;
+    const uint8_t * src = data + (size_t)b * clip_codec_block_bytes(codec);
+
+    switch (codec) {
+        case CLIP_CODEC_ADPCM:
+            adpcm_decode_block(src, count, out);
+            break;
+        case CLIP_CODEC_ULAW:
+            for (int i = 0; i < count; i++) out[i] = ulaw_decode(src[i]);
+            break;
+        default:
+            memcpy(out, src, count * sizeof(int16_t));
+            break;
+    }
+    return count;
+}
+
+void clip_player_start_reverse(clip_player_t *p, clip_codec_t codec, const uint8_t *data, int samples)
+{
+    p->codec = codec;
+    p->data = data;
+    p->samples = samples;
+    p->block = (samples + CLIP_BLOCK_SAMPLES - 1) / CLIP_BLOCK_SAMPLES;
+    p->pos = 0;
+}
+
+int clip_player_read_reverse(clip_player_t *p, int16_t *out, int n)
+{
+    int i = 0;
+    while (i < n) {
+        if (p->pos == 0) {
+            if (p->block == 0) break;
+            p->block--;
+            p->pos = clip_decode_block(p->codec, p->data, p->samples, p->block, p->buf);
+            if (p->pos == 0) break;
+        }
+        out[i++] = p->buf[--p->pos];
+    }
+    return i;
+}
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Sample codecs for stored clips. Audio is coded in independent blocks of
+// CLIP_BLOCK_SAMPLES, so any block can be decoded on its own: playback can
+// start anywhere and run backwards one block at a time.
+#define CLIP_BLOCK_SAMPLES 256
+
+typedef enum {
+    CLIP_CODEC_PCM16 = 0,   // raw, 2 bytes per sample
+    CLIP_CODEC_ADPCM,       // IMA-ADPCM, 4-byte state + 4 bits per sample
+    CLIP_CODEC_ULAW,        // G.711 mu-law, 1 byte per sample
+    CLIP_CODEC_COUNT
+} clip_codec_t;
+
+// Bytes of one full block, and of a clip of n samples
+size_t clip_codec_block_bytes(clip_codec_t codec);
+size_t clip_codec_bytes(clip_codec_t codec, int n);
+
+// Encodes n samples into out, which must hold clip_codec_bytes(codec, n).
+// Returns the bytes written.
+size_t clip_encode(clip_codec_t codec, const int16_t *pcm, int n, uint8_t *out);
+
+// Decodes block b of a clip of n samples into out (up to
+// CLIP_BLOCK_SAMPLES) and returns the number of samples in that block.
+int clip_decode_block(clip_codec_t codec, const uint8_t *data, int n, int b, int16_t *out);
+
+// Plays a coded clip from its last sample to its first, decoding one block
+// whenever the previous one runs out. Cheap enough for the audio thread.
+typedef struct {
+    clip_codec_t codec;
+    const uint8_t * data;
+    int samples;
+    int block;              // next block to decode, counting down
+    int pos;                // samples of buf not yet played
+    int16_t buf[CLIP_BLOCK_SAMPLES];
+} clip_player_t;
+
+void clip_player_start_reverse(clip_player_t *p, clip_codec_t codec, const uint8_t *data, int samples);
+
+// Fills out with up to n samples and returns how many there were; fewer
+// than n means the clip has ended.
+int clip_player_read_reverse(clip_player_t *p, int16_t *out, int n);
@@ -0,0 +1,198 @@
+#include "clip_library.h"
+#include "audio_platform.h"
+#include <string.h>
+
+#define CLIP_IMAGE_MAGIC   0x50494C43u  // "CLIP"
+#define CLIP_IMAGE_VERSION 1
+
+typedef struct {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t count;
+    uint32_t data_bytes;
+    uint32_t checksum;      // FNV-1a over the index and data
+} clip_image_header_t;
+
+_Static_assert(sizeof(clip_image_header_t) == CLIP_IMAGE_HEADER_BYTES, "image header layout");
+
+static uint8_t * arena = NULL;
+static size_t arena_size = 0;
+static clip_info_t clips[CLIP_LIBRARY_MAX];
+static int clip_count = 0;
+static uint32_t next_clip_id = 1;
+
+bool clip_library_init(size_t arena_bytes)
+{
+    if (arena) return true;
+    arena = audio_calloc(arena_bytes, 1, AUDIO_MEM_BULK);
+    if (!arena) return false;
+    arena_size = arena_bytes;
+    return true;
+}
+
+static void drop_oldest(void)
+{
+    memmove(&clips[0], &clips[1], (clip_count - 1) * sizeof(clip_info_t));
+    clip_count--;
+}
+
+static bool any_overlaps(size_t start, size_t end)
+{
+    for (int i = 0; i < clip_count; i++) {
+        if (clips[i].offset < end && clips[i].offset + clips[i].bytes > start) return true;
+    }
+    return false;
+}
+
+int clip_library_add(clip_codec_t codec, const int16_t *pcm, int n, int sample_rate, float gain)
+{
+    size_t bytes = clip_codec_bytes(codec, n);
+    if (!arena || n <= 0 || bytes > arena_size) return -1;
+
+    // Append after the newest clip, wrapping to the start when the end of
+    // the arena is too short. The arena is used as a circular log, so the
+    // clips in the way are the oldest ones; dropping strictly oldest first
+    // also retires any clips in the skipped tail after a wrap.
+    size_t start = 0;
+    if (clip_count > 0) {
+        const clip_info_t * newest = &clips[clip_count - 1];
+        start = newest->offset + newest->bytes;
+        if (start + bytes > arena_size) start = 0;
+    }
+    while (clip_count > 0 && (clip_count == CLIP_LIBRARY_MAX || any_overlaps(start, start + bytes))) {
+        drop_oldest();
+    }
+
+    clip_encode(codec, pcm, n, arena + start);
+
+    clip_info_t * c = &clips[clip_count];
+    memset(c, 0, sizeof(*c));
+    c->id = next_clip_id++;
+    c->offset = (uint32_t)start;
+    c->bytes = (uint32_t)bytes;
+    c->samples = (uint32_t)n;
+    c->sample_rate = (uint32_t)sample_rate;
+    c->codec = (uint8_t)codec;
+    c->gain = gain;
+    return clip_count++;
+}
+
+void clip_library_clear(void)
+{
+    clip_count = 0;
+}
+
+int clip_library_count(void)
+{
+    return clip_count;
+}
+
+const clip_info_t * clip_library_get(int idx)
+{
+    if (idx < 0 || idx >= clip_count) return NULL;
+    return &clips[idx];
+}
+
+const uint8_t * clip_library_data(const clip_info_t *clip)
+{
+    return arena + clip->offset;
+}
+
+size_t clip_library_used(void)
+{
+    size_t used = 0;
+    for (int i = 0; i < clip_count; i++) used += clips[i].bytes;
+    return used;
+}
+
+size_t clip_library_capacity(void)
+{
+    return arena_size;
+}
+
+// ---------------------------------------------------------------------
+// Persistent image
+// ---------------------------------------------------------------------
+
+static uint32_t fnv1a(uint32_t h, const uint8_t *p, size_t n)
+{
+    for (size_t i = 0; i < n; i++) {
+        h ^= p[i];
+        h *= 16777619u;
+    }
+    return h;
+}
+
+size_t clip_library_image_bytes(void)
+{
+    return sizeof(clip_image_header_t) + clip_count * sizeof(clip_info_t) + clip_library_used();
+}
+
+size_t clip_library_image_write(uint8_t *out)
+{
+    clip_image_header_t hdr = {
+        .magic = CLIP_IMAGE_MAGIC,
+        .version = CLIP_IMAGE_VERSION,
+        .count = (uint16_t)clip_count,
+    };
+
+    // Data is packed in age order, so offsets are rewritten relative to
+    // the start of the data section
+    clip_info_t * index = (clip_info_t *)(out + sizeof(hdr));
+    uint8_t * data = out + sizeof(hdr) + clip_count * sizeof(clip_info_t);
+    uint32_t pos = 0;
+    for (int i = 0; i < clip_count; i++) {
+        index[i] = clips[i];
+        index[i].offset = pos;
+        memcpy(data + pos, arena + clips[i].offset, clips[i].bytes);
+        pos += clips[i].bytes;
+    }
+    hdr.data_bytes = pos;
+
+    size_t body = clip_count * sizeof(clip_info_t) + pos;
+    hdr.checksum = fnv1a(2166136261u, out + sizeof(hdr), body);
+    memcpy(out, &hdr, sizeof(hdr));
+    return sizeof(hdr) + body;
+}
+
+size_t clip_library_image_peek(const uint8_t *header, size_t len)
+{
+    clip_image_header_t hdr;
+    if (len < sizeof(hdr)) return 0;
+    memcpy(&hdr, header, sizeof(hdr));
+    if (hdr.magic != CLIP_IMAGE_MAGIC || hdr.version != CLIP_IMAGE_VERSION ||
+        hdr.count > CLIP_LIBRARY_MAX || hdr.data_bytes > arena_size) {
+        return 0;
+    }
+    return sizeof(hdr) + hdr.count * sizeof(clip_info_t) + hdr.data_bytes;
+}
+
+bool clip_library_image_read(const uint8_t *in, size_t len)
+{
+    size_t total = clip_library_image_peek(in, len);
+    if (!arena || total == 0 || total > len) return false;
+
+    clip_image_header_t hdr;
+    memcpy(&hdr, in, sizeof(hdr));
+    if (fnv1a(2166136261u, in + sizeof(hdr), total - sizeof(hdr)) != hdr.checksum) return false;
+
+    const uint8_t * data = in + sizeof(hdr) + hdr.count * sizeof(clip_info_t);
+    clip_info_t index[CLIP_LIBRARY_MAX];
+    memcpy(index, in + sizeof(hdr), hdr.count * sizeof(clip_info_t));
+    for (int i = 0; i < hdr.count; i++) {
+        const clip_info_t * c = &index[i];
+        if (c->codec >= CLIP_CODEC_COUNT || (uint64_t)c->offset + c->bytes > hdr.data_bytes ||
+            c->bytes < clip_codec_bytes((clip_codec_t)c->codec, (int)c->samples)) {
+            return false;
+        }
+    }
+
+    memcpy(arena, data, hdr.data_bytes);
+    memcpy(clips, index, hdr.count * sizeof(clip_info_t));
+    clip_count = hdr.count;
+    next_clip_id = 1;
+    for (int i = 0; i < clip_count; i++) {
+        if (clips[i].id >= next_clip_id) next_clip_id = clips[i].id + 1;
+    }
+    return true;
+}
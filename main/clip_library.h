@@ -0,0 +1,48 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "clip_codec.h"
+
+// Takes kept compressed in one PSRAM arena, oldest first. When a new clip
+// does not fit, the oldest clips are dropped to make room.
+#define CLIP_LIBRARY_MAX 32
+
+typedef struct {
+    uint32_t id;            // increases with every clip added
+    uint32_t offset;        // into the arena
+    uint32_t bytes;
+    uint32_t samples;
+    uint32_t sample_rate;
+    uint8_t codec;          // clip_codec_t
+    uint8_t reserved[3];
+    float gain;             // playback gain chosen when the clip was taken
+} clip_info_t;
+
+bool clip_library_init(size_t arena_bytes);
+
+// UI thread only. Encodes n samples and appends them; returns the new
+// clip's index, or -1 if it cannot fit even in an empty arena. Evicted
+// clips are overwritten, so no clip may be playing while this runs.
+int clip_library_add(clip_codec_t codec, const int16_t *pcm, int n, int sample_rate, float gain);
+void clip_library_clear(void);
+
+// Index 0 is the oldest clip
+int clip_library_count(void);
+const clip_info_t * clip_library_get(int idx);
+const uint8_t * clip_library_data(const clip_info_t *clip);
+size_t clip_library_used(void);
+size_t clip_library_capacity(void);
+
+// Serialized form for persistent storage: header, index, then the clips'
+// data back to back. The header carries a checksum of everything after it.
+size_t clip_library_image_bytes(void);
+// out must hold clip_library_image_bytes(); returns the bytes written
+size_t clip_library_image_write(uint8_t *out);
+// Replaces the library with an image; false if it is not a valid one
+bool clip_library_image_read(const uint8_t *in, size_t len);
+// Total image length from its header, or 0 if the header is not valid
+size_t clip_library_image_peek(const uint8_t *header, size_t len);
+
+#define CLIP_IMAGE_HEADER_BYTES 16
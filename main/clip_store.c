@@ -0,0 +1,111 @@
+#include "clip_store.h"
+#include "clip_library.h"
+#include "task_topology.h"
+#include <stdio.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "esp_partition.h"
+#include "esp_heap_caps.h"
+
+#define CLIP_STORE_SECTOR 4096
+
+static const esp_partition_t * part = NULL;
+static SemaphoreHandle_t save_request = NULL;
+static uint8_t * image = NULL;
+static size_t image_len = 0;
+static volatile clip_store_status_t status = CLIP_STORE_NONE;
+static clip_store_quiet_fn quiet_fn = NULL;
+
+static bool write_image(void)
+{
+    size_t erase_len = (image_len + CLIP_STORE_SECTOR - 1) & ~(size_t)(CLIP_STORE_SECTOR - 1);
+    if (esp_partition_erase_range(part, 0, erase_len) != ESP_OK) return false;
+
+    // Header goes last: a save cut short leaves an erased header, which
+    // loads as an empty library rather than a torn one
+    if (esp_partition_write(part, CLIP_IMAGE_HEADER_BYTES, image + CLIP_IMAGE_HEADER_BYTES,
+                            image_len - CLIP_IMAGE_HEADER_BYTES) != ESP_OK) {
+        return false;
+    }
+    return esp_partition_write(part, 0, image, CLIP_IMAGE_HEADER_BYTES) == ESP_OK;
+}
+
+static void store_task(void *arg)
+{
+    while (1) {
+        xSemaphoreTake(save_request, portMAX_DELAY);
+
+        if (quiet_fn) quiet_fn(true);
+        bool ok = write_image();
+        if (quiet_fn) quiet_fn(false);
+        printf("Clips: %s %u bytes to flash\n", ok ? "Saved" : "Failed to save", (unsigned)image_len);
+        heap_caps_free(image);
+        image = NULL;
+        status = ok ? CLIP_STORE_SAVED : CLIP_STORE_FAILED;
+    }
+}
+
+bool clip_store_init(clip_store_quiet_fn quiet)
+{
+    if (save_request) return true;
+    quiet_fn = quiet;
+
+    part = esp_partition_find_first(ESP_PARTITION_TYPE_DATA, ESP_PARTITION_SUBTYPE_ANY, "clips");
+    if (!part) {
+        printf("Clips: No \"clips\" partition, clips will not be kept\n");
+        return false;
+    }
+
+    save_request = xSemaphoreCreateBinary();
+    if (!save_request) return false;
+    status = CLIP_STORE_IDLE;
+    return task_topology_start(TASK_CLIP_STORE, store_task, NULL);
+}
+
+bool clip_store_load(void)
+{
+    if (!part) return false;
+
+    uint8_t header[CLIP_IMAGE_HEADER_BYTES];
+    if (esp_partition_read(part, 0, header, sizeof(header)) != ESP_OK) return false;
+    size_t len = clip_library_image_peek(header, sizeof(header));
+    if (len == 0 || len > part->size) return false;
+
+    uint8_t * buf = heap_caps_malloc(len, MALLOC_CAP_SPIRAM);
+    if (!buf) return false;
+    bool ok = esp_partition_read(part, 0, buf, len) == ESP_OK && clip_library_image_read(buf, len);
+    heap_caps_free(buf);
+
+    if (ok) {
+        printf("Clips: Loaded %d clips from flash\n", clip_library_count());
+    } else {
+        printf("Clips: Saved clips are damaged, starting empty\n");
+    }
+    return ok;
+}
+
+bool clip_store_save(void)
+{
+    if (!part || status == CLIP_STORE_SAVING) return false;
+
+    size_t len = clip_library_image_bytes();
+    if (len > part->size) {
+        printf("Clips: %u bytes do not fit the partition\n", (unsigned)len);
+        return false;
+    }
+
+    // The snapshot lets recording carry on, and the library change, while
+    // the flash is written
+    image = heap_caps_malloc(len, MALLOC_CAP_SPIRAM);
+    if (!image) return false;
+    image_len = clip_library_image_write(image);
+
+    status = CLIP_STORE_SAVING;
+    xSemaphoreGive(save_request);
+    return true;
+}
+
+clip_store_status_t clip_store_status(void)
+{
+    return status;
+}
@@ -0,0 +1,32 @@
+#pragma once
+
+#include <stdbool.h>
+
+// Keeps the clip library in the "clips" flash data partition. Saving
+// snapshots the library on the calling thread and writes it from a
+// low-priority task, so the UI never waits for the flash.
+typedef enum {
+    CLIP_STORE_NONE = 0,    // no partition, nothing to do
+    CLIP_STORE_IDLE,
+    CLIP_STORE_SAVING,
+    CLIP_STORE_SAVED,
+    CLIP_STORE_FAILED
+} clip_store_status_t;
+
+// Called on the writer task with true before the first erase and false
+// after the last write. With CONFIG_SPI_FLASH_AUTO_SUSPEND off, erasing
+// stalls every task that runs from flash or PSRAM, audio included, so the
+// app silences its output here. May block until it is quiet.
+typedef void (*clip_store_quiet_fn)(bool quiet);
+
+// Finds the partition and starts the writer task. quiet may be NULL.
+bool clip_store_init(clip_store_quiet_fn quiet);
+
+// Replaces the library with the saved clips, if there are any
+bool clip_store_load(void);
+
+// UI thread. False if a save is already running or the partition is missing
+// or too small. Only the sectors the image needs are erased.
+bool clip_store_save(void);
+
+clip_store_status_t clip_store_status(void);
@@ -0,0 +1,263 @@
+#include "dsp_effects.h"
+#include "audio_platform.h"
+#include <math.h>
+#include <string.h>
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+static dsp_node_t * node_alloc(const char *name, dsp_process_fn fn, size_t state_size)
+{
+    dsp_node_t *node = audio_calloc(1, sizeof(dsp_node_t) + state_size, AUDIO_MEM_FAST);
+    if (!node) return NULL;
+    node->name = name;
+    node->process = fn;
+    node->state = node + 1;
+    node->enabled = true;
+    return node;
+}
+
+static float * delay_line_alloc(int len)
+{
+    return audio_calloc(len, sizeof(float), AUDIO_MEM_BULK);
+}
+
+// ---------------------------------------------------------------------
+// STATE-VARIABLE FILTER (trapezoidal, stable under fast modulation)
+// ---------------------------------------------------------------------
+
+typedef struct {
+    dsp_svf_mode_t mode;
+    float sample_rate;
+    float a1, a2, a3, k;
+    float ic1, ic2;
+} svf_state_t;
+
+static void svf_process(dsp_node_t *node, float *buf, int n)
+{
+    svf_state_t *s = node->state;
+    float a1 = s->a1, a2 = s->a2, a3 = s->a3, k = s->k;
+    float ic1 = s->ic1, ic2 = s->ic2;
+
+    for (int i = 0; i < n; i++) {
+        float v0 = buf[i];
+        float v3 = v0 - ic2;
+        float v1 = a1 * ic1 + a2 * v3;
+        float v2 = ic2 + a2 * ic1 + a3 * v3;
+        ic1 = 2.0f * v1 - ic1;
+        ic2 = 2.0f * v2 - ic2;
+
+        switch (s->mode) {
+            case DSP_SVF_LOWPASS:  buf[i] = v2; break;
+            case DSP_SVF_BANDPASS: buf[i] = v1; break;
+            default:               buf[i] = v0 - k * v1 - v2; break;
+        }
+    }
+    s->ic1 = ic1;
+    s->ic2 = ic2;
+}
+
+void dsp_svf_set(dsp_node_t *node, float cutoff_hz, float q)
+{
+    svf_state_t *s = node->state;
+    float nyq = s->sample_rate * 0.49f;
+    if (cutoff_hz > nyq) cutoff_hz = nyq;
+    if (cutoff_hz < 10.0f) cutoff_hz = 10.0f;
+    if (q < 0.1f) q = 0.1f;
+
+    float g = tanf((float)M_PI * cutoff_hz / s->sample_rate);
+    s->k = 1.0f / q;
+    s->a1 = 1.0f / (1.0f + g * (g + s->k));
+    s->a2 = g * s->a1;
+    s->a3 = g * s->a2;
+}
+
+dsp_node_t * dsp_svf_create(dsp_svf_mode_t mode, float cutoff_hz, float q, float sample_rate)
+{
+    dsp_node_t *node = node_alloc("Filter", svf_process, sizeof(svf_state_t));
+    if (!node) return NULL;
+    svf_state_t *s = node->state;
+    s->mode = mode;
+    s->sample_rate = sample_rate;
+    dsp_svf_set(node, cutoff_hz, q);
+    return node;
+}
+
+// ---------------------------------------------------------------------
+// FEEDBACK DELAY
+// ---------------------------------------------------------------------
+
+typedef struct {
+    float *line;
+    int len;
+    int pos;
+    int delay;
+    float feedback;
+    float mix;
+} delay_state_t;
+
+static void delay_process(dsp_node_t *node, float *buf, int n)
+{
+    delay_state_t *s = node->state;
+    int pos = s->pos;
+    int rd = pos - s->delay;
+    if (rd < 0) rd += s->len;
+
+    for (int i = 0; i < n; i++) {
+        float dry = buf[i];
+        float wet = s->line[rd];
+        s->line[pos] = dry + wet * s->feedback;
+        buf[i] = dry + wet * s->mix;
+        if (++pos == s->len) pos = 0;
+        if (++rd == s->len) rd = 0;
+    }
+    s->pos = pos;
+}
+
+dsp_node_t * dsp_delay_create(float max_sec, float delay_sec, float feedback, float mix, float sample_rate)
+{
+    dsp_node_t *node = node_alloc("Delay", delay_process, sizeof(delay_state_t));
+    if (!node) return NULL;
+    delay_state_t *s = node->state;
+    s->len = (int)(max_sec * sample_rate) + 1;
+    s->line = delay_line_alloc(s->len);
+    if (!s->line) {
+        audio_free(node);
+        return NULL;
+    }
+    s->delay = (int)(delay_sec * sample_rate);
+    if (s->delay < 1) s->delay = 1;
+    if (s->delay >= s->len) s->delay = s->len - 1;
+    s->feedback = feedback;
+    s->mix = mix;
+    return node;
+}
+
+// ---------------------------------------------------------------------
+// FREEVERB-STYLE REVERB (4 damped combs into 2 allpasses)
+// ---------------------------------------------------------------------
+
+#define REVERB_COMBS     4
+#define REVERB_ALLPASSES 2
+
+// Freeverb tunings at 44.1 kHz, rescaled to the actual sample rate
+static const int comb_tuning[REVERB_COMBS] = { 1116, 1188, 1277, 1356 };
+static const int allpass_tuning[REVERB_ALLPASSES] = { 556, 441 };
+
+typedef struct {
+    float *buf;
+    int len;
+    int pos;
+    float store;   // comb damping filter state
+} rev_line_t;
+
+typedef struct {
+    rev_line_t comb[REVERB_COMBS];
+    rev_line_t allpass[REVERB_ALLPASSES];
+    float feedback;
+    float damp;
+    float mix;
+} reverb_state_t;
+
+static void reverb_process(dsp_node_t *node, float *buf, int n)
+{
+    reverb_state_t *s = node->state;
+    float damp1 = s->damp;
+    float damp2 = 1.0f - s->damp;
+
+    for (int i = 0; i < n; i++) {
+        float in = buf[i] * 0.015f; // Freeverb fixed input gain
+        float acc = 0.0f;
+
+        for (int c = 0; c < REVERB_COMBS; c++) {
+            rev_line_t *l = &s->comb[c];
+            float out = l->buf[l->pos];
+            l->store = out * damp2 + l->store * damp1;
+            l->buf[l->pos] = in + l->store * s->feedback;
+            if (++l->pos == l->len) l->pos = 0;
+            acc += out;
+        }
+
+        for (int a = 0; a < REVERB_ALLPASSES; a++) {
+            rev_line_t *l = &s->allpass[a];
+            float bufout = l->buf[l->pos];
+            l->buf[l->pos] = acc + bufout * 0.5f;
+            acc = bufout - acc;
+            if (++l->pos == l->len) l->pos = 0;
+        }
+
+        buf[i] += acc * s->mix;
+    }
+}
+
+dsp_node_t * dsp_reverb_create(float room_size, float damping, float mix, float sample_rate)
+{
+    dsp_node_t *node = node_alloc("Reverb", reverb_process, sizeof(reverb_state_t));
+    if (!node) return NULL;
+    reverb_state_t *s = node->state;
+    float scale = sample_rate / 44100.0f;
+
+    bool ok = true;
+    for (int c = 0; c < REVERB_COMBS; c++) {
+        s->comb[c].len = (int)(comb_tuning[c] * scale);
+        s->comb[c].buf = delay_line_alloc(s->comb[c].len);
+        ok = ok && s->comb[c].buf;
+    }
+    for (int a = 0; a < REVERB_ALLPASSES; a++) {
+        s->allpass[a].len = (int)(allpass_tuning[a] * scale);
+        s->allpass[a].buf = delay_line_alloc(s->allpass[a].len);
+        ok = ok && s->allpass[a].buf;
+    }
+    if (!ok) {
+        for (int c = 0; c < REVERB_COMBS; c++) audio_free(s->comb[c].buf);
+        for (int a = 0; a < REVERB_ALLPASSES; a++) audio_free(s->allpass[a].buf);
+        audio_free(node);
+        return NULL;
+    }
+
+    // Freeverb parameter mapping
+    s->feedback = room_size * 0.28f + 0.7f;
+    s->damp = damping * 0.4f;
+    s->mix = mix * 3.0f;
+    return node;
+}
+
+// ---------------------------------------------------------------------
+// SOFT-CLIP LIMITER
+// ---------------------------------------------------------------------
+
+typedef struct {
+    float knee;
+} softclip_state_t;
+
+// Linear below the knee, then y = 1 - (1 - knee)^2 / (|x| + 1 - 2 knee). The curve
+// meets the linear part with matching slope and approaches 1.0 smoothly, so
+// loud chords saturate gently instead of hard clipping.
+static void softclip_process(dsp_node_t *node, float *buf, int n)
+{
+    softclip_state_t *s = node->state;
+    float knee = s->knee;
+    float c = (1.0f - knee) * (1.0f - knee);
+    float off = 1.0f - 2.0f * knee;
+
+    for (int i = 0; i < n; i++) {
+        float x = buf[i];
+        float a = fabsf(x);
+        if (a > knee) {
+            float y = 1.0f - c / (a + off);
+            buf[i] = x < 0.0f ? -y : y;
+        }
+    }
+}
+
+dsp_node_t * dsp_softclip_create(float knee)
+{
+    dsp_node_t *node = node_alloc("Limiter", softclip_process, sizeof(softclip_state_t));
+    if (!node) return NULL;
+    softclip_state_t *s = node->state;
+    if (knee < 0.1f) knee = 0.1f;
+    if (knee > 0.95f) knee = 0.95f;
+    s->knee = knee;
+    return node;
+}
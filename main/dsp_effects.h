@@ -0,0 +1,17 @@
+#pragma once
+
+#include "dsp_graph.h"
+
+typedef enum {
+    DSP_SVF_LOWPASS = 0,
+    DSP_SVF_BANDPASS,
+    DSP_SVF_HIGHPASS
+} dsp_svf_mode_t;
+
+// All constructors return NULL if allocation fails. Delay lines live in PSRAM.
+dsp_node_t * dsp_svf_create(dsp_svf_mode_t mode, float cutoff_hz, float q, float sample_rate);
+dsp_node_t * dsp_delay_create(float max_sec, float delay_sec, float feedback, float mix, float sample_rate);
+dsp_node_t * dsp_reverb_create(float room_size, float damping, float mix, float sample_rate);
+dsp_node_t * dsp_softclip_create(float knee);
+
+void dsp_svf_set(dsp_node_t *node, float cutoff_hz, float q);
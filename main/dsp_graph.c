@@ -0,0 +1,40 @@
+#include "dsp_graph.h"
+#include "audio_platform.h"
+
+void dsp_graph_init(dsp_graph_t *g)
+{
+    g->count = 0;
+}
+
+bool dsp_graph_add(dsp_graph_t *g, dsp_node_t *node)
+{
+    if (!node || g->count >= DSP_GRAPH_MAX_NODES) return false;
+    g->nodes[g->count++] = node;
+    return true;
+}
+
+void dsp_graph_process(dsp_graph_t *g, float *buf, int n)
+{
+    for (int i = 0; i < g->count; i++) {
+        dsp_node_t *node = g->nodes[i];
+        if (!node->enabled) {
+            node->last_cycles = 0;
+            node->avg_cycles -= node->avg_cycles >> 4;
+            continue;
+        }
+
+        uint32_t start = audio_cycles();
+        node->process(node, buf, n);
+        uint32_t cycles = audio_cycles() - start;
+
+        node->last_cycles = cycles;
+        // Exponential average with a 1/16 weight
+        node->avg_cycles += ((int32_t)(cycles - node->avg_cycles)) >> 4;
+    }
+}
+
+float dsp_node_load(const dsp_node_t *node, int block_size, float sample_rate)
+{
+    float block_cycles = (float)block_size / sample_rate * AUDIO_CPU_HZ;
+    return (float)node->avg_cycles / block_cycles;
+}
@@ -0,0 +1,33 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#define DSP_GRAPH_MAX_NODES 8
+
+typedef struct dsp_node dsp_node_t;
+
+// Processes a whole block in place
+typedef void (*dsp_process_fn)(dsp_node_t *node, float *buf, int n);
+
+struct dsp_node {
+    const char *name;
+    dsp_process_fn process;
+    void *state;
+    volatile bool enabled;   // may be toggled from the UI thread
+    uint32_t last_cycles;    // cost of the most recent block
+    uint32_t avg_cycles;     // smoothed cost per block
+};
+
+// Nodes run in order on the mono synth bus
+typedef struct {
+    dsp_node_t *nodes[DSP_GRAPH_MAX_NODES];
+    int count;
+} dsp_graph_t;
+
+void dsp_graph_init(dsp_graph_t *g);
+bool dsp_graph_add(dsp_graph_t *g, dsp_node_t *node);
+void dsp_graph_process(dsp_graph_t *g, float *buf, int n);
+
+// Smoothed share of the block period the node uses, 0.0 to 1.0+
+float dsp_node_load(const dsp_node_t *node, int block_size, float sample_rate);
@@ -0,0 +1,196 @@
+#include "fft.h"
+#include "audio_platform.h"
+#include <math.h>
+#include <stdbool.h>
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+static fft_plan_t * plans[FFT_MAX_BITS + 1];
+
+static void * fft_alloc(size_t count, size_t size)
+{
+    // Tables are read in every butterfly, so prefer internal RAM
+    void * p = audio_calloc(count, size, AUDIO_MEM_FAST);
+    if (!p) p = audio_calloc(count, size, AUDIO_MEM_BULK);
+    return p;
+}
+
+static void plan_free(fft_plan_t *p)
+{
+    audio_free(p->bitrev);
+    audio_free(p->tw_re);
+    audio_free(p->tw_im);
+    audio_free(p->split_re);
+    audio_free(p->split_im);
+    audio_free(p->hann);
+    audio_free(p);
+}
+
+static fft_plan_t * plan_create(int bits)
+{
+    fft_plan_t * p = fft_alloc(1, sizeof(fft_plan_t));
+    if (!p) return NULL;
+
+    int n = 1 << bits;
+    int m = n / 2;
+    int tw_len = 3 * m / 4 + 1;
+    p->n = n;
+    p->m = m;
+    p->log2m = bits - 1;
+    p->bitrev = fft_alloc(m, sizeof(uint16_t));
+    p->tw_re = fft_alloc(tw_len, sizeof(float));
+    p->tw_im = fft_alloc(tw_len, sizeof(float));
+    p->split_re = fft_alloc(m / 2 + 1, sizeof(float));
+    p->split_im = fft_alloc(m / 2 + 1, sizeof(float));
+    p->hann = fft_alloc(n, sizeof(float));
+    if (!p->bitrev || !p->tw_re || !p->tw_im || !p->split_re || !p->split_im || !p->hann) {
+        plan_free(p);
+        return NULL;
+    }
+
+    for (int i = 0; i < m; i++) {
+        unsigned r = 0;
+        for (int b = 0; b < p->log2m; b++) {
+            if (i & (1 << b)) r |= 1u << (p->log2m - 1 - b);
+        }
+        p->bitrev[i] = (uint16_t)r;
+    }
+    // Computed directly in double per entry, so there is no recurrence error
+    for (int k = 0; k < tw_len; k++) {
+        double a = -2.0 * M_PI * k / m;
+        p->tw_re[k] = (float)cos(a);
+        p->tw_im[k] = (float)sin(a);
+    }
+    for (int k = 0; k <= m / 2; k++) {
+        double a = -2.0 * M_PI * k / n;
+        p->split_re[k] = (float)cos(a);
+        p->split_im[k] = (float)sin(a);
+    }
+    // Same symmetric window the spectrogram always used
+    for (int i = 0; i < n; i++) {
+        p->hann[i] = (float)(0.5 * (1.0 - cos(2.0 * M_PI * i / (n - 1))));
+    }
+    return p;
+}
+
+const fft_plan_t * fft_plan_get(int n)
+{
+    int bits = 0;
+    while ((1 << bits) < n) bits++;
+    if ((1 << bits) != n || bits < FFT_MIN_BITS || bits > FFT_MAX_BITS) return NULL;
+
+    if (!plans[bits]) plans[bits] = plan_create(bits);
+    return plans[bits];
+}
+
+// Complex FFT of p->m interleaved points, decimation in time
+static void fft_complex(const fft_plan_t *p, float *x)
+{
+    int m = p->m;
+
+    for (int i = 0; i < m; i++) {
+        int j = p->bitrev[i];
+        if (i < j) {
+            float tr = x[2 * i], ti = x[2 * i + 1];
+            x[2 * i] = x[2 * j];
+            x[2 * i + 1] = x[2 * j + 1];
+            x[2 * j] = tr;
+            x[2 * j + 1] = ti;
+        }
+    }
+
+    int span = 1;
+    // An odd number of radix-2 stages leaves one over; do it first, its
+    // only twiddle is 1
+    if (p->log2m & 1) {
+        for (int i = 0; i < m; i += 2) {
+            float ar = x[2 * i], ai = x[2 * i + 1];
+            float br = x[2 * i + 2], bi = x[2 * i + 3];
+            x[2 * i] = ar + br;
+            x[2 * i + 1] = ai + bi;
+            x[2 * i + 2] = ar - br;
+            x[2 * i + 3] = ai - bi;
+        }
+        span = 2;
+    }
+
+    // Each radix-4 stage merges two radix-2 stages: blocks of 4 * span from
+    // four sub-transforms of length span
+    for (; span < m; span *= 4) {
+        int stride = m / (4 * span);   // twiddle index step
+        for (int j = 0; j < span; j++) {
+            float w1r = p->tw_re[j * stride],     w1i = p->tw_im[j * stride];
+            float w2r = p->tw_re[2 * j * stride], w2i = p->tw_im[2 * j * stride];
+            float w3r = p->tw_re[3 * j * stride], w3i = p->tw_im[3 * j * stride];
+
+            for (int i = j; i < m; i += 4 * span) {
+                float * x0 = &x[2 * i];
+                float * x1 = &x[2 * (i + span)];
+                float * x2 = &x[2 * (i + 2 * span)];
+                float * x3 = &x[2 * (i + 3 * span)];
+
+                // a = x0, b = W^2j x1, c = W^j x2, d = W^3j x3
+                float ar = x0[0], ai = x0[1];
+                float br = x1[0] * w2r - x1[1] * w2i, bi = x1[0] * w2i + x1[1] * w2r;
+                float cr = x2[0] * w1r - x2[1] * w1i, ci = x2[0] * w1i + x2[1] * w1r;
+                float dr = x3[0] * w3r - x3[1] * w3i, di = x3[0] * w3i + x3[1] * w3r;
+
+                float s0r = ar + br, s0i = ai + bi;
+                float s1r = ar - br, s1i = ai - bi;
+                float s2r = cr + dr, s2i = ci + di;
+                float s3r = cr - dr, s3i = ci - di;
+
+                x0[0] = s0r + s2r;  x0[1] = s0i + s2i;
+                x2[0] = s0r - s2r;  x2[1] = s0i - s2i;
+                // -i * s3 and +i * s3
+                x1[0] = s1r + s3i;  x1[1] = s1i - s3r;
+                x3[0] = s1r - s3i;  x3[1] = s1i + s3r;
+            }
+        }
+    }
+}
+
+void fft_real(const fft_plan_t *p, float *data)
+{
+    int m = p->m;
+
+    // Even samples are the real parts, odd samples the imaginary parts
+    fft_complex(p, data);
+
+    float z0r = data[0], z0i = data[1];
+    data[0] = z0r + z0i;
+    data[1] = z0r - z0i;
+
+    // Untangle bins k and m - k together: X[k] = E[k] + W^k O[k]
+    for (int k = 1; k <= m / 2; k++) {
+        int q = m - k;
+        float ar = data[2 * k], ai = data[2 * k + 1];
+        float br = data[2 * q], bi = data[2 * q + 1];
+
+        float er = 0.5f * (ar + br), ei = 0.5f * (ai - bi);
+        float or_ = 0.5f * (ai + bi), oi = -0.5f * (ar - br);
+        float wr = p->split_re[k], wi = p->split_im[k];
+        float tr = wr * or_ - wi * oi;
+        float ti = wr * oi + wi * or_;
+
+        data[2 * k] = er + tr;
+        data[2 * k + 1] = ei + ti;
+        // Bin m - k: E is conjugated and W^(m-k) = -conj(W^k)
+        data[2 * q] = er - tr;
+        data[2 * q + 1] = -ei + ti;
+    }
+}
+
+void fft_magnitude(const fft_plan_t *p, float *data, float *mags)
+{
+    for (int i = 0; i < p->n; i++) data[i] *= p->hann[i];
+    fft_real(p, data);
+
+    mags[0] = fabsf(data[0]);
+    for (int k = 1; k < p->m; k++) {
+        float re = data[2 * k], im = data[2 * k + 1];
+        mags[k] = sqrtf(re * re + im * im);
+    }
+}
@@ -0,0 +1,35 @@
+#pragma once
+
+#include <stdint.h>
+
+// Real-input FFT. N reals are packed into an N/2-point complex transform
+// built from radix-4 stages (plus one radix-2 stage for odd log2 sizes).
+#define FFT_MIN_BITS 4
+#define FFT_MAX_BITS 12
+
+typedef struct {
+    int n;                  // real input length
+    int m;                  // complex transform length, n / 2
+    int log2m;
+    uint16_t * bitrev;      // m entries
+    float * tw_re;          // exp(-2 pi i k / m), k < 3m/4
+    float * tw_im;
+    float * split_re;       // exp(-2 pi i k / n), k < m/2 + 1
+    float * split_im;
+    float * hann;           // n entries
+} fft_plan_t;
+
+// Tables for size n (a power of two between 2^FFT_MIN_BITS and
+// 2^FFT_MAX_BITS), built on first use and kept. Returns NULL for other
+// sizes or when out of memory. Get each size once from a single task
+// before sharing it; the returned plan is read-only and thread-safe.
+const fft_plan_t * fft_plan_get(int n);
+
+// In place. Input is n real samples; output is packed as data[0] = X[0],
+// data[1] = X[n/2] (both real) and data[2k], data[2k+1] = Re, Im of X[k]
+// for 0 < k < n/2.
+void fft_real(const fft_plan_t *p, float *data);
+
+// Applies the Hann window to the n samples in data, transforms them in
+// place and writes n/2 bin magnitudes (bins 0 .. n/2 - 1) to mags.
+void fft_magnitude(const fft_plan_t *p, float *data, float *mags);
@@ -0,0 +1,149 @@
+#include "freq_map.h"
+#include "audio_platform.h"
+#include <math.h>
+#include <stdbool.h>
+
+#define FREQ_MAP_CACHE 4
+
+static freq_map_t * cache[FREQ_MAP_CACHE];
+
+static float hz_to_mel(float hz)
+{
+    return 2595.0f * log10f(1.0f + hz / 700.0f);
+}
+
+static float mel_to_hz(float mel)
+{
+    return 700.0f * (powf(10.0f, mel / 2595.0f) - 1.0f);
+}
+
+// Centre of row r (0 = lowest) in fractional bins. Rows span bin 1 to the
+// last bin below Nyquist; -1 and rows give the outer triangle edges.
+static float row_centre(const freq_map_t *m, int r)
+{
+    int num_bins = m->fft_size / 2;
+    float t = (float)r / (float)(m->rows - 1);
+    if (m->scale == FREQ_SCALE_MEL) {
+        float bin_hz = m->sample_rate / (float)m->fft_size;
+        float lo = hz_to_mel(bin_hz);
+        float hi = hz_to_mel(bin_hz * (float)(num_bins - 1));
+        return mel_to_hz(lo + (hi - lo) * t) / bin_hz;
+    }
+    return expf(t * logf((float)(num_bins - 1)));
+}
+
+// Visits the weights of row r; fills bins/weights when they are non-NULL
+// and returns the count
+static int row_weights(const freq_map_t *m, int r, uint16_t *bins, float *weights)
+{
+    int num_bins = m->fft_size / 2;
+    float c = row_centre(m, r);
+    float lo = row_centre(m, r - 1);
+    float hi = row_centre(m, r + 1);
+
+    int count = 0;
+    float sum = 0.0f;
+    for (int b = (int)ceilf(lo); b <= (int)floorf(hi); b++) {
+        if (b < 1 || b >= num_bins) continue;
+        float w = (float)b <= c ? ((float)b - lo) / (c - lo) : (hi - (float)b) / (hi - c);
+        if (w <= 0.0f) continue;
+        if (bins) {
+            bins[count] = (uint16_t)b;
+            weights[count] = w;
+        }
+        sum += w;
+        count++;
+    }
+
+    // Low rows are narrower than a bin: interpolate the two nearest bins
+    if (count == 0) {
+        int b0 = (int)c;
+        if (b0 < 1) b0 = 1;
+        if (b0 > num_bins - 2) b0 = num_bins - 2;
+        float frac = c - (float)b0;
+        if (frac < 0.0f) frac = 0.0f;
+        if (frac > 1.0f) frac = 1.0f;
+        if (bins) {
+            bins[0] = (uint16_t)b0;
+            weights[0] = 1.0f - frac;
+            bins[1] = (uint16_t)(b0 + 1);
+            weights[1] = frac;
+        }
+        return 2;
+    }
+
+    if (weights) {
+        for (int i = 0; i < count; i++) weights[i] /= sum;
+    }
+    return count;
+}
+
+static void map_free(freq_map_t *m)
+{
+    audio_free(m->row_start);
+    audio_free(m->bin);
+    audio_free(m->weight);
+    audio_free(m);
+}
+
+static freq_map_t * map_create(int fft_size, int rows, freq_scale_t scale, float sample_rate)
+{
+    freq_map_t * m = audio_calloc(1, sizeof(freq_map_t), AUDIO_MEM_FAST);
+    if (!m) return NULL;
+    m->fft_size = fft_size;
+    m->rows = rows;
+    m->scale = scale;
+    m->sample_rate = sample_rate;
+
+    // Two passes: count the weights, then fill them
+    int total = 0;
+    for (int r = 0; r < rows; r++) total += row_weights(m, r, NULL, NULL);
+
+    m->row_start = audio_calloc(rows + 1, sizeof(uint16_t), AUDIO_MEM_FAST);
+    m->bin = audio_calloc(total, sizeof(uint16_t), AUDIO_MEM_FAST);
+    m->weight = audio_calloc(total, sizeof(float), AUDIO_MEM_FAST);
+    if (!m->row_start || !m->bin || !m->weight || total > UINT16_MAX) {
+        map_free(m);
+        return NULL;
+    }
+
+    int pos = 0;
+    for (int r = 0; r < rows; r++) {
+        m->row_start[r] = (uint16_t)pos;
+        pos += row_weights(m, r, &m->bin[pos], &m->weight[pos]);
+    }
+    m->row_start[rows] = (uint16_t)pos;
+    return m;
+}
+
+const freq_map_t * freq_map_get(int fft_size, int rows, freq_scale_t scale, float sample_rate)
+{
+    if (fft_size < 8 || rows < 2) return NULL;
+
+    for (int i = 0; i < FREQ_MAP_CACHE; i++) {
+        freq_map_t * m = cache[i];
+        if (m && m->fft_size == fft_size && m->rows == rows &&
+            m->scale == scale && m->sample_rate == sample_rate) {
+            return m;
+        }
+    }
+    for (int i = 0; i < FREQ_MAP_CACHE; i++) {
+        if (!cache[i]) {
+            cache[i] = map_create(fft_size, rows, scale, sample_rate);
+            return cache[i];
+        }
+    }
+    return NULL;
+}
+
+void freq_map_apply(const freq_map_t *map, const float *mags, float *out)
+{
+    for (int r = 0; r < map->rows; r++) {
+        float energy = 0.0f;
+        for (int i = map->row_start[r]; i < map->row_start[r + 1]; i++) {
+            float mag = mags[map->bin[i]];
+            energy += map->weight[i] * mag * mag;
+        }
+        out[map->rows - 1 - r] = sqrtf(energy);
+    }
+}
@@ -0,0 +1,31 @@
+#pragma once
+
+#include <stdint.h>
+
+// Maps FFT bins onto display rows through a sparse triangular filterbank,
+// so each row sums the energy of the bins around its centre frequency
+// instead of sampling a single bin.
+typedef enum {
+    FREQ_SCALE_LOG = 0,     // rows evenly spaced in log frequency
+    FREQ_SCALE_MEL
+} freq_scale_t;
+
+typedef struct {
+    int fft_size;
+    int rows;
+    freq_scale_t scale;
+    float sample_rate;
+    // Row r uses weights row_start[r] .. row_start[r + 1] - 1 (CSR layout).
+    // Weights of a row sum to 1.
+    uint16_t * row_start;   // rows + 1 entries
+    uint16_t * bin;
+    float * weight;
+} freq_map_t;
+
+// Built on first use and cached, like FFT plans. Returns NULL when out of
+// memory or the cache is full.
+const freq_map_t * freq_map_get(int fft_size, int rows, freq_scale_t scale, float sample_rate);
+
+// mags holds fft_size / 2 bin magnitudes. Writes one RMS magnitude per row,
+// row 0 being the highest frequency so it lines up with the top of a canvas.
+void freq_map_apply(const freq_map_t *map, const float *mags, float *out);
@@ -0,0 +1,79 @@
+#include "loudness.h"
+#include <string.h>
+
+// Release back towards unity with a time constant of 2^9 samples (32 ms at
+// 16 kHz). Attack closes 1/4 of the gap per sample, which is within 0.01%
+// of the target after the 32-sample look-ahead.
+#define LIMITER_RELEASE_SHIFT 9
+#define LIMITER_ATTACK_SHIFT  2
+
+void loudness_hist_reset(loudness_hist_t *h)
+{
+    memset(h, 0, sizeof(*h));
+}
+
+void loudness_hist_add(loudness_hist_t *h, const int16_t *samples, int n)
+{
+    for (int i = 0; i < n; i++) {
+        int val = samples[i];
+        if (val < 0) val = -val;
+        int bin = (val * LOUDNESS_BINS) >> 15;
+        if (bin >= LOUDNESS_BINS) bin = LOUDNESS_BINS - 1;
+        h->bins[bin]++;
+    }
+    h->count += n;
+}
+
+int loudness_hist_percentile(const loudness_hist_t *h, int pct)
+{
+    uint32_t target = (uint32_t)(((uint64_t)h->count * pct) / 100);
+    uint32_t count = 0;
+    for (int i = 0; i < LOUDNESS_BINS; i++) {
+        count += h->bins[i];
+        if (count >= target && count > 0) return (i * 32768) / LOUDNESS_BINS;
+    }
+    return 32767;
+}
+
+void limiter_init(limiter_t *l, float gain, int ceiling)
+{
+    memset(l, 0, sizeof(*l));
+    l->gain = (int32_t)(gain * (float)(1 << LIMITER_GAIN_BITS) + 0.5f);
+    l->ceiling = ceiling > 32767 ? 32767 : ceiling;
+    l->env = LIMITER_UNITY;
+    for (int i = 0; i < LIMITER_LOOKAHEAD; i++) l->need[i] = LIMITER_UNITY;
+}
+
+void limiter_process(limiter_t *l, const int16_t *in, int16_t *out, int n)
+{
+    for (int i = 0; i < n; i++) {
+        // Q8 gain of at most a few hundred keeps this within 32 bits
+        int32_t x = (in[i] * l->gain) >> LIMITER_GAIN_BITS;
+        int32_t mag = x < 0 ? -x : x;
+        int32_t need = mag > l->ceiling ? (int32_t)(((int64_t)l->ceiling << 15) / mag) : LIMITER_UNITY;
+
+        // Strongest reduction any sample in the look-ahead needs, including
+        // the oldest one, which is about to leave
+        int32_t target = LIMITER_UNITY;
+        for (int k = 0; k < LIMITER_LOOKAHEAD; k++) {
+            if (l->need[k] < target) target = l->need[k];
+        }
+        if (target < l->env) {
+            l->env -= (l->env - target + (1 << LIMITER_ATTACK_SHIFT) - 1) >> LIMITER_ATTACK_SHIFT;
+        } else {
+            l->env += (target - l->env) >> LIMITER_RELEASE_SHIFT;
+        }
+
+        // Oldest sample leaves the delay line as the newest enters
+        int32_t y = l->delay[l->pos];
+        l->delay[l->pos] = x;
+        l->need[l->pos] = need;
+        l->pos = (l->pos + 1) % LIMITER_LOOKAHEAD;
+
+        y = (int32_t)(((int64_t)y * l->env) >> 15);
+        // The ramp can leave a peak a hair over the ceiling; never wrap
+        if (y > l->ceiling) y = l->ceiling;
+        else if (y < -l->ceiling) y = -l->ceiling;
+        out[i] = (int16_t)y;
+    }
+}
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <stdint.h>
+
+// Amplitude histogram kept up to date as samples arrive, so a percentile
+// gain is ready the moment a take ends.
+#define LOUDNESS_BINS 100   // bin i holds |x| in [i, i + 1) * 32768 / 100
+
+typedef struct {
+    uint32_t bins[LOUDNESS_BINS];
+    uint32_t count;
+} loudness_hist_t;
+
+void loudness_hist_reset(loudness_hist_t *h);
+void loudness_hist_add(loudness_hist_t *h, const int16_t *samples, int n);
+
+// Lower edge of the bin where the cumulative count reaches pct percent of
+// the samples, i.e. the pct-th percentile amplitude at bin resolution.
+// 32767 for an empty histogram.
+int loudness_hist_percentile(const loudness_hist_t *h, int pct);
+
+// Fixed-point gain stage with a look-ahead peak limiter. Input is scaled by
+// a static gain, then delayed by LIMITER_LOOKAHEAD samples while the gain
+// reduction for upcoming peaks ramps in, so loud peaks are turned down
+// smoothly instead of clipped.
+#define LIMITER_LOOKAHEAD 32    // samples, 2 ms at 16 kHz
+#define LIMITER_GAIN_BITS 8     // static gain is Q8
+#define LIMITER_UNITY     32768 // gain reduction is Q15
+
+typedef struct {
+    int32_t gain;           // Q8 static gain
+    int32_t ceiling;        // output peak, at most 32767
+    int32_t env;            // Q15 gain reduction being applied
+    int pos;
+    int32_t delay[LIMITER_LOOKAHEAD];   // gained samples waiting for output
+    int32_t need[LIMITER_LOOKAHEAD];    // Q15 reduction each of them needs
+} limiter_t;
+
+void limiter_init(limiter_t *l, float gain, int ceiling);
+
+// In place is fine. Output lags input by LIMITER_LOOKAHEAD samples.
+void limiter_process(limiter_t *l, const int16_t *in, int16_t *out, int n);
@@ -1,12 +1,16 @@
 #include <stdio.h>
+#include <stdatomic.h>
+#include <string.h>
 #include <time.h>
 #include <sys/time.h>
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
+#include "freertos/semphr.h"
+#include "esp_timer.h"
+#include "esp_cpu.h"
 #include "bsp/esp-bsp.h"
 #include "lvgl.h"
 #include "esp_codec_dev.h"
-#include "esp_codec_dev_defaults.h"
 
 // Networking & Time Includes
 #include "nvs_flash.h"
@@ -22,6 +26,28 @@
 // Notes App
 #include "notes_app.h"
 
+// Synth
+#include "audio_engine.h"
+#include "synth.h"
+#include "audio_diag.h"
+#include "audio_io.h"
+#include "sequencer.h"
+#include "recorder.h"
+#include "audio_ring.h"
+#include "loudness.h"
+#include "clip_codec.h"
+#include "clip_library.h"
+#include "clip_store.h"
+
+// Spectrum analysis
+#include "spectro_blit.h"
+#include "stft_cache.h"
+#include "spectro_job.h"
+#include "spectro_live.h"
+
+// Task placement
+#include "task_topology.h"
+
 // Check if the secrets file exists before trying to include it
 #if __has_include("secrets.h")
     #include "secrets.h"
@@ -53,10 +79,13 @@
 // ---------------------------------------------------------------------
 // GLOBALS
 // ---------------------------------------------------------------------
-static esp_codec_dev_handle_t spk_codec_dev = NULL;
-static esp_codec_dev_handle_t mic_codec_dev = NULL;
-
 static lv_obj_t * time_label_synth;
+static lv_obj_t * synth_load_bar = NULL;
+static lv_obj_t * synth_load_label = NULL;
+static lv_obj_t * seq_step_btns[SEQ_STEPS];
+static lv_obj_t * seq_bpm_label = NULL;
+static int seq_edit_note = 0;    // last key pressed, written into tapped steps
+static int seq_shown_step = -1;
 static lv_obj_t * time_label_menu;
 static lv_obj_t * time_label_record;
 
@@ -65,8 +94,34 @@ static lv_obj_t * synth_scr;
 static lv_obj_t * clock_scr;
 static lv_obj_t * record_scr;
 static lv_obj_t * record_canvas = NULL;
+// Second view of the same pixels, placed after record_canvas, so the live
+// analyzer can scroll its circular buffer by moving both
+static lv_obj_t * record_canvas_wrap = NULL;
+static lv_obj_t * record_live_label = NULL;
+static lv_obj_t * record_sd_label = NULL;
+static lv_obj_t * record_clips_dd = NULL;
+static lv_obj_t * record_clips_label = NULL;
 static uint8_t * record_canvas_raw_buf = NULL;
 static uint8_t * record_canvas_aligned_buf = NULL;
+#define REC_CANVAS_W 640
+#define REC_CANVAS_H 240
+// Each take's STFT is computed once, one frame per REC_STFT_HOP samples,
+// and the canvas shows a resampled window of it that can be zoomed and
+// panned without another FFT
+#define REC_STFT_HOP        128
+#define REC_VIEW_MIN_FRAMES 16
+static stft_cache_t record_stft;
+static bool record_stft_ok = false;
+static uint32_t record_job_id = 0;
+static int record_frames_done = 0;
+static float record_view_start = 0.0f;    // first visible frame
+static float record_view_len = 1.0f;      // frames across the canvas
+// Live analyzer codes, column-major and circular, and frames already drawn
+static uint8_t * record_live_codes = NULL;
+static uint32_t record_live_drawn = 0;
+// One STFT frame per hop: 512 samples is 31.25 frames per second at 16 kHz
+#define LIVE_FFT_SIZE 1024
+#define LIVE_HOP      512
 
 static lv_obj_t * clock_hour_hand;
 static lv_obj_t * clock_min_hand;
@@ -104,6 +159,21 @@ static lv_obj_t * time_label_joystick = NULL;
 static adc_oneshot_unit_handle_t joystick_adc_handle = NULL;
 static bool joystick_adc_init = false;
 
+// Audio diagnostics screen widgets
+static lv_obj_t * diag_scr            = NULL;
+static lv_obj_t * diag_stats_label    = NULL;
+static lv_obj_t * diag_chart          = NULL;
+static lv_chart_series_t * diag_series = NULL;
+static lv_obj_t * time_label_diag     = NULL;
+static lv_obj_t * diag_fx_labels[DSP_GRAPH_MAX_NODES];
+
+// System tasks screen widgets
+static lv_obj_t * tasks_scr           = NULL;
+static lv_obj_t * tasks_core_bars[portNUM_PROCESSORS];
+static lv_obj_t * tasks_core_labels[portNUM_PROCESSORS];
+static lv_obj_t * tasks_list_labels[3]; // name, core, load columns
+static lv_obj_t * time_label_tasks    = NULL;
+
 // ---------------------------------------------------------------------
 // SYNTHESIS & AUDIO & RECORDING
 // ---------------------------------------------------------------------
@@ -113,207 +183,269 @@ static bool joystick_adc_init = false;
 #define M_PI 3.14159265358979323846
 #endif
 
-// Recording State
+// Recording State. Takes stream to the SD card without a length limit; the
+// first REC_MAX_SEC seconds are also kept in RAM for reverse playback and
+// the spectrogram.
 #define REC_MAX_SEC 5
 #define REC_BUFFER_SAMPLES (SAMPLE_RATE * REC_MAX_SEC)
+#define CAPTURE_BLOCK_SIZE 256
 static int16_t * rec_buffer = NULL;
+static bool rec_sd_ok = false;
+// Set by capture_task when the recorder refused a take
+static atomic_bool rec_sd_start_failed = false;
 static volatile int rec_sample_count = 0;
-static volatile bool is_recording = false;
-static volatile bool is_playing_reverse = false;
-static volatile int rec_play_idx = 0;
+static atomic_bool is_recording = false;
+// Stop handshake: the UI bumps rec_stop_seq after clearing is_recording,
+// and capture_task copies it to capture_stop_ack once it has seen the stop,
+// which is after its last append to rec_buffer and rec_hist. The take is
+// finalized only when the two match.
+static atomic_uint rec_stop_seq = 0;
+static atomic_uint capture_stop_ack = 0;
+// Also held until the recorder has closed the take's file, since it
+// refuses to start the next one before then
+static bool rec_finish_pending = false;
 static volatile float rec_multiplier = 1.0f;
-
-#define MAX_VOICES 5
-
-typedef enum {
-    ENV_IDLE = 0,
-    ENV_ATTACK,
-    ENV_DECAY,
-    ENV_SUSTAIN,
-    ENV_RELEASE
-} env_state_t;
-
-typedef struct {
-    float phase;
-    float freq;
-    int note_idx;
-    env_state_t env_state;
-    float env_val;
-} voice_t;
-
-static voice_t voices[MAX_VOICES];
-
-volatile int synth_waveform = 1; // 0=Sine, 1=Square, 2=Saw
-volatile float synth_volume = 0.4f;
-
-// ADSR parameters
-volatile float env_a_time = 0.1f;  // 0.01 to 2.0s
-volatile float env_d_time = 0.1f;  // 0.01 to 2.0s
-volatile float env_s_level = 0.5f; // 0.0 to 1.0
-volatile float env_r_time = 0.3f;  // 0.01 to 2.0s
-
-static void note_on(int note_idx, float freq) {
-    int target_v = -1;
-    // Try to find a free voice
-    for (int v = 0; v < MAX_VOICES; v++) {
-        if (voices[v].env_state == ENV_IDLE) {
-            target_v = v; break;
-        }
-    }
-    // If none free, find one in RELEASE
-    if (target_v == -1) {
-        for (int v = 0; v < MAX_VOICES; v++) {
-            if (voices[v].env_state == ENV_RELEASE) {
-                target_v = v; break;
-            }
-        }
-    }
-    // If still none, steal voice 0 (or oldest, but keep simple)
-    if (target_v == -1) target_v = 0;
-
-    voices[target_v].freq = freq;
-    voices[target_v].note_idx = note_idx;
-    voices[target_v].env_state = ENV_ATTACK;
-    voices[target_v].phase = 0.0f;
-    // Don't reset env_val to 0 to avoid clicking, let it rise from current
-}
-
-static void note_off(int note_idx) {
-    for (int v = 0; v < MAX_VOICES; v++) {
-        if (voices[v].note_idx == note_idx &&
-            voices[v].env_state != ENV_IDLE &&
-            voices[v].env_state != ENV_RELEASE) {
-            voices[v].env_state = ENV_RELEASE;
-        }
-    }
-}
+// Amplitudes of what is in rec_buffer, kept by capture_task as it fills
+static loudness_hist_t rec_hist;
+// Clip to play in reverse. The UI marks rec_play_gen WRITING while it sets
+// the fields, then publishes a new generation with PLAYING set in a release
+// store; audio_task reads it with an acquire load and restarts its player
+// and limiter when the generation changes. Only the UI clears PLAYING to
+// stop, except that audio_task clears it at the end of a clip if the word
+// still holds the generation it played.
+#define REC_PLAY_PLAYING  1u
+#define REC_PLAY_WRITING  2u
+#define REC_PLAY_GEN_STEP 4u
+static clip_codec_t rec_play_codec = CLIP_CODEC_PCM16;
+static const uint8_t * rec_play_data = NULL;
+static int rec_play_samples = 0;
+static float rec_play_gain = 1.0f;
+static atomic_uint rec_play_gen = 0;
+// Playback stop handshake, the same as for capture: the UI clears
+// PLAYING and bumps rec_play_stop_seq, and audio_task copies the
+// sequence to audio_play_stop_ack from a block that does not touch the clip
+// data. Until then the clip must stay in the library arena.
+static atomic_uint rec_play_stop_seq = 0;
+static atomic_uint audio_play_stop_ack = 0;
+// Arena for compressed takes: about 4 minutes of ADPCM at 16 kHz
+#define CLIP_ARENA_BYTES (1024 * 1024)
+static bool clips_ok = false;
+static clip_codec_t record_codec = CLIP_CODEC_ADPCM;
+// Reverse playback peaks are limited to about -0.8 dBFS
+#define REVERSE_CEILING 30000
+
+// Live input. capture_task pushes mic blocks here while monitoring and
+// audio_task mixes them into the output.
+#define MIC_RING_SAMPLES   2048
+#define MONITOR_MAX_QUEUED (3 * CAPTURE_BLOCK_SIZE)
+static audio_ring_t mic_ring;
+static bool mic_ring_ok = false;
+static volatile bool monitor_input = false;
+
+// Samples per audio block. SYNTH_BLOCK_SIZE is the normal mode; the
+// diagnostics screen can drop it to 128/64/32 for low-latency playing.
+// The UI asks through audio_block_req and audio_task switches between two
+// blocks, resizing the I2S DMA queue to match. A blocking write returns
+// once its block is at the end of that queue, so the block starts leaving
+// the codec the rest of the queue later.
+static volatile int audio_block_size = SYNTH_BLOCK_SIZE;
+static atomic_int audio_block_req = SYNTH_BLOCK_SIZE;
+// Held by capture_task around each microphone read and by audio_task while
+// it rebuilds the I2S channels
+static SemaphoreHandle_t audio_io_lock = NULL;
+
+// Output muting around clip library saves. Erasing flash stalls audio_task,
+// and a stalled I2S channel keeps replaying its DMA buffers, so the output
+// is faded out and the whole DMA queue filled with silence first.
+static atomic_bool audio_mute = false;
+static atomic_int audio_silent_frames = 0;
 
 static void audio_task(void *pvParameters)
 {
-    size_t num_samples = 256;
-    int16_t *audio_buffer = malloc(num_samples * sizeof(int16_t));
-    float sample_rate_f = (float)SAMPLE_RATE;
+    int16_t *audio_buffer = malloc(SYNTH_BLOCK_SIZE * sizeof(int16_t));
+    int16_t *input_buffer = malloc(SYNTH_BLOCK_SIZE * sizeof(int16_t));
+    int16_t *reverse_buffer = malloc(SYNTH_BLOCK_SIZE * sizeof(int16_t));
+    static limiter_t reverse_limiter;
+    static clip_player_t reverse_player;
+    unsigned reverse_gen = 0;
+    int reverse_tail = 0;
+    bool was_muted = false;
+    int64_t prev_block_us = esp_timer_get_time();
+    int64_t prev_write_us = 0;
 
     while (1) {
-        if (is_recording) {
-            if (mic_codec_dev && rec_buffer) {
-                esp_codec_dev_read(mic_codec_dev, audio_buffer, num_samples * sizeof(int16_t));
-                for(int i=0; i<num_samples; i++) {
-                    if (rec_sample_count < REC_BUFFER_SAMPLES) {
-                        rec_buffer[rec_sample_count++] = audio_buffer[i];
-                    }
-                }
+        int want = atomic_load(&audio_block_req);
+        if (want != audio_block_size && audio_io_lock) {
+            xSemaphoreTake(audio_io_lock, portMAX_DELAY);
+            if (audio_io_set_block(want)) audio_block_size = want;
+            xSemaphoreGive(audio_io_lock);
+            // The queue restarts empty, which is not an underrun
+            prev_write_us = 0;
+        }
+        esp_codec_dev_handle_t spk = audio_io_speaker();
+
+        size_t num_samples = audio_block_size;
+        int64_t period_us = (int64_t)num_samples * 1000000 / SAMPLE_RATE;
+
+        // UI events stamped since the previous block start land in this block
+        int64_t block_us = esp_timer_get_time();
+        int64_t window_us = prev_block_us;
+        prev_block_us = block_us;
+
+        if (!spk) {
+            vTaskDelay(pdMS_TO_TICKS(100));
+            continue;
+        }
+
+        uint32_t render_start = esp_cpu_get_cycle_count();
+        audio_engine_render(audio_buffer, num_samples, window_us);
+
+        // Live input, taken a whole block at a time once enough has arrived.
+        // The backlog is trimmed so monitoring latency stays bounded if this
+        // loop was held up while capture kept running.
+        int num_in = 0;
+        if (mic_ring_ok && input_buffer) {
+            int queued = audio_ring_available(&mic_ring);
+            if (!monitor_input) {
+                audio_ring_skip(&mic_ring, queued);
             } else {
-                vTaskDelay(pdMS_TO_TICKS(10));
+                if (queued > MONITOR_MAX_QUEUED) audio_ring_skip(&mic_ring, queued - MONITOR_MAX_QUEUED);
+                if (queued >= (int)num_samples) num_in = audio_ring_read(&mic_ring, input_buffer, num_samples);
             }
-            continue;
         }
 
-        if (is_playing_reverse) {
-            if (!spk_codec_dev) {
-                vTaskDelay(pdMS_TO_TICKS(10));
-                continue;
+        // Reverse playback goes through the look-ahead limiter, which
+        // needs LIMITER_LOOKAHEAD samples of silence after the take to
+        // flush out its last samples
+        unsigned play_stop_seq = atomic_load(&rec_play_stop_seq);
+        unsigned play = atomic_load_explicit(&rec_play_gen, memory_order_acquire);
+        bool reverse = (play & REC_PLAY_PLAYING) && reverse_buffer;
+        if (reverse && play != reverse_gen) {
+            clip_codec_t codec = rec_play_codec;
+            const uint8_t * data = rec_play_data;
+            int samples = rec_play_samples;
+            float gain = rec_play_gain;
+            // A new clip handed over while the fields were copied is
+            // picked up on the next block
+            atomic_thread_fence(memory_order_acquire);
+            if (atomic_load_explicit(&rec_play_gen, memory_order_relaxed) == play) {
+                reverse_gen = play;
+                clip_player_start_reverse(&reverse_player, codec, data, samples);
+                limiter_init(&reverse_limiter, gain, REVERSE_CEILING);
+                reverse_tail = LIMITER_LOOKAHEAD;
+            } else {
+                reverse = false;
             }
-            for (size_t i = 0; i < num_samples; i++) {
-                if (rec_play_idx >= 0 && rec_buffer) {
-                    int32_t amplified_sample = (int32_t)(rec_buffer[rec_play_idx--] * rec_multiplier);
-                    if (amplified_sample > 32767) amplified_sample = 32767;
-                    else if (amplified_sample < -32768) amplified_sample = -32768;
-                    audio_buffer[i] = (int16_t)amplified_sample;
-                } else {
-                    audio_buffer[i] = 0;
-                    if (i == (num_samples - 1)) {
-                        is_playing_reverse = false;
-                    }
-                }
+        }
+        if (!reverse) atomic_store(&audio_play_stop_ack, play_stop_seq);
+        if (reverse) {
+            int got = clip_player_read_reverse(&reverse_player, reverse_buffer, num_samples);
+            for (size_t i = got; i < num_samples; i++) {
+                reverse_buffer[i] = 0;
+                if (reverse_tail > 0) reverse_tail--;
+            }
+            limiter_process(&reverse_limiter, reverse_buffer, reverse_buffer, num_samples);
+            if (got < (int)num_samples && reverse_tail == 0) {
+                // A Play press during this block has published a newer
+                // generation, which must keep playing
+                unsigned played = reverse_gen;
+                atomic_compare_exchange_strong(&rec_play_gen, &played, reverse_gen & ~REC_PLAY_PLAYING);
             }
-            esp_codec_dev_write(spk_codec_dev, audio_buffer, num_samples * sizeof(int16_t));
-            continue;
         }
 
-        if (!spk_codec_dev) {
-            vTaskDelay(pdMS_TO_TICKS(100));
-            continue;
+        // Reverse playback and live input are mixed on top of the synth
+        if (reverse || num_in > 0) {
+            for (size_t i = 0; i < num_samples; i++) {
+                int32_t mixed_sample = audio_buffer[i];
+                if (reverse) mixed_sample += reverse_buffer[i];
+                if ((int)i < num_in) mixed_sample += input_buffer[i];
+                if (mixed_sample > 32767) mixed_sample = 32767;
+                else if (mixed_sample < -32768) mixed_sample = -32768;
+                audio_buffer[i] = (int16_t)mixed_sample;
+            }
         }
+        audio_diag_record_load(esp_cpu_get_cycle_count() - render_start, num_samples, SAMPLE_RATE);
 
-        int wav_local = synth_waveform;
-        float vol_local = synth_volume;
-        float a_time = env_a_time < 0.01f ? 0.01f : env_a_time;
-        float d_time = env_d_time < 0.01f ? 0.01f : env_d_time;
-        float s_lvl = env_s_level < 0.01f ? 0.01f : env_s_level;
-        float r_time = env_r_time < 0.01f ? 0.01f : env_r_time;
-
-        float a_rate = 1.0f / (a_time * sample_rate_f);
-        float d_rate = (1.0f - s_lvl) / (d_time * sample_rate_f);
-        float r_rate = s_lvl / (r_time * sample_rate_f);
-
-        for (size_t i = 0; i < num_samples; i++) {
-            float mixed_sample = 0.0f;
-
-            for (int v = 0; v < MAX_VOICES; v++) {
-                if (voices[v].env_state == ENV_IDLE) continue;
-
-                // Process Envelope
-                switch(voices[v].env_state) {
-                    case ENV_ATTACK:
-                        voices[v].env_val += a_rate;
-                        if (voices[v].env_val >= 1.0f) {
-                            voices[v].env_val = 1.0f;
-                            voices[v].env_state = ENV_DECAY;
-                        }
-                        break;
-                    case ENV_DECAY:
-                        voices[v].env_val -= d_rate;
-                        if (voices[v].env_val <= s_lvl) {
-                            voices[v].env_val = s_lvl;
-                            voices[v].env_state = ENV_SUSTAIN;
-                        }
-                        break;
-                    case ENV_SUSTAIN:
-                        // Hold level
-                        voices[v].env_val = s_lvl;
-                        break;
-                    case ENV_RELEASE:
-                        // Release from current envelope value
-                        voices[v].env_val -= r_rate;
-                        if (voices[v].env_val <= 0.0f) {
-                            voices[v].env_val = 0.0f;
-                            voices[v].env_state = ENV_IDLE;
-                        }
-                        break;
-                    default: break;
-                }
-
-                if(voices[v].env_state == ENV_IDLE) continue;
-
-                // Oscillator
-                float sample_p = 0.0f;
-                if (wav_local == 0) { // Sine
-                    sample_p = sinf(2.0f * (float)M_PI * voices[v].phase);
-                } else if (wav_local == 1) { // Square
-                    sample_p = (voices[v].phase < 0.5f) ? 1.0f : -1.0f;
-                } else if (wav_local == 2) { // Sawtooth
-                    sample_p = 2.0f * voices[v].phase - 1.0f;
-                }
-
-                mixed_sample += sample_p * voices[v].env_val;
-
-                // Advance phase
-                voices[v].phase += voices[v].freq / sample_rate_f;
-                if (voices[v].phase >= 1.0f) voices[v].phase -= 1.0f;
+        // Ramps over one block into and out of mute
+        bool mute = audio_mute;
+        if (mute || was_muted) {
+            for (size_t i = 0; i < num_samples; i++) {
+                float g = (float)i / (float)num_samples;
+                if (mute && was_muted) audio_buffer[i] = 0;
+                else audio_buffer[i] = (int16_t)(audio_buffer[i] * (mute ? 1.0f - g : g));
             }
+            if (mute) atomic_fetch_add(&audio_silent_frames, (int)num_samples);
+        }
 
-            // Mix down and apply volume
-            mixed_sample *= vol_local / 2.0f; // Soften to prevent clipping when multiple notes play
+        esp_codec_dev_write(spk, audio_buffer, num_samples * sizeof(int16_t));
+        int64_t write_us = esp_timer_get_time();
 
-            // Hard clip to [-1.0, 1.0]
-            if(mixed_sample > 1.0f) mixed_sample = 1.0f;
-            else if(mixed_sample < -1.0f) mixed_sample = -1.0f;
+        // The blocking write paces this loop at one block period. A longer
+        // gap between two writes means rendering fell behind the DAC; while
+        // muted for a flash write that is expected.
+        if (prev_write_us && !mute && !was_muted && write_us - prev_write_us > period_us + period_us / 2) {
+            audio_diag_count_underrun();
+        }
+        was_muted = mute;
+        prev_write_us = write_us;
+
+        // Key press to the moment the note's first sample leaves the codec:
+        // the queued DMA frames ahead of it play out first
+        int64_t press_us;
+        int note_ofs;
+        if (synth_last_note_on(&press_us, &note_ofs)) {
+            int64_t ahead = audio_io_queue_frames() - (int64_t)num_samples + note_ofs;
+            audio_diag_record_latency(write_us + ahead * 1000000 / SAMPLE_RATE - press_us);
+        }
+    }
+}
+
+// Reads the microphone whenever something consumes it, independently of
+// output, so a slow read can never starve audio_task
+static void capture_task(void *pvParameters)
+{
+    int16_t *capture_buffer = malloc(CAPTURE_BLOCK_SIZE * sizeof(int16_t));
+    bool taking = false;
 
-            audio_buffer[i] = (int16_t)(mixed_sample * 32767.0f);
+    while (1) {
+        // Sequence first: a new one means is_recording is already false
+        unsigned stop_seq = atomic_load(&rec_stop_seq);
+        bool recording = is_recording;
+        if (taking && !recording) {
+            recorder_stop();
+            taking = false;
+        }
+        if (!recording) atomic_store(&capture_stop_ack, stop_seq);
+        bool live = spectro_live_active();
+        if ((!recording && !monitor_input && !live) || !audio_io_lock || !audio_io_mic() || !capture_buffer) {
+            vTaskDelay(pdMS_TO_TICKS(10));
+            continue;
+        }
+        if (recording && !taking) {
+            if (rec_sd_ok) rec_sd_start_failed = !recorder_start();
+            loudness_hist_reset(&rec_hist);
+            taking = true;
         }
 
-        esp_codec_dev_write(spk_codec_dev, audio_buffer, num_samples * sizeof(int16_t));
+        xSemaphoreTake(audio_io_lock, portMAX_DELAY);
+        esp_codec_dev_handle_t mic = audio_io_mic();
+        if (mic) esp_codec_dev_read(mic, capture_buffer, CAPTURE_BLOCK_SIZE * sizeof(int16_t));
+        xSemaphoreGive(audio_io_lock);
+        if (!mic) continue;
+
+        if (monitor_input && mic_ring_ok) {
+            audio_ring_write(&mic_ring, capture_buffer, CAPTURE_BLOCK_SIZE);
+        }
+        if (live) spectro_live_push(capture_buffer, CAPTURE_BLOCK_SIZE);
+        if (recording) {
+            // The histogram covers exactly what reverse playback will play
+            int stored = rec_sample_count;
+            for (int i = 0; i < CAPTURE_BLOCK_SIZE && rec_sample_count < REC_BUFFER_SAMPLES && rec_buffer; i++) {
+                rec_buffer[rec_sample_count++] = capture_buffer[i];
+            }
+            loudness_hist_add(&rec_hist, capture_buffer, rec_sample_count - stored);
+            recorder_write(capture_buffer, CAPTURE_BLOCK_SIZE);
+        }
     }
 }
 
@@ -346,6 +478,12 @@ static void update_time_cb(lv_timer_t * timer)
         if (time_label_joystick) {
             lv_label_set_text_fmt(time_label_joystick, "%02d:%02d:%02d", timeinfo.tm_hour, timeinfo.tm_min, timeinfo.tm_sec);
         }
+        if (time_label_diag) {
+            lv_label_set_text_fmt(time_label_diag, "%02d:%02d:%02d", timeinfo.tm_hour, timeinfo.tm_min, timeinfo.tm_sec);
+        }
+        if (time_label_tasks) {
+            lv_label_set_text_fmt(time_label_tasks, "%02d:%02d:%02d", timeinfo.tm_hour, timeinfo.tm_min, timeinfo.tm_sec);
+        }
 
         // Update analog clock if created
         if (clock_sec_hand) {
@@ -366,6 +504,8 @@ static void update_time_cb(lv_timer_t * timer)
         if (time_label_record)  lv_label_set_text(time_label_record,  "Waiting for Wi-Fi...");
         if (time_label_weather) lv_label_set_text(time_label_weather, "Waiting for Wi-Fi...");
         if (time_label_joystick) lv_label_set_text(time_label_joystick, "Waiting for Wi-Fi...");
+        if (time_label_diag)    lv_label_set_text(time_label_diag,    "Waiting for Wi-Fi...");
+        if (time_label_tasks)   lv_label_set_text(time_label_tasks,   "Waiting for Wi-Fi...");
     }
 }
 
@@ -386,28 +526,62 @@ static const float note_freqs[] = {
     523.25f  // 12: C5
 };
 
+static const char * note_names[] = {
+    "C", "C#", "D", "D#", "E", "F", "F#", "G", "G#", "A", "A#", "B", "C5"
+};
+
+// The synth state is owned by audio_task; the UI only posts events to it
+static void post_synth_param(synth_param_t param, float value)
+{
+    synth_event_t ev = {
+        .time_us = esp_timer_get_time(),
+        .type = SYNTH_EV_PARAM,
+        .param = param,
+        .value = value,
+    };
+    synth_events_push(&ev);
+}
+
 static void key_event_cb(lv_event_t * e)
 {
     lv_event_code_t code = lv_event_get_code(e);
     int note_idx = (int)(intptr_t)lv_event_get_user_data(e);
 
+    // Arpeggio modes play the held keys on the sequencer clock instead.
+    // Releases always clear the hold and the key's own voice, so a mode
+    // change while a key is down cannot leave either stuck.
+    bool arp = sequencer_get_mode() >= SEQ_MODE_ARP_UP;
+    if (code == LV_EVENT_RELEASED || code == LV_EVENT_PRESS_LOST) sequencer_hold(note_idx, false);
+    if (arp && code == LV_EVENT_PRESSED) {
+        sequencer_hold(note_idx, true);
+        return;
+    }
+    if (code == LV_EVENT_PRESSED) seq_edit_note = note_idx;
+
+    synth_event_t ev = {
+        .time_us = esp_timer_get_time(),
+        .note_idx = note_idx,
+    };
     if (code == LV_EVENT_PRESSED) {
-        note_on(note_idx, note_freqs[note_idx]);
+        ev.type = SYNTH_EV_NOTE_ON;
+        ev.value = note_freqs[note_idx];
+        synth_events_push(&ev);
     } else if (code == LV_EVENT_RELEASED || code == LV_EVENT_PRESS_LOST) {
-        note_off(note_idx);
+        ev.type = SYNTH_EV_NOTE_OFF;
+        synth_events_push(&ev);
     }
 }
 
 static void wave_dropdown_event_cb(lv_event_t * e)
 {
     lv_obj_t * dropdown = lv_event_get_target(e);
-    synth_waveform = lv_dropdown_get_selected(dropdown);
+    post_synth_param(SYNTH_PARAM_WAVEFORM, (float)lv_dropdown_get_selected(dropdown));
 }
 
 static void vol_slider_event_cb(lv_event_t * e)
 {
     lv_obj_t * slider = lv_event_get_target(e);
-    synth_volume = lv_slider_get_value(slider) / 100.0f;
+    post_synth_param(SYNTH_PARAM_VOLUME, lv_slider_get_value(slider) / 100.0f);
 }
 
 static void env_slider_event_cb(lv_event_t * e)
@@ -417,13 +591,43 @@ static void env_slider_event_cb(lv_event_t * e)
     float val = (float)lv_slider_get_value(slider);
 
     switch(type) {
-        case 0: env_a_time = val / 100.0f; break; // 0.0 to 1.0s (or 2.0s if map to 200)
-        case 1: env_d_time = val / 100.0f; break;
-        case 2: env_s_level = val / 100.0f; break; // 0.0 to 1.0 multiplier
-        case 3: env_r_time = val / 100.0f; break;
+        case 0: post_synth_param(SYNTH_PARAM_ATTACK, val / 100.0f); break; // 0.0 to 1.0s
+        case 1: post_synth_param(SYNTH_PARAM_DECAY, val / 100.0f); break;
+        case 2: post_synth_param(SYNTH_PARAM_SUSTAIN, val / 100.0f); break; // 0.0 to 1.0 multiplier
+        case 3: post_synth_param(SYNTH_PARAM_RELEASE, val / 100.0f); break;
     }
 }
 
+static void seq_mode_dropdown_event_cb(lv_event_t * e)
+{
+    lv_obj_t * dropdown = lv_event_get_target(e);
+    sequencer_set_mode((seq_mode_t)lv_dropdown_get_selected(dropdown));
+}
+
+static void seq_bpm_slider_event_cb(lv_event_t * e)
+{
+    lv_obj_t * slider = lv_event_get_target(e);
+    int bpm = lv_slider_get_value(slider);
+    sequencer_set_bpm((float)bpm);
+    lv_label_set_text_fmt(seq_bpm_label, "%d BPM", bpm);
+}
+
+static void seq_step_label_update(int step)
+{
+    lv_obj_t * lbl = lv_obj_get_child(seq_step_btns[step], 0);
+    int note = sequencer_get_step(step);
+    lv_label_set_text(lbl, note == SEQ_REST ? "-" : note_names[note]);
+}
+
+// Tapping a step writes the last played key into it, tapping it again rests
+static void seq_step_event_cb(lv_event_t * e)
+{
+    int step = (int)(intptr_t)lv_event_get_user_data(e);
+    if (sequencer_get_step(step) == seq_edit_note) sequencer_set_step(step, SEQ_REST);
+    else sequencer_set_step(step, seq_edit_note);
+    seq_step_label_update(step);
+}
+
 // Screen Transition Callbacks
 static void btn_go_synth_cb(lv_event_t * e) {
     lv_scr_load(synth_scr);
@@ -449,69 +653,12 @@ static void btn_go_joystick_cb(lv_event_t * e) {
     lv_scr_load(joystick_scr);
 }
 
-static lv_color_t get_heatmap_color(float intensity) {
-    if (intensity < 0.0f) intensity = 0.0f;
-    if (intensity > 1.0f) intensity = 1.0f;
-    uint8_t r = 0, g = 0, b = 0;
-
-    if (intensity < 0.25f) {
-        float t = intensity / 0.25f;
-        b = (uint8_t)(t * 255.0f);
-    } else if (intensity < 0.5f) {
-        float t = (intensity - 0.25f) / 0.25f;
-        r = (uint8_t)(t * 255.0f);
-        b = (uint8_t)((1.0f - t) * 255.0f);
-    } else if (intensity < 0.75f) {
-        float t = (intensity - 0.5f) / 0.25f;
-        r = 255;
-        g = (uint8_t)(t * 255.0f);
-    } else {
-        float t = (intensity - 0.75f) / 0.25f;
-        r = 255;
-        g = 255;
-        b = (uint8_t)(t * 255.0f);
-    }
-    return lv_color_make(r, g, b);
-}
-
-static void compute_fft(float *vReal, float *vImag, uint16_t n) {
-    uint16_t j = 0;
-    for (uint16_t i = 0; i < n - 1; i++) {
-        if (i < j) {
-            float tempReal = vReal[i];
-            float tempImag = vImag[i];
-            vReal[i] = vReal[j];
-            vImag[i] = vImag[j];
-            vReal[j] = tempReal;
-            vImag[j] = tempImag;
-        }
-        uint16_t k = n / 2;
-        while (k <= j) {
-            j -= k;
-            k /= 2;
-        }
-        j += k;
-    }
-    for (uint16_t step = 1; step < n; step *= 2) {
-        float arg = M_PI / step;
-        float c = cosf(arg);
-        float s = -sinf(arg);
-        float uReal = 1.0f;
-        float uImag = 0.0f;
-        for (uint16_t j2 = 0; j2 < step; j2++) {
-            for (uint16_t i = j2; i < n; i += 2 * step) {
-                float tReal = uReal * vReal[i + step] - uImag * vImag[i + step];
-                float tImag = uReal * vImag[i + step] + uImag * vReal[i + step];
-                vReal[i + step] = vReal[i] - tReal;
-                vImag[i + step] = vImag[i] - tImag;
-                vReal[i] += tReal;
-                vImag[i] += tImag;
-            }
-            float tempReal = uReal * c - uImag * s;
-            uImag = uReal * s + uImag * c;
-            uReal = tempReal;
-        }
-    }
+static void btn_go_diag_cb(lv_event_t * e) {
+    lv_scr_load(diag_scr);
+}
+
+static void btn_go_tasks_cb(lv_event_t * e) {
+    lv_scr_load(tasks_scr);
 }
 
 // ---------------------------------------------------------------------
@@ -631,115 +778,143 @@ static void bmp280_task(void *arg)
     }
 }
 
+// UI thread. Hands a clip to audio_task for reverse playback.
+static void play_reverse(clip_codec_t codec, const uint8_t *data, int samples, float gain)
+{
+    unsigned gen = atomic_load(&rec_play_gen) & ~(REC_PLAY_PLAYING | REC_PLAY_WRITING);
+    atomic_store_explicit(&rec_play_gen, gen | REC_PLAY_WRITING, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+    rec_play_codec = codec;
+    rec_play_data = data;
+    rec_play_samples = samples;
+    rec_play_gain = gain;
+    atomic_store_explicit(&rec_play_gen, (gen + REC_PLAY_GEN_STEP) | REC_PLAY_PLAYING, memory_order_release);
+}
+
+// UI thread
+static void reverse_stop(void)
+{
+    atomic_fetch_and(&rec_play_gen, ~REC_PLAY_PLAYING);
+}
+
+static void play_clip(int idx)
+{
+    const clip_info_t * clip = clip_library_get(idx);
+    if (!clip) return;
+    play_reverse((clip_codec_t)clip->codec, clip_library_data(clip), clip->samples, clip->gain);
+}
+
+static const char * const clip_codec_names[CLIP_CODEC_COUNT] = { "raw", "ADPCM", "u-law" };
+
+// Lists the library in the clips dropdown, newest last, and selects idx
+static void record_clips_refresh(int idx)
+{
+    if (!record_clips_dd) return;
+
+    int count = clip_library_count();
+    if (count == 0) {
+        lv_dropdown_set_options(record_clips_dd, "No clips");
+        return;
+    }
+
+    static char opts[CLIP_LIBRARY_MAX * 32];
+    int len = 0;
+    for (int i = 0; i < count; i++) {
+        const clip_info_t * clip = clip_library_get(i);
+        len += snprintf(opts + len, sizeof(opts) - len, "%s#%lu  %.1f s %s", i ? "\n" : "",
+                        (unsigned long)clip->id, (float)clip->samples / (float)clip->sample_rate,
+                        clip->codec < CLIP_CODEC_COUNT ? clip_codec_names[clip->codec] : "?");
+    }
+    lv_dropdown_set_options(record_clips_dd, opts);
+    if (idx >= 0 && idx < count) lv_dropdown_set_selected(record_clips_dd, idx);
+}
+
+static void record_render_view(int lo, int hi);
+
 static void btn_record_event_cb(lv_event_t * e) {
     lv_event_code_t code = lv_event_get_code(e);
     lv_obj_t * btn = lv_event_get_target(e);
 
     if (code == LV_EVENT_PRESSED) {
+        // The last take is not finalized yet; capture_task is about to
+        // let go of it
+        if (rec_finish_pending) return;
         lv_obj_set_style_bg_color(btn, lv_palette_main(LV_PALETTE_RED), 0);
+        // The running analysis reads rec_buffer, which is about to be overwritten
+        spectro_job_cancel();
+        record_job_id = 0;
+        record_stft.frames = 0;
+        record_frames_done = 0;
         rec_sample_count = 0;
-        is_playing_reverse = false;
+        reverse_stop();
         is_recording = true;
     } else if (code == LV_EVENT_RELEASED || code == LV_EVENT_PRESS_LOST) {
         lv_obj_set_style_bg_color(btn, lv_color_hex(0x555555), 0);
+        if (!is_recording) return;
         is_recording = false;
-        if (rec_sample_count > 0 && rec_buffer != NULL) {
-            // Calculate 99th percentile for volume auto-scaling
-            int bins[100] = {0};
-            for (int i = 0; i < rec_sample_count; i++) {
-                int val = rec_buffer[i];
-                if (val < 0) val = -val;
-                if (val > 32767) val = 32767;
-                int bin = (val * 100) / 32768; // 0 to 99
-                if (bin > 99) bin = 99;
-                if (bin < 0) bin = 0;
-                bins[bin]++;
-            }
-            int target_count = (rec_sample_count * 99) / 100;
-            int count = 0;
-            int p99_val = 32767;
-            for (int i = 0; i < 100; i++) {
-                count += bins[i];
-                if (count >= target_count) {
-                    p99_val = (i * 32768) / 100;
-                    break;
-                }
-            }
-            if (p99_val < 50) p99_val = 50; // Prevent infinite/massive gain on silence
-            rec_multiplier = 32760.0f / (float)p99_val;
-            if (rec_multiplier > 100.0f) rec_multiplier = 100.0f; // Cap max boost at 100x
-
-            rec_play_idx = rec_sample_count - 1;
-            is_playing_reverse = true;
-
-            if (record_canvas && record_canvas_aligned_buf) {
-                int chart_h = 240;
-                int chart_w = 640;
-                lv_canvas_fill_bg(record_canvas, lv_color_hex(0x000000), LV_OPA_COVER);
-
-                int step = rec_sample_count / chart_w;
-                if (step == 0) step = 1;
-
-                int FFT_SIZE = 1024;
-                float *vReal = malloc(FFT_SIZE * sizeof(float));
-                float *vImag = malloc(FFT_SIZE * sizeof(float));
-                float *mags  = malloc((FFT_SIZE / 2) * sizeof(float));
-
-                if (vReal && vImag && mags) {
-                    int num_bins = FFT_SIZE / 2;
-                    float log_max = logf((float)(num_bins - 1));
-
-                    for (int x = 0; x < chart_w; x++) {
-                        int start_idx = x * step;
-
-                        // Fill FFT buffer
-                        for (int i = 0; i < FFT_SIZE; i++) {
-                            if (start_idx + i < rec_sample_count && start_idx + i >= 0) {
-                                // Apply Hanning Window
-                                float mult = 0.5f * (1.0f - cosf(2.0f * M_PI * i / (FFT_SIZE - 1)));
-                                vReal[i] = (float)rec_buffer[start_idx + i] * mult;
-                            } else {
-                                vReal[i] = 0.0f;
-                            }
-                            vImag[i] = 0.0f;
-                        }
-
-                        compute_fft(vReal, vImag, FFT_SIZE);
-
-                        float max_mag = 0.0f;
-
-                        for (int i = 0; i < num_bins; i++) {
-                            float mag = sqrtf(vReal[i]*vReal[i] + vImag[i]*vImag[i]);
-                            mags[i] = mag;
-                            if (i > 0 && mag > max_mag) {
-                                max_mag = mag;
-                            }
-                        }
-
-                        if (max_mag < 1000.0f) max_mag = 1000.0f;
-                        float scale = 1.0f / (max_mag * 0.7f);
-
-                        for (int y = 0; y < chart_h; y++) {
-                            float ratio = (float)(chart_h - 1 - y) / (float)(chart_h - 1);
-                            float exact_bin = expf(ratio * log_max);
-                            int bin = (int)exact_bin;
-
-                            if (bin < 1) bin = 1;
-                            if (bin >= num_bins) bin = num_bins - 1;
-
-                            float intensity = mags[bin] * scale;
-                            lv_color_t color = get_heatmap_color(intensity);
-                            lv_canvas_set_px(record_canvas, x, y, color, LV_OPA_COVER);
-                        }
-                    }
-                    free(vReal);
-                    free(vImag);
-                    free(mags);
-                }
-
-                lv_obj_invalidate(record_canvas);
-            }
-        }
+        atomic_fetch_add(&rec_stop_seq, 1);
+        // Adding the take may evict older clips, so nothing may be playing
+        // from the library by then
+        reverse_stop();
+        atomic_fetch_add(&rec_play_stop_seq, 1);
+        // capture_task may still be appending its block in flight, and
+        // audio_task decoding a clip; update_record_finish_cb finalizes once
+        // both have acknowledged
+        rec_finish_pending = true;
+    }
+}
+
+// Finalizes a take once capture_task has stopped appending to it,
+// audio_task has stopped reading clips and the recorder has closed its file
+static void update_record_finish_cb(lv_timer_t * timer)
+{
+    if (!rec_finish_pending) return;
+    if (atomic_load(&capture_stop_ack) != atomic_load(&rec_stop_seq)) return;
+    if (atomic_load(&audio_play_stop_ack) != atomic_load(&rec_play_stop_seq)) return;
+    if (rec_sd_ok) {
+        recorder_stats_t st;
+        recorder_get_stats(&st);
+        if (st.active) return;
+    }
+    rec_finish_pending = false;
+
+    if (rec_sample_count == 0 || rec_buffer == NULL) return;
+
+    // Volume auto-scaling from the 99th percentile; capture_task
+    // has kept the histogram up to date while recording
+    int p99_val = loudness_hist_percentile(&rec_hist, 99);
+    if (p99_val < 50) p99_val = 50; // Prevent infinite/massive gain on silence
+    rec_multiplier = 32760.0f / (float)p99_val;
+    if (rec_multiplier > 100.0f) rec_multiplier = 100.0f; // Cap max boost at 100x
+
+    // The take is kept compressed and played back from the library,
+    // so what is heard is what was stored. Raw rec_buffer is the
+    // fallback when the library is unavailable.
+    int idx = clips_ok ? clip_library_add(record_codec, rec_buffer, rec_sample_count,
+                                          SAMPLE_RATE, rec_multiplier) : -1;
+    if (idx >= 0) {
+        record_clips_refresh(idx);
+        play_clip(idx);
+    } else {
+        play_reverse(CLIP_CODEC_PCM16, (const uint8_t *)rec_buffer, rec_sample_count, rec_multiplier);
+    }
+
+    // Analysis runs on its own task; update_record_spectro_cb draws
+    // the frames as they finish. The live analyzer owns the canvas
+    // while it is on.
+    if (record_stft_ok && record_canvas_aligned_buf && !spectro_live_active()) {
+        int frames = stft_cache_reset(&record_stft, rec_sample_count);
+        record_frames_done = 0;
+        record_view_start = 0.0f;
+        record_view_len = (float)frames;
+        record_render_view(0, frames);
+
+        spectro_job_t job = {
+            .samples = rec_buffer,
+            .count = rec_sample_count,
+            .cache = &record_stft,
+        };
+        record_job_id = spectro_job_start(&job);
     }
 }
 
@@ -990,6 +1165,281 @@ void create_joystick_screen(void)
     lv_timer_create(update_joystick_cb, 50, NULL);
 }
 
+// ---------------------------------------------------------------------
+// AUDIO DIAGNOSTICS SCREEN
+// ---------------------------------------------------------------------
+
+static void update_diag_cb(lv_timer_t * timer)
+{
+    if (!diag_stats_label || !diag_chart || !diag_series) return;
+
+    audio_diag_stats_t st;
+    audio_diag_get(&st);
+
+    audio_load_stats_t load;
+    audio_diag_get_load(&load);
+
+    char buf[256];
+    if (st.count > 0) {
+        snprintf(buf, sizeof(buf),
+                 "Block: %d samples (%.1f ms)   DMA queue: %.1f ms   Presses: %lu   Underruns: %lu\n"
+                 "Latency ms - last %.1f  min %.1f  p50 <%lu  p95 <%lu  max %.1f",
+                 audio_block_size, audio_block_size * 1000.0f / SAMPLE_RATE,
+                 audio_io_queue_frames() * 1000.0f / SAMPLE_RATE,
+                 (unsigned long)st.count, (unsigned long)st.underruns,
+                 st.last_us / 1000.0f, st.min_us / 1000.0f,
+                 (unsigned long)(audio_diag_latency_percentile(&st, 0.50f) / 1000),
+                 (unsigned long)(audio_diag_latency_percentile(&st, 0.95f) / 1000),
+                 st.max_us / 1000.0f);
+    } else {
+        snprintf(buf, sizeof(buf),
+                 "Block: %d samples (%.1f ms)   DMA queue: %.1f ms   Presses: 0   Underruns: %lu\n"
+                 "Play some notes on the NanoSynth to collect latency samples",
+                 audio_block_size, audio_block_size * 1000.0f / SAMPLE_RATE,
+                 audio_io_queue_frames() * 1000.0f / SAMPLE_RATE,
+                 (unsigned long)st.underruns);
+    }
+    size_t used = strlen(buf);
+    snprintf(buf + used, sizeof(buf) - used,
+             "\nCPU load - avg %.0f%%  p95 %.0f%%  p99 %.0f%%  peak %.0f%%   Deadline misses: %lu",
+             load.avg * 100.0f, load.p95 * 100.0f, load.p99 * 100.0f, load.peak * 100.0f,
+             (unsigned long)load.deadline_misses);
+    lv_label_set_text(diag_stats_label, buf);
+
+    uint32_t peak = 1;
+    for (int i = 0; i < AUDIO_DIAG_LAT_BINS; i++) {
+        if (st.hist[i] > peak) peak = st.hist[i];
+    }
+    lv_chart_set_range(diag_chart, LV_CHART_AXIS_PRIMARY_Y, 0, peak);
+    for (int i = 0; i < AUDIO_DIAG_LAT_BINS; i++) {
+        lv_chart_set_value_by_id(diag_chart, diag_series, i, st.hist[i]);
+    }
+    lv_chart_refresh(diag_chart);
+
+    dsp_graph_t * fx = audio_engine_fx();
+    for (int i = 0; i < fx->count; i++) {
+        dsp_node_t * node = fx->nodes[i];
+        if (!diag_fx_labels[i]) continue;
+        snprintf(buf, sizeof(buf), "%-8s %5.1f%%  (%lu cycles/block)",
+                 node->name,
+                 dsp_node_load(node, audio_block_size, (float)SAMPLE_RATE) * 100.0f,
+                 (unsigned long)node->avg_cycles);
+        lv_label_set_text(diag_fx_labels[i], buf);
+    }
+}
+
+static void fx_switch_event_cb(lv_event_t * e)
+{
+    lv_obj_t * sw = lv_event_get_target(e);
+    dsp_node_t * node = lv_event_get_user_data(e);
+    node->enabled = lv_obj_has_state(sw, LV_STATE_CHECKED);
+}
+
+static void block_size_dropdown_event_cb(lv_event_t * e)
+{
+    lv_obj_t * dropdown = lv_event_get_target(e);
+    audio_block_req = SYNTH_BLOCK_SIZE >> lv_dropdown_get_selected(dropdown);
+    audio_diag_reset();
+}
+
+static void btn_diag_reset_cb(lv_event_t * e)
+{
+    audio_diag_reset();
+}
+
+void create_diag_screen(void)
+{
+    diag_scr = lv_obj_create(NULL);
+    lv_obj_set_style_bg_color(diag_scr, lv_color_hex(0x1a1a1a), 0);
+
+    // Header bar
+    lv_obj_t * header = lv_obj_create(diag_scr);
+    lv_obj_set_size(header, LCD_H_RES, 60);
+    lv_obj_align(header, LV_ALIGN_TOP_MID, 0, 0);
+    lv_obj_set_style_bg_color(header, lv_color_hex(0x111111), 0);
+    lv_obj_set_style_border_width(header, 0, 0);
+
+    time_label_diag = lv_label_create(header);
+    lv_obj_set_style_text_font(time_label_diag, &lv_font_montserrat_14, 0);
+    lv_obj_set_style_text_color(time_label_diag, lv_color_white(), 0);
+    lv_obj_align(time_label_diag, LV_ALIGN_LEFT_MID, 10, 0);
+    lv_label_set_text(time_label_diag, "Waiting for Wi-Fi...");
+
+    lv_obj_t * title_label = lv_label_create(header);
+    lv_obj_set_style_text_font(title_label, &lv_font_montserrat_14, 0);
+    lv_obj_set_style_text_color(title_label, lv_palette_main(LV_PALETTE_ORANGE), 0);
+    lv_obj_align(title_label, LV_ALIGN_CENTER, 0, 0);
+    lv_label_set_text(title_label, "Audio Diagnostics");
+
+    lv_obj_t * btn_back = lv_btn_create(header);
+    lv_obj_set_size(btn_back, 80, 40);
+    lv_obj_align(btn_back, LV_ALIGN_RIGHT_MID, -10, 0);
+    lv_obj_t * lbl_back = lv_label_create(btn_back);
+    lv_label_set_text(lbl_back, "Back");
+    lv_obj_center(lbl_back);
+    lv_obj_add_event_cb(btn_back, btn_go_menu_cb, LV_EVENT_CLICKED, NULL);
+
+    // Latency mode: smaller blocks trade CPU headroom for responsiveness
+    lv_obj_t * bs_label = lv_label_create(diag_scr);
+    lv_obj_set_style_text_color(bs_label, lv_color_white(), 0);
+    lv_obj_align(bs_label, LV_ALIGN_TOP_LEFT, 20, 90);
+    lv_label_set_text(bs_label, "Block size");
+
+    lv_obj_t * bs_dd = lv_dropdown_create(diag_scr);
+    lv_dropdown_set_options(bs_dd, "256 (normal)\n128\n64\n32");
+    lv_obj_align(bs_dd, LV_ALIGN_TOP_LEFT, 120, 80);
+    lv_obj_add_event_cb(bs_dd, block_size_dropdown_event_cb, LV_EVENT_VALUE_CHANGED, NULL);
+
+    lv_obj_t * btn_reset = lv_btn_create(diag_scr);
+    lv_obj_set_size(btn_reset, 100, 40);
+    lv_obj_align(btn_reset, LV_ALIGN_TOP_RIGHT, -20, 80);
+    lv_obj_t * lbl_reset = lv_label_create(btn_reset);
+    lv_label_set_text(lbl_reset, "Reset");
+    lv_obj_center(lbl_reset);
+    lv_obj_add_event_cb(btn_reset, btn_diag_reset_cb, LV_EVENT_CLICKED, NULL);
+
+    diag_stats_label = lv_label_create(diag_scr);
+    lv_obj_set_style_text_color(diag_stats_label, lv_color_white(), 0);
+    lv_obj_align(diag_stats_label, LV_ALIGN_TOP_LEFT, 20, 140);
+    lv_label_set_text(diag_stats_label, "");
+
+    // One row per effect node: on/off switch and its share of the block period
+    dsp_graph_t * fx = audio_engine_fx();
+    for (int i = 0; i < fx->count; i++) {
+        lv_obj_t * sw = lv_switch_create(diag_scr);
+        lv_obj_align(sw, LV_ALIGN_TOP_LEFT, 20, 210 + i * 45);
+        if (fx->nodes[i]->enabled) lv_obj_add_state(sw, LV_STATE_CHECKED);
+        lv_obj_add_event_cb(sw, fx_switch_event_cb, LV_EVENT_VALUE_CHANGED, fx->nodes[i]);
+
+        diag_fx_labels[i] = lv_label_create(diag_scr);
+        lv_obj_set_style_text_color(diag_fx_labels[i], lv_color_white(), 0);
+        lv_obj_align(diag_fx_labels[i], LV_ALIGN_TOP_LEFT, 90, 215 + i * 45);
+        lv_label_set_text(diag_fx_labels[i], fx->nodes[i]->name);
+    }
+
+    // Key-to-sound latency histogram, one bar per AUDIO_DIAG_LAT_BIN_US
+    diag_chart = lv_chart_create(diag_scr);
+    lv_obj_set_size(diag_chart, LCD_H_RES - 60, 200);
+    lv_obj_align(diag_chart, LV_ALIGN_BOTTOM_MID, 0, -60);
+    lv_chart_set_type(diag_chart, LV_CHART_TYPE_BAR);
+    lv_chart_set_point_count(diag_chart, AUDIO_DIAG_LAT_BINS);
+    lv_obj_set_style_bg_color(diag_chart, lv_color_hex(0x222222), 0);
+    lv_obj_set_style_border_color(diag_chart, lv_color_hex(0x555555), 0);
+    diag_series = lv_chart_add_series(diag_chart, lv_palette_main(LV_PALETTE_ORANGE), LV_CHART_AXIS_PRIMARY_Y);
+
+    lv_obj_t * axis_label = lv_label_create(diag_scr);
+    lv_obj_set_style_text_color(axis_label, lv_color_hex(0xaaaaaa), 0);
+    lv_obj_align(axis_label, LV_ALIGN_BOTTOM_MID, 0, -25);
+    lv_label_set_text_fmt(axis_label, "Key press to codec output, incl. the I2S DMA queue: 0 - %d ms",
+                          AUDIO_DIAG_LAT_BINS * AUDIO_DIAG_LAT_BIN_US / 1000);
+
+    lv_timer_create(update_diag_cb, 250, NULL);
+}
+
+// ---------------------------------------------------------------------
+// SYSTEM TASKS SCREEN
+// ---------------------------------------------------------------------
+
+static void update_tasks_cb(lv_timer_t * timer)
+{
+    // Sample even while hidden so the first view shows a full interval
+    task_stats_t st;
+    bool valid = task_stats_sample(&st);
+    if (!tasks_list_labels[0] || lv_scr_act() != tasks_scr) return;
+
+    if (!valid) {
+        lv_label_set_text(tasks_list_labels[0],
+                          "Run-time stats unavailable.\n"
+                          "Enable CONFIG_FREERTOS_GENERATE_RUN_TIME_STATS.");
+        return;
+    }
+
+    char buf[1024];
+    for (int c = 0; c < portNUM_PROCESSORS; c++) {
+        int pct = (int)(st.core_load[c] * 100.0f + 0.5f);
+        lv_bar_set_value(tasks_core_bars[c], pct, LV_ANIM_OFF);
+        snprintf(buf, sizeof(buf), "Core %d: %d%%", c, pct);
+        lv_label_set_text(tasks_core_labels[c], buf);
+    }
+
+    // Proportional font, so each column is its own label
+    char cores[128];
+    char loads[256];
+    size_t used = snprintf(buf, sizeof(buf), "Task\n");
+    size_t used_c = snprintf(cores, sizeof(cores), "Core\n");
+    size_t used_l = snprintf(loads, sizeof(loads), "Load\n");
+    for (int i = 0; i < st.count; i++) {
+        if (st.tasks[i].core == tskNO_AFFINITY) {
+            used_c += snprintf(cores + used_c, sizeof(cores) - used_c, "any\n");
+        } else {
+            used_c += snprintf(cores + used_c, sizeof(cores) - used_c, "%d\n", (int)st.tasks[i].core);
+        }
+        used += snprintf(buf + used, sizeof(buf) - used, "%s\n", st.tasks[i].name);
+        used_l += snprintf(loads + used_l, sizeof(loads) - used_l, "%.1f%%\n", st.tasks[i].load * 100.0f);
+        if (used >= sizeof(buf) || used_c >= sizeof(cores) || used_l >= sizeof(loads)) break;
+    }
+    lv_label_set_text(tasks_list_labels[0], buf);
+    lv_label_set_text(tasks_list_labels[1], cores);
+    lv_label_set_text(tasks_list_labels[2], loads);
+}
+
+void create_tasks_screen(void)
+{
+    tasks_scr = lv_obj_create(NULL);
+    lv_obj_set_style_bg_color(tasks_scr, lv_color_hex(0x1a1a1a), 0);
+
+    // Header bar
+    lv_obj_t * header = lv_obj_create(tasks_scr);
+    lv_obj_set_size(header, LCD_H_RES, 60);
+    lv_obj_align(header, LV_ALIGN_TOP_MID, 0, 0);
+    lv_obj_set_style_bg_color(header, lv_color_hex(0x111111), 0);
+    lv_obj_set_style_border_width(header, 0, 0);
+
+    time_label_tasks = lv_label_create(header);
+    lv_obj_set_style_text_font(time_label_tasks, &lv_font_montserrat_14, 0);
+    lv_obj_set_style_text_color(time_label_tasks, lv_color_white(), 0);
+    lv_obj_align(time_label_tasks, LV_ALIGN_LEFT_MID, 10, 0);
+    lv_label_set_text(time_label_tasks, "Waiting for Wi-Fi...");
+
+    lv_obj_t * title_label = lv_label_create(header);
+    lv_obj_set_style_text_font(title_label, &lv_font_montserrat_14, 0);
+    lv_obj_set_style_text_color(title_label, lv_palette_main(LV_PALETTE_ORANGE), 0);
+    lv_obj_align(title_label, LV_ALIGN_CENTER, 0, 0);
+    lv_label_set_text(title_label, "System Tasks");
+
+    lv_obj_t * btn_back = lv_btn_create(header);
+    lv_obj_set_size(btn_back, 80, 40);
+    lv_obj_align(btn_back, LV_ALIGN_RIGHT_MID, -10, 0);
+    lv_obj_t * lbl_back = lv_label_create(btn_back);
+    lv_label_set_text(lbl_back, "Back");
+    lv_obj_center(lbl_back);
+    lv_obj_add_event_cb(btn_back, btn_go_menu_cb, LV_EVENT_CLICKED, NULL);
+
+    // Per-core utilization: 100% minus the share its idle task got
+    for (int c = 0; c < portNUM_PROCESSORS; c++) {
+        tasks_core_labels[c] = lv_label_create(tasks_scr);
+        lv_obj_set_style_text_color(tasks_core_labels[c], lv_color_white(), 0);
+        lv_obj_align(tasks_core_labels[c], LV_ALIGN_TOP_LEFT, 20, 85 + c * 40);
+        lv_label_set_text_fmt(tasks_core_labels[c], "Core %d", c);
+
+        tasks_core_bars[c] = lv_bar_create(tasks_scr);
+        lv_obj_set_size(tasks_core_bars[c], 500, 20);
+        lv_obj_align(tasks_core_bars[c], LV_ALIGN_TOP_LEFT, 180, 85 + c * 40);
+        lv_bar_set_range(tasks_core_bars[c], 0, 100);
+    }
+
+    // Per-task share of one core since the last refresh, busiest first
+    static const int col_x[3] = { 20, 260, 360 };
+    for (int i = 0; i < 3; i++) {
+        tasks_list_labels[i] = lv_label_create(tasks_scr);
+        lv_obj_set_style_text_color(tasks_list_labels[i], lv_color_white(), 0);
+        lv_obj_align(tasks_list_labels[i], LV_ALIGN_TOP_LEFT, col_x[i], 85 + portNUM_PROCESSORS * 40 + 10);
+        lv_label_set_text(tasks_list_labels[i], "");
+    }
+
+    lv_timer_create(update_tasks_cb, 1000, NULL);
+}
+
 void create_main_menu(void)
 {
     main_menu_scr = lv_obj_create(NULL);
@@ -1056,6 +1506,22 @@ void create_main_menu(void)
     lv_label_set_text(lbl_notes, "Notes App");
     lv_obj_center(lbl_notes);
     lv_obj_add_event_cb(btn_notes, btn_go_notes_cb, LV_EVENT_CLICKED, NULL);
+
+    lv_obj_t * btn_diag = lv_btn_create(main_menu_scr);
+    lv_obj_set_size(btn_diag, 200, 80);
+    lv_obj_align(btn_diag, LV_ALIGN_CENTER, -110, 265);
+    lv_obj_t * lbl_diag = lv_label_create(btn_diag);
+    lv_label_set_text(lbl_diag, "Audio Diagnostics");
+    lv_obj_center(lbl_diag);
+    lv_obj_add_event_cb(btn_diag, btn_go_diag_cb, LV_EVENT_CLICKED, NULL);
+
+    lv_obj_t * btn_tasks = lv_btn_create(main_menu_scr);
+    lv_obj_set_size(btn_tasks, 200, 80);
+    lv_obj_align(btn_tasks, LV_ALIGN_CENTER, 110, 265);
+    lv_obj_t * lbl_tasks = lv_label_create(btn_tasks);
+    lv_label_set_text(lbl_tasks, "System Tasks");
+    lv_obj_center(lbl_tasks);
+    lv_obj_add_event_cb(btn_tasks, btn_go_tasks_cb, LV_EVENT_CLICKED, NULL);
 }
 
 void create_clock_screen(void)
@@ -1114,6 +1580,316 @@ void create_clock_screen(void)
     lv_obj_set_style_border_width(dot, 0, 0);
 }
 
+// Cached frame shown in canvas column x
+static int record_view_frame(int x)
+{
+    int f = (int)(record_view_start + ((float)x + 0.5f) * record_view_len / (float)REC_CANVAS_W);
+    return f < record_stft.frames ? f : record_stft.frames - 1;
+}
+
+// Redraws the canvas columns that show frames in [lo, hi) and invalidates
+// just that strip. Frames still being analysed are drawn black.
+static void record_render_view(int lo, int hi)
+{
+    if (!record_canvas_aligned_buf || record_stft.frames == 0) return;
+
+    uint16_t *canvas_px = (uint16_t *)record_canvas_aligned_buf;
+    uint8_t levels[REC_CANVAS_H];
+    int x_min = REC_CANVAS_W, x_max = -1;
+    for (int x = 0; x < REC_CANVAS_W; x++) {
+        int f = record_view_frame(x);
+        if (f < lo || f >= hi) continue;
+
+        if (f < record_frames_done) {
+            stft_codes_to_levels(stft_cache_frame(&record_stft, f), levels, REC_CANVAS_H);
+            spectro_blit_column(canvas_px, REC_CANVAS_W, x, levels, REC_CANVAS_H);
+        } else {
+            for (int y = 0; y < REC_CANVAS_H; y++) canvas_px[y * REC_CANVAS_W + x] = 0;
+        }
+        if (x < x_min) x_min = x;
+        x_max = x;
+    }
+    if (x_max < x_min) return;
+
+    lv_area_t area;
+    lv_obj_get_content_coords(record_canvas, &area);
+    area.x2 = area.x1 + x_max;
+    area.x1 += x_min;
+    lv_obj_invalidate_area(record_canvas, &area);
+}
+
+// Redraws every live analyzer column from its codes
+static void record_live_redraw(void)
+{
+    uint16_t *canvas_px = (uint16_t *)record_canvas_aligned_buf;
+    uint8_t levels[REC_CANVAS_H];
+    for (int x = 0; x < REC_CANVAS_W; x++) {
+        stft_codes_to_levels(&record_live_codes[x * REC_CANVAS_H], levels, REC_CANVAS_H);
+        spectro_blit_column(canvas_px, REC_CANVAS_W, x, levels, REC_CANVAS_H);
+    }
+    lv_obj_invalidate(record_canvas);
+    lv_obj_invalidate(record_canvas_wrap);
+}
+
+static void palette_dropdown_event_cb(lv_event_t * e)
+{
+    lv_obj_t * dropdown = lv_event_get_target(e);
+    spectro_set_palette((spectro_palette_t)lv_dropdown_get_selected(dropdown));
+
+    // Recolour from the cached codes
+    if (!record_canvas_aligned_buf) return;
+    if (spectro_live_active()) {
+        record_live_redraw();
+    } else {
+        record_render_view(0, record_stft.frames);
+    }
+}
+
+// Draws the frames finished since the last tick
+static void update_record_spectro_cb(lv_timer_t * timer)
+{
+    if (record_job_id == 0) return;
+
+    int done = spectro_job_frames_done(record_job_id);
+    if (done < 0) {
+        record_job_id = 0;
+        return;
+    }
+    if (done > record_frames_done) {
+        int prev = record_frames_done;
+        record_frames_done = done;
+        record_render_view(prev, done);
+    }
+    if (done >= record_stft.frames) record_job_id = 0;
+}
+
+// Drag sideways to pan through the take and up or down to zoom in or out
+// around the point first touched; double tap to see the whole take again.
+// The touch driver reports a single point, so there is no pinch.
+static void record_view_event_cb(lv_event_t * e)
+{
+    static lv_point_t press_pt;
+    static float press_start, press_len;
+    static uint32_t last_tap_ms = 0;
+
+    lv_event_code_t code = lv_event_get_code(e);
+    lv_indev_t * indev = lv_event_get_param(e);
+    int frames = record_stft.frames;
+    if (!indev || frames == 0 || spectro_live_active()) return;
+
+    lv_point_t p;
+    lv_indev_get_point(indev, &p);
+
+    if (code == LV_EVENT_PRESSED) {
+        press_pt = p;
+        press_start = record_view_start;
+        press_len = record_view_len;
+    } else if (code == LV_EVENT_PRESSING) {
+        lv_area_t area;
+        lv_obj_get_coords(lv_event_get_target(e), &area);
+        float touch_x = (float)(press_pt.x - area.x1);
+
+        // 120 px up doubles the zoom
+        float len = press_len * exp2f((float)(p.y - press_pt.y) / 120.0f);
+        float min_len = frames < REC_VIEW_MIN_FRAMES ? (float)frames : (float)REC_VIEW_MIN_FRAMES;
+        if (len < min_len) len = min_len;
+        if (len > (float)frames) len = (float)frames;
+
+        // Keep the frame first touched under the finger as it moves
+        float anchor = press_start + touch_x * press_len / (float)REC_CANVAS_W;
+        float start = anchor - (touch_x + (float)(p.x - press_pt.x)) * len / (float)REC_CANVAS_W;
+        if (start > (float)frames - len) start = (float)frames - len;
+        if (start < 0.0f) start = 0.0f;
+
+        if (start != record_view_start || len != record_view_len) {
+            record_view_start = start;
+            record_view_len = len;
+            record_render_view(0, frames);
+        }
+    } else if (code == LV_EVENT_RELEASED) {
+        if (abs(p.x - press_pt.x) > 10 || abs(p.y - press_pt.y) > 10) {
+            last_tap_ms = 0;
+            return;
+        }
+        if (last_tap_ms && lv_tick_elaps(last_tap_ms) < 300) {
+            record_view_start = 0.0f;
+            record_view_len = (float)frames;
+            record_render_view(0, frames);
+            last_tap_ms = 0;
+        } else {
+            last_tap_ms = lv_tick_get();
+        }
+    }
+}
+
+// Shows the circular canvas with column head at the left edge. Only the two
+// views move; no pixels are copied.
+static void record_view_scroll(int head)
+{
+    lv_obj_set_x(record_canvas, -head);
+    lv_obj_set_x(record_canvas_wrap, REC_CANVAS_W - head);
+}
+
+// Draws the frames the live analyzer finished since the last tick, newest
+// at the right edge
+static void update_record_live_cb(lv_timer_t * timer)
+{
+    if (!spectro_live_active() || !record_canvas_aligned_buf) return;
+
+    uint32_t frames = spectro_live_frames();
+    if (frames == record_live_drawn) return;
+    // Anything older than a full canvas would be overwritten anyway
+    if (frames - record_live_drawn > REC_CANVAS_W) record_live_drawn = frames - REC_CANVAS_W;
+
+    uint16_t *canvas_px = (uint16_t *)record_canvas_aligned_buf;
+    uint8_t levels[REC_CANVAS_H];
+    for (uint32_t f = record_live_drawn; f != frames; f++) {
+        int x = f % REC_CANVAS_W;
+        stft_codes_to_levels(&record_live_codes[x * REC_CANVAS_H], levels, REC_CANVAS_H);
+        spectro_blit_column(canvas_px, REC_CANVAS_W, x, levels, REC_CANVAS_H);
+    }
+    record_live_drawn = frames;
+    record_view_scroll(frames % REC_CANVAS_W);
+}
+
+static void update_record_live_stats_cb(lv_timer_t * timer)
+{
+    static spectro_live_stats_t prev;
+    if (!record_live_label || lv_scr_act() != record_scr) return;
+
+    spectro_live_stats_t st;
+    spectro_live_get_stats(&st);
+    if (!spectro_live_active()) {
+        lv_label_set_text(record_live_label, "");
+        prev = st;
+        return;
+    }
+    if (st.frames < prev.frames) memset(&prev, 0, sizeof(prev));
+
+    // The timer runs once a second, so the frame delta is the frame rate
+    uint32_t frames = st.frames - prev.frames;
+    float avg_ms = frames ? (float)(st.busy_us - prev.busy_us) / (float)frames / 1000.0f : 0.0f;
+    char buf[96];
+    snprintf(buf, sizeof(buf), "Live: %lu fps, %.2f ms per frame (max %.2f ms), %lu samples dropped",
+             (unsigned long)frames, avg_ms, (float)st.max_us / 1000.0f, (unsigned long)st.overflows);
+    lv_label_set_text(record_live_label, buf);
+    prev = st;
+}
+
+static void live_switch_event_cb(lv_event_t * e)
+{
+    lv_obj_t * sw = lv_event_get_target(e);
+    if (!record_canvas_aligned_buf || !record_live_codes) return;
+
+    // Either way the canvas starts over from black at offset 0, and the
+    // last take's view is dropped. The analyzer is stopped first so it is
+    // not writing a column while the codes are cleared.
+    spectro_live_stop();
+    spectro_job_cancel();
+    record_job_id = 0;
+    record_stft.frames = 0;
+    lv_canvas_fill_bg(record_canvas, lv_color_hex(0x000000), LV_OPA_COVER);
+    memset(record_live_codes, STFT_CODE_MIN, REC_CANVAS_W * REC_CANVAS_H);
+    record_view_scroll(0);
+
+    if (lv_obj_has_state(sw, LV_STATE_CHECKED)) {
+        record_live_drawn = 0;
+        spectro_live_start();
+    }
+}
+
+static void codec_dropdown_event_cb(lv_event_t * e)
+{
+    lv_obj_t * dropdown = lv_event_get_target(e);
+    // Options are listed in the order of clip_codec_t after raw
+    record_codec = (clip_codec_t)(CLIP_CODEC_ADPCM + lv_dropdown_get_selected(dropdown));
+}
+
+static void btn_clip_play_cb(lv_event_t * e)
+{
+    if (is_recording || rec_finish_pending || !record_clips_dd) return;
+    play_clip(lv_dropdown_get_selected(record_clips_dd));
+}
+
+// clip_store writer task: silences the output before the flash is erased
+static void clip_store_quiet(bool quiet)
+{
+    if (!quiet) {
+        audio_mute = false;
+        return;
+    }
+    audio_silent_frames = 0;
+    audio_mute = true;
+    // The fade-out block does not count as silence, so one more queue's
+    // worth is waited for; give up after half a second if audio is stuck
+    for (int i = 0; i < 50 && audio_silent_frames < audio_io_queue_frames() + SYNTH_BLOCK_SIZE; i++) {
+        vTaskDelay(pdMS_TO_TICKS(10));
+    }
+}
+
+static void btn_clip_save_cb(lv_event_t * e)
+{
+    if (!clips_ok) return;
+    if (!clip_store_save()) {
+        printf("Clips: Save not started\n");
+    }
+}
+
+static void update_record_clips_cb(lv_timer_t * timer)
+{
+    if (!record_clips_label || lv_scr_act() != record_scr) return;
+    if (!clips_ok) {
+        lv_label_set_text(record_clips_label, "No clip library");
+        return;
+    }
+
+    static const char * const store_text[] = {
+        [CLIP_STORE_NONE] = "not kept",
+        [CLIP_STORE_IDLE] = "not saved",
+        [CLIP_STORE_SAVING] = "saving, audio muted...",
+        [CLIP_STORE_SAVED] = "saved",
+        [CLIP_STORE_FAILED] = "SAVE FAILED",
+    };
+    lv_label_set_text_fmt(record_clips_label, "Clips: %d, %u of %u KB\n%s",
+                          clip_library_count(), (unsigned)(clip_library_used() / 1024),
+                          (unsigned)(clip_library_capacity() / 1024), store_text[clip_store_status()]);
+}
+
+static void monitor_switch_event_cb(lv_event_t * e)
+{
+    lv_obj_t * sw = lv_event_get_target(e);
+    monitor_input = lv_obj_has_state(sw, LV_STATE_CHECKED);
+}
+
+static void update_record_sd_cb(lv_timer_t * timer)
+{
+    if (!record_sd_label || lv_scr_act() != record_scr) return;
+
+    if (!rec_sd_ok) {
+        lv_label_set_text_fmt(record_sd_label, "No SD card: takes are kept in RAM only (%d s)", REC_MAX_SEC);
+        return;
+    }
+
+    if (rec_sd_start_failed) {
+        lv_label_set_text(record_sd_label, "Could not start a file for this take: kept in RAM only");
+        return;
+    }
+
+    recorder_stats_t st;
+    recorder_get_stats(&st);
+    if (st.path[0] == '\0') {
+        lv_label_set_text(record_sd_label, "SD card ready");
+        return;
+    }
+
+    char buf[128];
+    snprintf(buf, sizeof(buf), "%s %s  %.1f s   Dropped blocks: %lu%s",
+             st.active ? "Recording" : "Saved", st.path,
+             (float)st.samples / SAMPLE_RATE, (unsigned long)st.dropped,
+             st.write_errors ? "   WRITE ERROR" : "");
+    lv_label_set_text(record_sd_label, buf);
+}
+
 void create_record_screen(void)
 {
     record_scr = lv_obj_create(NULL);
@@ -1161,21 +1937,172 @@ void create_record_screen(void)
     lv_label_set_text(lbl_rec, "HOLD TO RECORD");
     lv_obj_center(lbl_rec);
 
-    // Audio spectrogram canvas
-    record_canvas = lv_canvas_create(record_scr);
-    lv_obj_set_size(record_canvas, 640, 240);
-    lv_obj_align(record_canvas, LV_ALIGN_BOTTOM_MID, 0, -40);
-    lv_obj_set_style_border_color(record_canvas, lv_color_hex(0x555555), 0);
-    lv_obj_set_style_border_width(record_canvas, 2, 0);
+    // Live input monitoring through the speaker, alongside the synth
+    lv_obj_t * mon_sw = lv_switch_create(record_scr);
+    lv_obj_align(mon_sw, LV_ALIGN_TOP_LEFT, 30, 100);
+    lv_obj_add_event_cb(mon_sw, monitor_switch_event_cb, LV_EVENT_VALUE_CHANGED, NULL);
+
+    lv_obj_t * mon_label = lv_label_create(record_scr);
+    lv_obj_set_style_text_color(mon_label, lv_color_white(), 0);
+    lv_obj_align(mon_label, LV_ALIGN_TOP_LEFT, 30, 140);
+    lv_label_set_text(mon_label, "Monitor input");
+
+    // Streaming recorder status
+    record_sd_label = lv_label_create(record_scr);
+    lv_obj_set_style_text_color(record_sd_label, lv_color_white(), 0);
+    lv_obj_align(record_sd_label, LV_ALIGN_TOP_MID, 0, 345);
+    lv_label_set_text(record_sd_label, "");
+    lv_timer_create(update_record_sd_cb, 250, NULL);
+
+    // Live scrolling analyzer
+    lv_obj_t * live_sw = lv_switch_create(record_scr);
+    lv_obj_align(live_sw, LV_ALIGN_TOP_LEFT, 30, 180);
+    lv_obj_add_event_cb(live_sw, live_switch_event_cb, LV_EVENT_VALUE_CHANGED, NULL);
+
+    lv_obj_t * live_label = lv_label_create(record_scr);
+    lv_obj_set_style_text_color(live_label, lv_color_white(), 0);
+    lv_obj_align(live_label, LV_ALIGN_TOP_LEFT, 30, 220);
+    lv_label_set_text(live_label, "Live analyzer");
+
+    record_live_label = lv_label_create(record_scr);
+    lv_obj_set_style_text_color(record_live_label, lv_color_white(), 0);
+    lv_obj_align(record_live_label, LV_ALIGN_TOP_MID, 0, 375);
+    lv_label_set_text(record_live_label, "");
+
+    // Audio spectrogram: a bordered frame around a clipping view that holds
+    // two canvases sharing one buffer
+    lv_obj_t * frame = lv_obj_create(record_scr);
+    lv_obj_set_size(frame, REC_CANVAS_W + 4, REC_CANVAS_H + 4);
+    lv_obj_align(frame, LV_ALIGN_BOTTOM_MID, 0, -38);
+    lv_obj_set_style_bg_color(frame, lv_color_hex(0x000000), 0);
+    lv_obj_set_style_border_color(frame, lv_color_hex(0x555555), 0);
+    lv_obj_set_style_border_width(frame, 2, 0);
+    lv_obj_set_style_radius(frame, 0, 0);
+    lv_obj_set_style_pad_all(frame, 0, 0);
+    lv_obj_remove_flag(frame, LV_OBJ_FLAG_SCROLLABLE);
+
+    lv_obj_t * view = lv_obj_create(frame);
+    lv_obj_set_size(view, REC_CANVAS_W, REC_CANVAS_H);
+    lv_obj_set_pos(view, 0, 0);
+    lv_obj_set_style_bg_opa(view, LV_OPA_TRANSP, 0);
+    lv_obj_set_style_border_width(view, 0, 0);
+    lv_obj_set_style_radius(view, 0, 0);
+    lv_obj_set_style_pad_all(view, 0, 0);
+    lv_obj_remove_flag(view, LV_OBJ_FLAG_SCROLLABLE);
+    lv_obj_add_event_cb(view, record_view_event_cb, LV_EVENT_ALL, NULL);
+
+    record_canvas = lv_canvas_create(view);
+    lv_obj_set_size(record_canvas, REC_CANVAS_W, REC_CANVAS_H);
+    record_canvas_wrap = lv_canvas_create(view);
+    lv_obj_set_size(record_canvas_wrap, REC_CANVAS_W, REC_CANVAS_H);
+    record_view_scroll(0);
 
     // Allocate the draw buffer for a 640x240 RGB565 canvas from PSRAM
-    size_t canvas_size = 640 * 240 * 2;
+    size_t canvas_size = REC_CANVAS_W * REC_CANVAS_H * 2;
     record_canvas_raw_buf = heap_caps_malloc(canvas_size + 128, MALLOC_CAP_SPIRAM);
     if (record_canvas_raw_buf) {
         record_canvas_aligned_buf = (uint8_t *)(((uintptr_t)record_canvas_raw_buf + 63) & ~63);
-        lv_canvas_set_buffer(record_canvas, record_canvas_aligned_buf, 640, 240, LV_COLOR_FORMAT_RGB565);
+        lv_canvas_set_buffer(record_canvas, record_canvas_aligned_buf, REC_CANVAS_W, REC_CANVAS_H, LV_COLOR_FORMAT_RGB565);
+        lv_canvas_set_buffer(record_canvas_wrap, record_canvas_aligned_buf, REC_CANVAS_W, REC_CANVAS_H, LV_COLOR_FORMAT_RGB565);
         lv_canvas_fill_bg(record_canvas, lv_color_hex(0x000000), LV_OPA_COVER);
     }
+    record_stft_ok = stft_cache_init(&record_stft, 1024, REC_STFT_HOP, REC_CANVAS_H,
+                                     FREQ_SCALE_LOG, SAMPLE_RATE, REC_BUFFER_SAMPLES);
+    if (!record_stft_ok) {
+        printf("Spectrogram: Failed to allocate the STFT cache\n");
+    }
+
+    record_live_codes = heap_caps_malloc(REC_CANVAS_W * REC_CANVAS_H, MALLOC_CAP_SPIRAM);
+    if (record_live_codes) {
+        spectro_live_cfg_t live = {
+            .fft_size = LIVE_FFT_SIZE,
+            .hop = LIVE_HOP,
+            .width = REC_CANVAS_W,
+            .height = REC_CANVAS_H,
+            .scale = FREQ_SCALE_LOG,
+            .sample_rate = SAMPLE_RATE,
+            .codes = record_live_codes,
+        };
+        if (!spectro_live_init(&live)) {
+            printf("Live analyzer: Failed to start\n");
+        }
+    }
+
+    // Spectrogram colour map
+    spectro_set_palette(SPECTRO_PALETTE_HEATMAP);
+    lv_obj_t * pal_dd = lv_dropdown_create(record_scr);
+    lv_dropdown_set_options(pal_dd, "Heatmap\nGrayscale\nViridis");
+    lv_obj_set_width(pal_dd, 150);
+    lv_obj_align(pal_dd, LV_ALIGN_TOP_RIGHT, -30, 100);
+    lv_obj_add_event_cb(pal_dd, palette_dropdown_event_cb, LV_EVENT_VALUE_CHANGED, NULL);
+
+    // Clip library: codec for new takes, stored takes, playback and saving
+    lv_obj_t * codec_dd = lv_dropdown_create(record_scr);
+    lv_dropdown_set_options(codec_dd, "ADPCM 4:1\nu-law 2:1");
+    lv_obj_set_width(codec_dd, 150);
+    lv_obj_align(codec_dd, LV_ALIGN_TOP_RIGHT, -30, 150);
+    lv_obj_add_event_cb(codec_dd, codec_dropdown_event_cb, LV_EVENT_VALUE_CHANGED, NULL);
+
+    record_clips_dd = lv_dropdown_create(record_scr);
+    lv_obj_set_width(record_clips_dd, 150);
+    lv_obj_align(record_clips_dd, LV_ALIGN_TOP_RIGHT, -30, 200);
+    record_clips_refresh(clip_library_count() - 1);
+
+    lv_obj_t * btn_play = lv_btn_create(record_scr);
+    lv_obj_set_size(btn_play, 70, 40);
+    lv_obj_align(btn_play, LV_ALIGN_TOP_RIGHT, -110, 250);
+    lv_obj_t * lbl_play = lv_label_create(btn_play);
+    lv_label_set_text(lbl_play, "Play");
+    lv_obj_center(lbl_play);
+    lv_obj_add_event_cb(btn_play, btn_clip_play_cb, LV_EVENT_CLICKED, NULL);
+
+    lv_obj_t * btn_save = lv_btn_create(record_scr);
+    lv_obj_set_size(btn_save, 70, 40);
+    lv_obj_align(btn_save, LV_ALIGN_TOP_RIGHT, -30, 250);
+    lv_obj_t * lbl_save = lv_label_create(btn_save);
+    lv_label_set_text(lbl_save, "Save");
+    lv_obj_center(lbl_save);
+    lv_obj_add_event_cb(btn_save, btn_clip_save_cb, LV_EVENT_CLICKED, NULL);
+
+    record_clips_label = lv_label_create(record_scr);
+    lv_obj_set_style_text_color(record_clips_label, lv_color_white(), 0);
+    lv_obj_align(record_clips_label, LV_ALIGN_TOP_RIGHT, -30, 300);
+    lv_label_set_text(record_clips_label, "");
+    lv_timer_create(update_record_clips_cb, 250, NULL);
+
+    lv_timer_create(update_record_finish_cb, 10, NULL);
+    lv_timer_create(update_record_spectro_cb, 20, NULL);
+    lv_timer_create(update_record_live_cb, 20, NULL);
+    lv_timer_create(update_record_live_stats_cb, 1000, NULL);
+}
+
+static void update_synth_load_cb(lv_timer_t * timer)
+{
+    if (!synth_load_bar || !synth_load_label) return;
+    if (lv_scr_act() != synth_scr) return;
+
+    audio_load_stats_t load;
+    audio_diag_get_load(&load);
+
+    int pct = (int)(load.avg * 100.0f + 0.5f);
+    lv_bar_set_value(synth_load_bar, pct > 100 ? 100 : pct, LV_ANIM_OFF);
+    lv_color_t col = load.p99 > 0.9f ? lv_palette_main(LV_PALETTE_RED)
+                   : load.p99 > 0.7f ? lv_palette_main(LV_PALETTE_AMBER)
+                   : lv_palette_main(LV_PALETTE_GREEN);
+    lv_obj_set_style_bg_color(synth_load_bar, col, LV_PART_INDICATOR);
+    lv_label_set_text_fmt(synth_load_label, "CPU %d%%", pct);
+}
+
+// Highlights the step the audio thread played last
+static void update_seq_cb(lv_timer_t * timer)
+{
+    if (!seq_step_btns[0] || lv_scr_act() != synth_scr) return;
+
+    int step = sequencer_current_step();
+    if (step == seq_shown_step) return;
+    if (seq_shown_step >= 0) lv_obj_set_style_bg_color(seq_step_btns[seq_shown_step], lv_color_hex(0x444444), 0);
+    if (step >= 0) lv_obj_set_style_bg_color(seq_step_btns[step], lv_palette_main(LV_PALETTE_AMBER), 0);
+    seq_shown_step = step;
 }
 
 void create_synth_ui(void)
@@ -1198,6 +2125,21 @@ void create_synth_ui(void)
     lv_obj_align(time_label_synth, LV_ALIGN_LEFT_MID, 10, 0);
     lv_label_set_text(time_label_synth, "Waiting for Wi-Fi...");
 
+    // Audio engine CPU load, share of the block period
+    synth_load_bar = lv_bar_create(header);
+    lv_obj_set_size(synth_load_bar, 80, 12);
+    lv_obj_align(synth_load_bar, LV_ALIGN_LEFT_MID, 165, 0);
+    lv_bar_set_range(synth_load_bar, 0, 100);
+    lv_obj_set_style_bg_color(synth_load_bar, lv_color_hex(0x333333), 0);
+
+    synth_load_label = lv_label_create(header);
+    lv_obj_set_style_text_font(synth_load_label, &lv_font_montserrat_14, 0);
+    lv_obj_set_style_text_color(synth_load_label, lv_color_white(), 0);
+    lv_obj_align(synth_load_label, LV_ALIGN_LEFT_MID, 252, 0);
+    lv_label_set_text(synth_load_label, "CPU --");
+
+    lv_timer_create(update_synth_load_cb, 200, NULL);
+
     // Add Back Button
     lv_obj_t * btn_back = lv_btn_create(header);
     lv_obj_set_size(btn_back, 80, 40);
@@ -1267,6 +2209,40 @@ void create_synth_ui(void)
         lv_label_set_text(lbl, sl_labels[s]);
     }
 
+    // Step sequencer / arpeggiator. Timing comes from the audio sample clock;
+    // the UI only edits the pattern and mode.
+    lv_obj_t * seq_dd = lv_dropdown_create(scr);
+    lv_dropdown_set_options(seq_dd, "Seq Off\nPattern\nArp Up\nArp Down\nArp Up/Down");
+    lv_obj_set_width(seq_dd, 150);
+    lv_obj_align(seq_dd, LV_ALIGN_TOP_LEFT, 20, 290);
+    lv_obj_add_event_cb(seq_dd, seq_mode_dropdown_event_cb, LV_EVENT_VALUE_CHANGED, NULL);
+
+    lv_obj_t * bpm_slider = lv_slider_create(scr);
+    lv_obj_set_size(bpm_slider, 300, 15);
+    lv_obj_align(bpm_slider, LV_ALIGN_TOP_LEFT, 200, 303);
+    lv_slider_set_range(bpm_slider, 40, 240);
+    lv_slider_set_value(bpm_slider, 120, LV_ANIM_OFF);
+    lv_obj_add_event_cb(bpm_slider, seq_bpm_slider_event_cb, LV_EVENT_VALUE_CHANGED, NULL);
+
+    seq_bpm_label = lv_label_create(scr);
+    lv_obj_set_style_text_color(seq_bpm_label, lv_color_white(), 0);
+    lv_obj_align(seq_bpm_label, LV_ALIGN_TOP_LEFT, 530, 300);
+    lv_label_set_text(seq_bpm_label, "120 BPM");
+
+    int step_w = (LCD_H_RES - 40) / SEQ_STEPS;
+    for (int i = 0; i < SEQ_STEPS; i++) {
+        seq_step_btns[i] = lv_btn_create(scr);
+        lv_obj_set_size(seq_step_btns[i], step_w - 4, 50);
+        lv_obj_align(seq_step_btns[i], LV_ALIGN_TOP_LEFT, 20 + i * step_w, 350);
+        lv_obj_set_style_bg_color(seq_step_btns[i], lv_color_hex(0x444444), 0);
+        lv_obj_set_style_pad_all(seq_step_btns[i], 0, 0);
+        lv_obj_t * lbl = lv_label_create(seq_step_btns[i]);
+        lv_obj_center(lbl);
+        seq_step_label_update(i);
+        lv_obj_add_event_cb(seq_step_btns[i], seq_step_event_cb, LV_EVENT_CLICKED, (void*)(intptr_t)i);
+    }
+    lv_timer_create(update_seq_cb, 30, NULL);
+
     // Keyboard container
     lv_obj_t * kb_cont = lv_obj_create(scr);
     int kb_w = LCD_H_RES - 40;
@@ -1330,33 +2306,52 @@ void app_main(void)
     ESP_ERROR_CHECK(ret);
 
     // 2. Hardware (Display & Audio)
-    bsp_display_start();
+    // The LVGL port task takes its core, priority and stack from the task
+    // topology table instead of the BSP defaults
+    const task_slot_t * ui_slot = task_topology_get(TASK_UI);
+    bsp_display_cfg_t disp_cfg = {
+        .lvgl_port_cfg = ESP_LVGL_PORT_INIT_CONFIG(),
+        .buffer_size = BSP_LCD_DRAW_BUFF_SIZE,
+        .double_buffer = BSP_LCD_DRAW_BUFF_DOUBLE,
+        .flags = {
+            .buff_dma = true,
+            .buff_spiram = false,
+        },
+    };
+    disp_cfg.lvgl_port_cfg.task_priority = ui_slot->priority;
+    disp_cfg.lvgl_port_cfg.task_stack = ui_slot->stack;
+    disp_cfg.lvgl_port_cfg.task_affinity = ui_slot->core;
+    bsp_display_start_with_config(&disp_cfg);
     bsp_display_backlight_on();
 
-    if (bsp_audio_init(NULL) == ESP_OK) {
-        spk_codec_dev = bsp_audio_codec_speaker_init();
-        if (spk_codec_dev) {
-            esp_codec_dev_sample_info_t fs = {
-                .sample_rate = SAMPLE_RATE,
-                .channel = 1,
-                .bits_per_sample = 16,
-            };
-            esp_codec_dev_open(spk_codec_dev, &fs);
-            esp_codec_dev_set_out_vol(spk_codec_dev, 70);
-        }
-
-        mic_codec_dev = bsp_audio_codec_microphone_init();
-        if (mic_codec_dev) {
-            esp_codec_dev_sample_info_t fs_mic = {
-                .sample_rate = SAMPLE_RATE,
-                .channel = 1,
-                .bits_per_sample = 16,
-            };
-            esp_codec_dev_open(mic_codec_dev, &fs_mic);
-        }
+    // Speaker and microphone, with the I2S DMA queue sized for the block
+    if (audio_io_init(SAMPLE_RATE, SYNTH_BLOCK_SIZE)) {
+        audio_io_lock = xSemaphoreCreateMutex();
+    } else {
+        printf("Audio: No audio codec\n");
     }
 
     rec_buffer = malloc(REC_BUFFER_SAMPLES * sizeof(int16_t));
+    mic_ring_ok = audio_ring_init(&mic_ring, MIC_RING_SAMPLES);
+
+    // Full takes stream to the SD card when one is inserted
+    if (bsp_sdcard_mount() == ESP_OK) {
+        rec_sd_ok = recorder_init(BSP_SD_MOUNT_POINT, SAMPLE_RATE);
+    } else {
+        printf("Recorder: No SD card, recordings stay in RAM\n");
+    }
+
+    // Compressed takes, restored from the clips partition
+    clips_ok = clip_library_init(CLIP_ARENA_BYTES);
+    if (clips_ok) {
+        if (clip_store_init(clip_store_quiet)) clip_store_load();
+    } else {
+        printf("Clips: Failed to allocate the clip library\n");
+    }
+
+    if (!audio_engine_init((float)SAMPLE_RATE)) {
+        printf("Synth: Failed to allocate wavetables, the synth will be silent\n");
+    }
 
     // 3. Wi-Fi Initialization (Over SDIO to the C6)
     ESP_ERROR_CHECK(esp_netif_init());
@@ -1385,11 +2380,15 @@ void app_main(void)
     setenv("TZ", "CET-1CEST,M3.5.0,M10.5.0/3", 1);
     tzset();
 
-    // 5. Start Audio Task
-    xTaskCreate(audio_task, "audio_task", 4096, NULL, 5, NULL);
+    // 5. Start Audio Task (core and priority come from task_topology.c)
+    task_topology_start(TASK_AUDIO, audio_task, NULL);
+    task_topology_start(TASK_CAPTURE, capture_task, NULL);
+    if (!spectro_job_init()) {
+        printf("Spectrogram: Failed to start the worker task\n");
+    }
 
     // Start BMP280 sensor task (I2C bus is ready after bsp_display_start)
-    xTaskCreate(bmp280_task, "bmp280_task", 4096, NULL, 3, NULL);
+    task_topology_start(TASK_SENSOR, bmp280_task, NULL);
 
     // 6. Build the UI
     bsp_display_lock(0);
@@ -1400,6 +2399,8 @@ void app_main(void)
     create_weather_screen();
     init_joystick_hw();
     create_joystick_screen();
+    create_diag_screen();
+    create_tasks_screen();
     create_notes_screens(main_menu_scr, btn_go_menu_cb);
 
     // Start global update timer
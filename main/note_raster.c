@@ -0,0 +1,51 @@
+#include "note_raster.h"
+
+// Draw tasks pile up in the layer until it is dispatched, so long strokes
+// are finished and a fresh layer started every so many segments to bound
+// the memory they take
+#define NOTE_RASTER_BATCH 64
+
+void note_raster_strokes(lv_obj_t *canvas, const note_stroke_t *strokes, uint32_t count,
+                         float sx, float sy, float wscale, lv_area_t *drawn)
+{
+    lv_area_t box = { INT32_MAX, INT32_MAX, INT32_MIN, INT32_MIN };
+    lv_layer_t layer;
+    lv_canvas_init_layer(canvas, &layer);
+
+    for (uint32_t s = 0; s < count; s++) {
+        const note_stroke_t * st = &strokes[s];
+        if (st->point_cnt < 2 || !st->points) continue;
+
+        lv_draw_line_dsc_t dsc;
+        lv_draw_line_dsc_init(&dsc);
+        dsc.color = st->color;
+        dsc.width = (int32_t)(st->width * wscale);
+        if (dsc.width < 1) dsc.width = 1;
+        dsc.round_start = 1;
+        dsc.round_end = 1;
+
+        int32_t pad = dsc.width / 2 + 1;
+        for (uint32_t k = 0; k + 1 < st->point_cnt; k++) {
+            dsc.p1.x = (lv_value_precise_t)(st->points[k].x * sx);
+            dsc.p1.y = (lv_value_precise_t)(st->points[k].y * sy);
+            dsc.p2.x = (lv_value_precise_t)(st->points[k + 1].x * sx);
+            dsc.p2.y = (lv_value_precise_t)(st->points[k + 1].y * sy);
+            lv_draw_line(&layer, &dsc);
+
+            int32_t x1 = LV_MIN(dsc.p1.x, dsc.p2.x) - pad, x2 = LV_MAX(dsc.p1.x, dsc.p2.x) + pad;
+            int32_t y1 = LV_MIN(dsc.p1.y, dsc.p2.y) - pad, y2 = LV_MAX(dsc.p1.y, dsc.p2.y) + pad;
+            if (x1 < box.x1) box.x1 = x1;
+            if (y1 < box.y1) box.y1 = y1;
+            if (x2 > box.x2) box.x2 = x2;
+            if (y2 > box.y2) box.y2 = y2;
+
+            if ((k + 1) % NOTE_RASTER_BATCH == 0) {
+                lv_canvas_finish_layer(canvas, &layer);
+                lv_canvas_init_layer(canvas, &layer);
+            }
+        }
+    }
+    lv_canvas_finish_layer(canvas, &layer);
+
+    if (drawn) *drawn = box;
+}
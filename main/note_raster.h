@@ -0,0 +1,14 @@
+#pragma once
+
+#include <stdint.h>
+#include "lvgl.h"
+#include "notes_store.h"
+
+// Draws strokes into a canvas buffer with LVGL's software renderer. Point
+// coordinates are scaled by sx and sy and widths by wscale (never below
+// 1 px). LVGL invalidates the whole canvas as each batch of segments is
+// finished, which costs nothing on a hidden canvas; the area drawn on, in
+// canvas coordinates, is returned in drawn if it is not NULL, so a visible
+// view of the same buffer can be redrawn over just that. UI thread only.
+void note_raster_strokes(lv_obj_t *canvas, const note_stroke_t *strokes, uint32_t count,
+                         float sx, float sy, float wscale, lv_area_t *drawn);
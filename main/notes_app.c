@@ -1,29 +1,30 @@
 #include "notes_app.h"
+#include "notes_store.h"
+#include "stroke_simplify.h"
+#include "note_raster.h"
 #include "esp_heap_caps.h"
 #include <stdio.h>
 #include <string.h>
-#include "nvs_flash.h"
-#include "nvs.h"
 
-#define MAX_NOTES 10
-#define MAX_STROKES_PER_NOTE 100
 #define LCD_H_RES 720
 #define LCD_V_RES 720
 
-typedef struct {
-    lv_point_precise_t * points;
-    uint32_t point_cnt;
-    uint32_t point_cap;
-    lv_color_t color;
-    uint16_t width;
-    lv_obj_t * edit_line_obj;
-} note_stroke_t;
-
-typedef struct {
-    bool in_use;
-    note_stroke_t strokes[MAX_STROKES_PER_NOTE];
-    uint32_t stroke_cnt;
-} note_data_t;
+// Pen-up clean-up. Points within the tolerance of the simplified line are
+// dropped; it grows with the pen width, since a wide line hides small shifts.
+#define STROKE_TOLERANCE_MIN 1.0f
+#define STROKE_SMOOTH_STEPS 8
+// Set to 1 to print each stroke's raw points on the console before the
+// clean-up, in the form host/bench_simplify reads from host/strokes/
+#define STROKE_DUMP 0
+
+// Drawing area. Strokes are drawn into the ink bitmap a segment at a time
+// as the finger moves; without the bitmap each stroke is a live lv_line.
+#define INK_W (LCD_H_RES - 20)
+#define INK_H (LCD_V_RES - 140)
+
+// Menu previews of the drawing area, drawn once per save
+#define THUMB_W 200
+#define THUMB_H 200
 
 static note_data_t notes_db[MAX_NOTES];
 static int target_note_idx = -1;
@@ -32,7 +33,12 @@ static int delete_note_idx = -1;
 static lv_obj_t * notes_menu_scr = NULL;
 static lv_obj_t * notes_edit_scr = NULL;
 static lv_obj_t * notes_list_cont = NULL;
+static lv_obj_t * thumb_canvas = NULL;     // hidden, draws into thumb_px
+static uint16_t * thumb_px[MAX_NOTES];
+static lv_image_dsc_t thumb_dsc[MAX_NOTES];
 static lv_obj_t * draw_canvas_area = NULL;
+static lv_obj_t * ink_canvas = NULL;
+static lv_obj_t * ink_raster = NULL;       // hidden, draws into the ink bitmap
 static lv_obj_t * note_delete_mbox = NULL;
 static lv_event_cb_t main_menu_cb_ptr = NULL;
 static lv_obj_t * main_menu_scr_ptr = NULL;
@@ -43,146 +49,115 @@ static note_stroke_t * current_stroke = NULL;
 static lv_color_t active_color;
 static uint16_t active_width = 5;
 static bool is_eraser = false;
+static bool smooth_strokes = false;
 
 static void render_thumbnails(void);
 static void open_note_edit(int idx);
+static void btn_delete_no_cb(lv_event_t * e);
 
-static void save_notes_to_nvs(void) {
-    nvs_handle_t my_handle;
-    esp_err_t err = nvs_open("notes_storage", NVS_READWRITE, &my_handle);
-    if (err != ESP_OK) return;
-
-    size_t required_size = sizeof(uint32_t); // Format version
-
-    // First, calculate total size required
-    for (int i = 0; i < MAX_NOTES; i++) {
-        required_size += sizeof(bool); // in_use
-        if (notes_db[i].in_use) {
-            required_size += sizeof(uint32_t); // stroke_cnt
-            for (uint32_t s = 0; s < notes_db[i].stroke_cnt; s++) {
-                required_size += sizeof(uint32_t); // point_cnt
-                required_size += sizeof(uint16_t); // width
-                required_size += 3; // R, G, B colors
-                required_size += notes_db[i].strokes[s].point_cnt * sizeof(lv_point_precise_t);
-            }
-        }
-    }
-
-    uint8_t * blob = heap_caps_malloc(required_size, MALLOC_CAP_SPIRAM);
-    if (!blob) {
-        nvs_close(my_handle);
-        return;
+// Strokes are read from flash the first time a note is shown. A note that
+// cannot be read stays unloaded and is tried again next time.
+static bool note_ensure_loaded(int idx) {
+    if (notes_db[idx].in_use && !notes_db[idx].loaded) {
+        return notes_store_load(idx, &notes_db[idx]);
     }
+    return true;
+}
 
-    uint8_t * ptr = blob;
-    uint32_t version = 2;
-    memcpy(ptr, &version, sizeof(uint32_t)); ptr += sizeof(uint32_t);
-
-    for (int i = 0; i < MAX_NOTES; i++) {
-        bool in_use = notes_db[i].in_use;
-        memcpy(ptr, &in_use, sizeof(bool)); ptr += sizeof(bool);
-
-        if (in_use) {
-            uint32_t sc = notes_db[i].stroke_cnt;
-            memcpy(ptr, &sc, sizeof(uint32_t)); ptr += sizeof(uint32_t);
-
-            for (uint32_t s = 0; s < sc; s++) {
-                uint32_t pc = notes_db[i].strokes[s].point_cnt;
-                memcpy(ptr, &pc, sizeof(uint32_t)); ptr += sizeof(uint32_t);
+static void note_error_show(const char * text) {
+    note_delete_mbox = lv_msgbox_create(NULL);
+    lv_msgbox_add_title(note_delete_mbox, "Error");
+    lv_msgbox_add_text(note_delete_mbox, text);
+    lv_obj_t * btn_ok = lv_msgbox_add_footer_button(note_delete_mbox, "OK");
+    lv_obj_add_event_cb(btn_ok, btn_delete_no_cb, LV_EVENT_CLICKED, NULL);
+}
 
-                uint16_t w = notes_db[i].strokes[s].width;
-                memcpy(ptr, &w, sizeof(uint16_t)); ptr += sizeof(uint16_t);
+// Rasterizes a note's strokes into its thumbnail bitmap
+static bool thumb_render(int idx) {
+    if (!thumb_canvas) return false;
+    if (!thumb_px[idx]) {
+        thumb_px[idx] = heap_caps_malloc(THUMB_W * THUMB_H * sizeof(uint16_t), MALLOC_CAP_SPIRAM);
+        if (!thumb_px[idx]) return false;
+    }
+    if (!note_ensure_loaded(idx)) return false;
+
+    lv_canvas_set_buffer(thumb_canvas, thumb_px[idx], THUMB_W, THUMB_H, LV_COLOR_FORMAT_RGB565);
+    lv_canvas_fill_bg(thumb_canvas, lv_color_white(), LV_OPA_COVER);
+    note_raster_strokes(thumb_canvas, notes_db[idx].strokes, notes_db[idx].stroke_cnt,
+                        (float)THUMB_W / INK_W, (float)THUMB_H / INK_H,
+                        1.0f / 3.0f, NULL);
+    return true;
+}
 
-                lv_color_t c = notes_db[i].strokes[s].color;
-                *ptr++ = c.red;
-                *ptr++ = c.green;
-                *ptr++ = c.blue;
+static void thumb_drop(int idx) {
+    heap_caps_free(thumb_px[idx]);
+    thumb_px[idx] = NULL;
+}
 
-                size_t points_size = pc * sizeof(lv_point_precise_t);
-                memcpy(ptr, notes_db[i].strokes[s].points, points_size); ptr += points_size;
+// The cached thumbnail, read from flash or drawn from the strokes the
+// first time it is asked for
+static const lv_image_dsc_t * thumb_get(int idx) {
+    if (!thumb_px[idx]) {
+        thumb_px[idx] = heap_caps_malloc(THUMB_W * THUMB_H * sizeof(uint16_t), MALLOC_CAP_SPIRAM);
+        if (!thumb_px[idx]) return NULL;
+        if (!notes_store_load_thumb(idx, thumb_px[idx], THUMB_W * THUMB_H)) {
+            if (!thumb_render(idx)) {
+                thumb_drop(idx);
+                return NULL;
             }
+            notes_store_save_thumb(idx, thumb_px[idx], THUMB_W * THUMB_H);
         }
     }
 
-    nvs_set_blob(my_handle, "notes_blob", blob, required_size);
-    nvs_commit(my_handle);
-    nvs_close(my_handle);
-    heap_caps_free(blob);
+    lv_image_dsc_t * dsc = &thumb_dsc[idx];
+    memset(dsc, 0, sizeof(*dsc));
+    dsc->header.magic = LV_IMAGE_HEADER_MAGIC;
+    dsc->header.cf = LV_COLOR_FORMAT_RGB565;
+    dsc->header.w = THUMB_W;
+    dsc->header.h = THUMB_H;
+    dsc->header.stride = THUMB_W * sizeof(uint16_t);
+    dsc->data_size = THUMB_W * THUMB_H * sizeof(uint16_t);
+    dsc->data = (const uint8_t *)thumb_px[idx];
+    return dsc;
 }
 
-static void load_notes_from_nvs(void) {
-    nvs_handle_t my_handle;
-    esp_err_t err = nvs_open("notes_storage", NVS_READONLY, &my_handle);
-    if (err != ESP_OK) return;
-
-    size_t required_size = 0;
-    err = nvs_get_blob(my_handle, "notes_blob", NULL, &required_size);
-    if (err != ESP_OK || required_size == 0) {
-        nvs_close(my_handle);
-        return;
-    }
-
-    uint8_t * blob = heap_caps_malloc(required_size, MALLOC_CAP_SPIRAM);
-    if (!blob) {
-        nvs_close(my_handle);
-        return;
-    }
-
-    err = nvs_get_blob(my_handle, "notes_blob", blob, &required_size);
-    if (err != ESP_OK) {
-        heap_caps_free(blob);
-        nvs_close(my_handle);
-        return;
-    }
+static lv_obj_t * stroke_line_create(note_stroke_t * st) {
+    lv_obj_t * line = lv_line_create(draw_canvas_area);
+    lv_obj_align(line, LV_ALIGN_TOP_LEFT, 0, 0);
+    lv_obj_set_style_line_color(line, st->color, 0);
+    lv_obj_set_style_line_width(line, st->width, 0);
+    lv_obj_set_style_line_rounded(line, true, 0);
+    lv_obj_add_flag(line, LV_OBJ_FLAG_EVENT_BUBBLE);
+    lv_line_set_points(line, st->points, st->point_cnt);
+    return line;
+}
 
-    uint8_t * ptr = blob;
-    uint32_t version = 0;
-    memcpy(&version, ptr, sizeof(uint32_t)); ptr += sizeof(uint32_t);
-
-    if (version == 1 || version == 2) {
-        for (int i = 0; i < MAX_NOTES; i++) {
-            bool in_use = false;
-            memcpy(&in_use, ptr, sizeof(bool)); ptr += sizeof(bool);
-            notes_db[i].in_use = in_use;
-
-            if (in_use) {
-                uint32_t sc = 0;
-                memcpy(&sc, ptr, sizeof(uint32_t)); ptr += sizeof(uint32_t);
-                notes_db[i].stroke_cnt = sc;
-
-                for (uint32_t s = 0; s < sc; s++) {
-                    uint32_t pc = 0;
-                    memcpy(&pc, ptr, sizeof(uint32_t)); ptr += sizeof(uint32_t);
-                    notes_db[i].strokes[s].point_cnt = pc;
-                    notes_db[i].strokes[s].point_cap = pc;
-
-                    uint16_t w = 0;
-                    memcpy(&w, ptr, sizeof(uint16_t)); ptr += sizeof(uint16_t);
-                    notes_db[i].strokes[s].width = w;
-                    
-                    if (version == 2) {
-                        uint8_t cr = *ptr++;
-                        uint8_t cg = *ptr++;
-                        uint8_t cb = *ptr++;
-                        notes_db[i].strokes[s].color = lv_color_make(cr, cg, cb);
-                    } else {
-                        notes_db[i].strokes[s].color = lv_color_black();
-                    }
-                    
-                    notes_db[i].strokes[s].edit_line_obj = NULL;
-
-                    size_t points_size = pc * sizeof(lv_point_precise_t);
-                    notes_db[i].strokes[s].points = heap_caps_malloc(points_size, MALLOC_CAP_SPIRAM);
-                    memcpy(notes_db[i].strokes[s].points, ptr, points_size); ptr += points_size;
-                }
-            } else {
-                notes_db[i].stroke_cnt = 0;
-            }
+// Live lines of a note, one per stroke when there is no ink bitmap
+static void edit_lines_clear(int idx) {
+    for (uint32_t i = 0; i < notes_db[idx].stroke_cnt; i++) {
+        note_stroke_t * st = &notes_db[idx].strokes[i];
+        if (st->edit_line_obj) {
+            lv_obj_delete(st->edit_line_obj);
+            st->edit_line_obj = NULL;
         }
     }
+}
 
-    heap_caps_free(blob);
-    nvs_close(my_handle);
+// Draws ink into the bitmap. It is rasterized through the hidden canvas, so
+// only the area it covers is redrawn on screen, however much ink the note
+// already holds.
+static void ink_bake(const note_stroke_t * st) {
+    lv_area_t box;
+    note_raster_strokes(ink_raster, st, 1, 1.0f, 1.0f, 1.0f, &box);
+    if (box.x1 > box.x2) return;
+
+    lv_area_t c;
+    lv_obj_get_coords(ink_canvas, &c);
+    box.x1 += c.x1;
+    box.x2 += c.x1;
+    box.y1 += c.y1;
+    box.y2 += c.y1;
+    lv_obj_invalidate_area(ink_canvas, &box);
 }
 
 static void btn_go_notes_cb_internal(lv_event_t * e) {
@@ -198,23 +173,18 @@ void btn_go_notes_cb(lv_event_t * e) {
 
 static void btn_save_note_cb(lv_event_t * e) {
     if (target_note_idx >= 0 && target_note_idx < MAX_NOTES) {
-        for (uint32_t i = 0; i < notes_db[target_note_idx].stroke_cnt; i++) {
-            notes_db[target_note_idx].strokes[i].edit_line_obj = NULL;
+        edit_lines_clear(target_note_idx);
+        if (!notes_store_save(target_note_idx, &notes_db[target_note_idx])) {
+            note_error_show("Could not save the note.");
+        } else if (thumb_render(target_note_idx)) {
+            notes_store_save_thumb(target_note_idx, thumb_px[target_note_idx], THUMB_W * THUMB_H);
         }
     }
 
-    save_notes_to_nvs();
-
-    lv_obj_clean(draw_canvas_area);
     render_thumbnails();
     lv_scr_load(notes_menu_scr);
 }
 
-static void free_points_cb(lv_event_t * e) {
-    lv_point_precise_t * pts = lv_event_get_user_data(e);
-    if(pts) heap_caps_free(pts);
-}
-
 static void btn_delete_yes_cb(lv_event_t * e) {
     if (delete_note_idx >= 0 && delete_note_idx < MAX_NOTES) {
         note_data_t * note = &notes_db[delete_note_idx];
@@ -227,7 +197,8 @@ static void btn_delete_yes_cb(lv_event_t * e) {
         note->stroke_cnt = 0;
         note->in_use = false;
 
-        save_notes_to_nvs();
+        thumb_drop(delete_note_idx);
+        notes_store_delete(delete_note_idx);
 
         render_thumbnails();
     }
@@ -263,22 +234,29 @@ static void thumb_event_cb(lv_event_t * e) {
 }
 
 static void open_note_edit(int idx) {
+    // Editing a note that could not be read would save it back empty
+    if (!note_ensure_loaded(idx)) {
+        note_error_show("This note could not be read from flash.");
+        return;
+    }
+
     target_note_idx = idx;
-    lv_obj_clean(draw_canvas_area);
+    if (ink_canvas) lv_canvas_fill_bg(ink_canvas, lv_color_white(), LV_OPA_COVER);
 
     if (!notes_db[idx].in_use) {
         notes_db[idx].in_use = true;
+        notes_db[idx].loaded = true;
         notes_db[idx].stroke_cnt = 0;
     } else {
-        for (uint32_t i = 0; i < notes_db[idx].stroke_cnt; i++) {
-            note_stroke_t * st = &notes_db[idx].strokes[i];
-            st->edit_line_obj = lv_line_create(draw_canvas_area);
-            lv_obj_align(st->edit_line_obj, LV_ALIGN_TOP_LEFT, 0, 0);
-            lv_obj_set_style_line_color(st->edit_line_obj, st->color, 0);
-            lv_obj_set_style_line_width(st->edit_line_obj, st->width, 0);
-            lv_obj_set_style_line_rounded(st->edit_line_obj, true, 0);
-            lv_obj_add_flag(st->edit_line_obj, LV_OBJ_FLAG_EVENT_BUBBLE);
-            lv_line_set_points(st->edit_line_obj, st->points, st->point_cnt);
+        // Existing ink is drawn once into the bitmap instead of becoming
+        // one object per stroke
+        if (ink_canvas) {
+            note_raster_strokes(ink_raster, notes_db[idx].strokes, notes_db[idx].stroke_cnt, 1.0f, 1.0f, 1.0f, NULL);
+            lv_obj_invalidate(ink_canvas);
+        } else {
+            for (uint32_t i = 0; i < notes_db[idx].stroke_cnt; i++) {
+                notes_db[idx].strokes[i].edit_line_obj = stroke_line_create(&notes_db[idx].strokes[i]);
+            }
         }
     }
 
@@ -292,11 +270,7 @@ static void btn_create_note_cb(lv_event_t * e) {
             return;
         }
     }
-    note_delete_mbox = lv_msgbox_create(NULL);
-    lv_msgbox_add_title(note_delete_mbox, "Error");
-    lv_msgbox_add_text(note_delete_mbox, "Maximum number of notes reached!");
-    lv_obj_t * btn_ok = lv_msgbox_add_footer_button(note_delete_mbox, "OK");
-    lv_obj_add_event_cb(btn_ok, btn_delete_no_cb, LV_EVENT_CLICKED, NULL);
+    note_error_show("Maximum number of notes reached!");
 }
 
 static void render_thumbnails(void) {
@@ -319,28 +293,18 @@ static void render_thumbnails(void) {
 
             lv_obj_add_event_cb(btn, thumb_event_cb, LV_EVENT_ALL, (void*)(intptr_t)i);
 
-            for (uint32_t s = 0; s < notes_db[i].stroke_cnt; s++) {
-                note_stroke_t * st = &notes_db[i].strokes[s];
-                if (st->point_cnt == 0 || st->points == NULL) continue;
-
-                lv_obj_t * l = lv_line_create(btn);
-                lv_obj_align(l, LV_ALIGN_TOP_LEFT, 0, 0);
-                lv_obj_set_style_line_color(l, st->color, 0);
-                // thumbnail scale width
-                int scaled_w = st->width / 3;
-                if (scaled_w < 1) scaled_w = 1;
-                lv_obj_set_style_line_width(l, scaled_w, 0);
-                lv_obj_add_flag(l, LV_OBJ_FLAG_EVENT_BUBBLE);
-
-                lv_point_precise_t * scaled_pts = heap_caps_malloc(st->point_cnt * sizeof(lv_point_precise_t), MALLOC_CAP_SPIRAM);
-                if (scaled_pts) {
-                    for(uint32_t p = 0; p < st->point_cnt; p++) {
-                        scaled_pts[p].x = (st->points[p].x * 200) / (LCD_H_RES - 20);
-                        scaled_pts[p].y = (st->points[p].y * 200) / (LCD_V_RES - 140);
-                    }
-                    lv_line_set_points(l, scaled_pts, st->point_cnt);
-                    lv_obj_add_event_cb(l, free_points_cb, LV_EVENT_DELETE, scaled_pts);
-                }
+            // One cached bitmap per note, whatever its amount of ink
+            const lv_image_dsc_t * dsc = thumb_get(i);
+            if (dsc) {
+                lv_obj_t * img = lv_image_create(btn);
+                lv_image_set_src(img, dsc);
+                lv_obj_center(img);
+                lv_obj_add_flag(img, LV_OBJ_FLAG_EVENT_BUBBLE);
+            } else if (!notes_db[i].loaded) {
+                lv_obj_t * lbl = lv_label_create(btn);
+                lv_label_set_text(lbl, "Unreadable note");
+                lv_obj_set_style_text_color(lbl, lv_color_hex(0xc00000), 0);
+                lv_obj_center(lbl);
             }
         }
     }
@@ -356,11 +320,57 @@ static void add_point_to_current_stroke(int32_t lx, int32_t ly) {
     current_stroke->points[current_stroke->point_cnt].y = ly;
     current_stroke->point_cnt++;
 
-    if (current_stroke->edit_line_obj) {
+    if (ink_canvas) {
+        // Only the new segment is drawn and redrawn on screen; a live line
+        // would invalidate everything from the canvas origin to its far end
+        if (current_stroke->point_cnt >= 2) {
+            note_stroke_t seg = *current_stroke;
+            seg.points = &current_stroke->points[current_stroke->point_cnt - 2];
+            seg.point_cnt = 2;
+            ink_bake(&seg);
+        }
+    } else if (current_stroke->edit_line_obj) {
         lv_line_set_points(current_stroke->edit_line_obj, current_stroke->points, current_stroke->point_cnt);
     }
 }
 
+static void finish_current_stroke(void) {
+    note_stroke_t * st = current_stroke;
+    if (!st || !st->points) return;
+
+    if (STROKE_DUMP) {
+        printf("stroke %d\n", st->width);
+        for (uint32_t i = 0; i < st->point_cnt; i++) {
+            printf("%d %d\n", (int)st->points[i].x, (int)st->points[i].y);
+        }
+    }
+
+    float tol = st->width / 4.0f;
+    if (tol < STROKE_TOLERANCE_MIN) tol = STROKE_TOLERANCE_MIN;
+    uint32_t n = stroke_simplify(st->points, st->point_cnt, tol);
+
+    if (smooth_strokes) {
+        lv_point_precise_t * out = heap_caps_malloc(stroke_smooth_max(n, STROKE_SMOOTH_STEPS) * sizeof(lv_point_precise_t), MALLOC_CAP_SPIRAM);
+        if (out) {
+            n = stroke_smooth(st->points, n, tol * 0.5f, STROKE_SMOOTH_STEPS, out);
+            heap_caps_free(st->points);
+            st->points = out;
+        }
+    }
+
+    // Give back what the point buffer no longer needs
+    lv_point_precise_t * shrunk = heap_caps_realloc(st->points, n * sizeof(lv_point_precise_t), MALLOC_CAP_SPIRAM);
+    if (shrunk) st->points = shrunk;
+    st->point_cnt = n;
+    st->point_cap = n;
+
+    // The ink already in the bitmap is what was drawn; the simplified
+    // points stay within the tolerance of it
+    if (st->edit_line_obj) {
+        lv_line_set_points(st->edit_line_obj, st->points, st->point_cnt);
+    }
+}
+
 static void draw_area_event_cb(lv_event_t * e) {
     lv_event_code_t code = lv_event_get_code(e);
     lv_indev_t * indev = lv_event_get_param(e);
@@ -385,13 +395,7 @@ static void draw_area_event_cb(lv_event_t * e) {
         current_stroke->points = heap_caps_malloc(128 * sizeof(lv_point_precise_t), MALLOC_CAP_SPIRAM);
         current_stroke->color = is_eraser ? lv_color_white() : active_color;
         current_stroke->width = active_width;
-
-        current_stroke->edit_line_obj = lv_line_create(draw_canvas_area);
-        lv_obj_align(current_stroke->edit_line_obj, LV_ALIGN_TOP_LEFT, 0, 0);
-        lv_obj_set_style_line_color(current_stroke->edit_line_obj, current_stroke->color, 0);
-        lv_obj_set_style_line_width(current_stroke->edit_line_obj, current_stroke->width, 0);
-        lv_obj_set_style_line_rounded(current_stroke->edit_line_obj, true, 0);
-        lv_obj_add_flag(current_stroke->edit_line_obj, LV_OBJ_FLAG_EVENT_BUBBLE);
+        current_stroke->edit_line_obj = ink_canvas ? NULL : stroke_line_create(current_stroke);
 
         add_point_to_current_stroke(lx, ly);
 
@@ -419,6 +423,7 @@ static void draw_area_event_cb(lv_event_t * e) {
         }
     }
     else if (code == LV_EVENT_RELEASED || code == LV_EVENT_PRESS_LOST) {
+        if (is_drawing) finish_current_stroke();
         is_drawing = false;
         current_stroke = NULL;
     }
@@ -434,6 +439,11 @@ static void eraser_btn_cb(lv_event_t * e) {
     is_eraser = true;
 }
 
+static void smooth_btn_cb(lv_event_t * e) {
+    lv_obj_t * btn = lv_event_get_target(e);
+    smooth_strokes = lv_obj_has_state(btn, LV_STATE_CHECKED);
+}
+
 static void slider_width_cb(lv_event_t * e) {
     lv_obj_t * slider = lv_event_get_target(e);
     active_width = lv_slider_get_value(slider);
@@ -445,12 +455,17 @@ void create_notes_screens(lv_obj_t * main_menu_scr, lv_event_cb_t go_menu_cb) {
 
     memset(notes_db, 0, sizeof(notes_db));
 
-    // Load notes from NVS
-    load_notes_from_nvs();
+    // Only the index is read here; strokes follow when a note is shown
+    if (!notes_store_init(notes_db)) {
+        printf("Notes: Failed to open the note store\n");
+    }
 
     notes_menu_scr = lv_obj_create(NULL);
     lv_obj_set_style_bg_color(notes_menu_scr, lv_color_hex(0x222222), 0);
 
+    thumb_canvas = lv_canvas_create(notes_menu_scr);
+    lv_obj_add_flag(thumb_canvas, LV_OBJ_FLAG_HIDDEN);
+
     lv_obj_t * header = lv_obj_create(notes_menu_scr);
     lv_obj_set_size(header, LCD_H_RES, 60);
     lv_obj_align(header, LV_ALIGN_TOP_MID, 0, 0);
@@ -535,6 +550,15 @@ void create_notes_screens(lv_obj_t * main_menu_scr, lv_event_cb_t go_menu_cb) {
     lv_label_set_text(lbl_eraser, "Eraser");
     lv_obj_center(lbl_eraser);
 
+    // Rounds off the corners of each stroke when the pen lifts
+    lv_obj_t * btn_smooth = lv_btn_create(tools_cont);
+    lv_obj_set_size(btn_smooth, 100, 40);
+    lv_obj_add_flag(btn_smooth, LV_OBJ_FLAG_CHECKABLE);
+    lv_obj_add_event_cb(btn_smooth, smooth_btn_cb, LV_EVENT_VALUE_CHANGED, NULL);
+    lv_obj_t * lbl_smooth = lv_label_create(btn_smooth);
+    lv_label_set_text(lbl_smooth, "Smooth");
+    lv_obj_center(lbl_smooth);
+
     lv_obj_t * width_cont = lv_obj_create(tools_cont);
     lv_obj_set_size(width_cont, 200, 50);
     lv_obj_set_style_bg_opa(width_cont, LV_OPA_TRANSP, 0);
@@ -553,4 +577,23 @@ void create_notes_screens(lv_obj_t * main_menu_scr, lv_event_cb_t go_menu_cb) {
     lv_obj_align(draw_canvas_area, LV_ALIGN_TOP_MID, 0, 65);
     lv_obj_clear_flag(draw_canvas_area, LV_OBJ_FLAG_SCROLLABLE);
     lv_obj_add_event_cb(draw_canvas_area, draw_area_event_cb, LV_EVENT_ALL, NULL);
+
+    // Sits where the stroke lines are placed, so stored points map 1:1 to
+    // its pixels
+    uint8_t * ink_buf = heap_caps_malloc(INK_W * INK_H * sizeof(uint16_t), MALLOC_CAP_SPIRAM);
+    if (ink_buf) {
+        ink_canvas = lv_canvas_create(draw_canvas_area);
+        lv_obj_align(ink_canvas, LV_ALIGN_TOP_LEFT, 0, 0);
+        lv_obj_add_flag(ink_canvas, LV_OBJ_FLAG_EVENT_BUBBLE);
+        lv_canvas_set_buffer(ink_canvas, ink_buf, INK_W, INK_H, LV_COLOR_FORMAT_RGB565);
+        lv_canvas_fill_bg(ink_canvas, lv_color_white(), LV_OPA_COVER);
+
+        // Same pixels, but LVGL's invalidation of a canvas on every finished
+        // layer is skipped while it is hidden
+        ink_raster = lv_canvas_create(notes_edit_scr);
+        lv_obj_add_flag(ink_raster, LV_OBJ_FLAG_HIDDEN);
+        lv_canvas_set_buffer(ink_raster, ink_buf, INK_W, INK_H, LV_COLOR_FORMAT_RGB565);
+    } else {
+        printf("Notes: No memory for the ink bitmap, drawing with line objects\n");
+    }
 }
@@ -0,0 +1,208 @@
+#include "notes_codec.h"
+#include "esp_heap_caps.h"
+#include <string.h>
+
+// Format 3 stores each stroke as a varint point count, its width and
+// RGB565 colour in 3 bytes, then its first point and the deltas to each
+// following point. A point is one varint holding the bits of its zigzagged
+// x and y deltas interleaved, so the usual few-pixel step fits in a byte
+// or two.
+
+static inline uint32_t zigzag(int32_t v)
+{
+    return ((uint32_t)v << 1) ^ (uint32_t)(v >> 31);
+}
+
+static inline int32_t unzigzag(uint32_t v)
+{
+    return (int32_t)(v >> 1) ^ -(int32_t)(v & 1);
+}
+
+// Spreads the bits of v over the even bits of the result
+static inline uint64_t bits_spread(uint32_t v)
+{
+    uint64_t x = v;
+    x = (x | (x << 16)) & 0x0000ffff0000ffffull;
+    x = (x | (x << 8))  & 0x00ff00ff00ff00ffull;
+    x = (x | (x << 4))  & 0x0f0f0f0f0f0f0f0full;
+    x = (x | (x << 2))  & 0x3333333333333333ull;
+    x = (x | (x << 1))  & 0x5555555555555555ull;
+    return x;
+}
+
+static inline uint32_t bits_gather(uint64_t x)
+{
+    x &= 0x5555555555555555ull;
+    x = (x | (x >> 1))  & 0x3333333333333333ull;
+    x = (x | (x >> 2))  & 0x0f0f0f0f0f0f0f0full;
+    x = (x | (x >> 4))  & 0x00ff00ff00ff00ffull;
+    x = (x | (x >> 8))  & 0x0000ffff0000ffffull;
+    x = (x | (x >> 16)) & 0x00000000ffffffffull;
+    return (uint32_t)x;
+}
+
+uint8_t * notes_put_varint(uint8_t *ptr, uint64_t v)
+{
+    while (v >= 0x80) {
+        *ptr++ = (uint8_t)(v | 0x80);
+        v >>= 7;
+    }
+    *ptr++ = (uint8_t)v;
+    return ptr;
+}
+
+const uint8_t * notes_get_varint(const uint8_t *ptr, const uint8_t *end, uint64_t *v)
+{
+    uint64_t out = 0;
+    for (int shift = 0; shift < 7 * NOTES_VARINT_MAX_BYTES; shift += 7) {
+        if (ptr >= end) return NULL;
+        uint8_t b = *ptr++;
+        out |= (uint64_t)(b & 0x7f) << shift;
+        if (!(b & 0x80)) {
+            *v = out;
+            return ptr;
+        }
+    }
+    return NULL;
+}
+
+size_t notes_codec_max_bytes(const note_data_t *note)
+{
+    size_t bytes = NOTES_VARINT_MAX_BYTES;
+    for (uint32_t s = 0; s < note->stroke_cnt; s++) {
+        bytes += NOTES_VARINT_MAX_BYTES + 3 + note->strokes[s].point_cnt * NOTES_VARINT_MAX_BYTES;
+    }
+    return bytes;
+}
+
+uint8_t * notes_codec_write(const note_data_t *note, uint8_t *ptr)
+{
+    ptr = notes_put_varint(ptr, note->stroke_cnt);
+
+    for (uint32_t s = 0; s < note->stroke_cnt; s++) {
+        const note_stroke_t * st = &note->strokes[s];
+        ptr = notes_put_varint(ptr, st->point_cnt);
+
+        *ptr++ = st->width > 255 ? 255 : (uint8_t)st->width;
+        uint16_t c565 = (uint16_t)(((st->color.red & 0xf8) << 8) | ((st->color.green & 0xfc) << 3) | (st->color.blue >> 3));
+        *ptr++ = (uint8_t)c565;
+        *ptr++ = (uint8_t)(c565 >> 8);
+
+        int32_t px = 0, py = 0;
+        for (uint32_t k = 0; k < st->point_cnt; k++) {
+            int32_t x = (int32_t)st->points[k].x;
+            int32_t y = (int32_t)st->points[k].y;
+            // Wrapping differences keep any coordinate pair reversible
+            uint32_t dx = zigzag((int32_t)((uint32_t)x - (uint32_t)px));
+            uint32_t dy = zigzag((int32_t)((uint32_t)y - (uint32_t)py));
+            ptr = notes_put_varint(ptr, bits_spread(dx) | (bits_spread(dy) << 1));
+            px = x;
+            py = y;
+        }
+    }
+    return ptr;
+}
+
+void notes_codec_free(note_data_t *note)
+{
+    for (uint32_t s = 0; s < note->stroke_cnt; s++) {
+        heap_caps_free(note->strokes[s].points);
+        note->strokes[s].points = NULL;
+    }
+    note->stroke_cnt = 0;
+}
+
+// Reads one note's strokes in format 1 (no colour) or 2, which hold raw
+// points. Returns the byte after them, or NULL if they run past end.
+static const uint8_t * strokes_read_raw(note_data_t *note, uint32_t version, const uint8_t *ptr, const uint8_t *end)
+{
+    note->stroke_cnt = 0;
+    uint32_t sc = 0;
+    if (end - ptr < (ptrdiff_t)sizeof(uint32_t)) return NULL;
+    memcpy(&sc, ptr, sizeof(uint32_t)); ptr += sizeof(uint32_t);
+    if (sc > MAX_STROKES_PER_NOTE) return NULL;
+
+    size_t head = sizeof(uint32_t) + sizeof(uint16_t) + (version == 2 ? 3 : 0);
+    for (uint32_t s = 0; s < sc; s++) {
+        note_stroke_t * st = &note->strokes[s];
+        if (end - ptr < (ptrdiff_t)head) goto fail;
+
+        uint32_t pc = 0;
+        memcpy(&pc, ptr, sizeof(uint32_t)); ptr += sizeof(uint32_t);
+        uint16_t w = 0;
+        memcpy(&w, ptr, sizeof(uint16_t)); ptr += sizeof(uint16_t);
+        if (version == 2) {
+            st->color = lv_color_make(ptr[0], ptr[1], ptr[2]);
+            ptr += 3;
+        } else {
+            st->color = lv_color_black();
+        }
+        st->width = w;
+        st->edit_line_obj = NULL;
+
+        // Checked before multiplying, which could wrap a 32-bit size_t
+        if (pc > (size_t)(end - ptr) / sizeof(lv_point_precise_t)) goto fail;
+        size_t points_size = pc * sizeof(lv_point_precise_t);
+        st->points = heap_caps_malloc(points_size ? points_size : sizeof(lv_point_precise_t), MALLOC_CAP_SPIRAM);
+        if (!st->points) goto fail;
+        memcpy(st->points, ptr, points_size); ptr += points_size;
+        st->point_cnt = pc;
+        st->point_cap = pc;
+        note->stroke_cnt = s + 1;
+    }
+    return ptr;
+
+fail:
+    notes_codec_free(note);
+    return NULL;
+}
+
+const uint8_t * notes_codec_read(note_data_t *note, uint32_t version, const uint8_t *ptr, const uint8_t *end)
+{
+    note->stroke_cnt = 0;
+    if (version == 1 || version == 2) return strokes_read_raw(note, version, ptr, end);
+    if (version != 3) return NULL;
+
+    uint64_t sc = 0;
+    ptr = notes_get_varint(ptr, end, &sc);
+    if (!ptr || sc > MAX_STROKES_PER_NOTE) return NULL;
+
+    for (uint32_t s = 0; s < sc; s++) {
+        note_stroke_t * st = &note->strokes[s];
+        uint64_t pc = 0;
+        ptr = notes_get_varint(ptr, end, &pc);
+        // Every point takes at least a byte, which bounds pc before
+        // anything is allocated for it
+        if (!ptr || end - ptr < 3 || pc > (uint64_t)(end - ptr - 3)) goto fail;
+
+        st->width = ptr[0];
+        uint16_t c565 = (uint16_t)(ptr[1] | (ptr[2] << 8));
+        uint8_t r = (c565 >> 11) & 0x1f, g = (c565 >> 5) & 0x3f, b = c565 & 0x1f;
+        st->color = lv_color_make((r << 3) | (r >> 2), (g << 2) | (g >> 4), (b << 3) | (b >> 2));
+        st->edit_line_obj = NULL;
+        ptr += 3;
+
+        st->points = heap_caps_malloc((pc ? pc : 1) * sizeof(lv_point_precise_t), MALLOC_CAP_SPIRAM);
+        if (!st->points) goto fail;
+        st->point_cnt = 0;
+        st->point_cap = pc;
+        note->stroke_cnt = s + 1;
+
+        int32_t x = 0, y = 0;
+        for (uint32_t k = 0; k < pc; k++) {
+            uint64_t d;
+            ptr = notes_get_varint(ptr, end, &d);
+            if (!ptr) goto fail;
+            x = (int32_t)((uint32_t)x + (uint32_t)unzigzag(bits_gather(d)));
+            y = (int32_t)((uint32_t)y + (uint32_t)unzigzag(bits_gather(d >> 1)));
+            st->points[k].x = x;
+            st->points[k].y = y;
+        }
+        st->point_cnt = pc;
+    }
+    return ptr;
+
+fail:
+    notes_codec_free(note);
+    return NULL;
+}
@@ -0,0 +1,31 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include "notes_store.h"
+
+// Stroke layout of the per-note records. Records in older formats are
+// rewritten in this one when they are first read.
+#define NOTE_FORMAT_VERSION 3
+
+// Little-endian base-128 integers, shared with the thumbnail runs
+#define NOTES_VARINT_MAX_BYTES 10
+
+uint8_t * notes_put_varint(uint8_t *ptr, uint64_t v);
+
+// NULL if the varint runs past end or is too long
+const uint8_t * notes_get_varint(const uint8_t *ptr, const uint8_t *end, uint64_t *v);
+
+// Largest format 3 size of a note's strokes; the exact size is known after
+// writing
+size_t notes_codec_max_bytes(const note_data_t *note);
+
+// Writes the strokes in format 3 and returns the byte after them
+uint8_t * notes_codec_write(const note_data_t *note, uint8_t *ptr);
+
+// Reads strokes in format 1, 2 or 3 from ptr, never past end. Returns the
+// byte after them, or NULL if the data is damaged, in which case the note
+// is left with no strokes.
+const uint8_t * notes_codec_read(note_data_t *note, uint32_t version, const uint8_t *ptr, const uint8_t *end);
+
+void notes_codec_free(note_data_t *note);
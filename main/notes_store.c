@@ -0,0 +1,310 @@
+#include "notes_store.h"
+#include "notes_codec.h"
+#include "esp_heap_caps.h"
+#include <stdio.h>
+#include <string.h>
+#include "nvs_flash.h"
+#include "nvs.h"
+
+#define NOTES_PARTITION "notes"
+#define NOTES_NAMESPACE "notes_storage"
+#define NOTES_INDEX_KEY "index"
+#define NOTES_LEGACY_KEY "notes_blob"   // all notes in one blob, formats 1 and 2
+
+#define NOTES_INDEX_VERSION 1
+
+typedef struct {
+    uint32_t version;
+    uint32_t in_use;            // one bit per note
+    uint32_t bytes[MAX_NOTES];  // record sizes, for the storage total
+} notes_index_t;
+
+static notes_index_t notes_index;
+static const char * part_name = NOTES_PARTITION;
+static bool store_ok = false;
+
+static void note_key(int idx, char *key)
+{
+    snprintf(key, 8, "note%d", idx);
+}
+
+static void thumb_key(int idx, char *key)
+{
+    snprintf(key, 8, "thumb%d", idx);
+}
+
+static esp_err_t store_open(nvs_open_mode_t mode, nvs_handle_t *h)
+{
+    return nvs_open_from_partition(part_name, NOTES_NAMESPACE, mode, h);
+}
+
+// ---------------------------------------------------------------------
+// Index and records
+// ---------------------------------------------------------------------
+static bool write_index(nvs_handle_t h)
+{
+    return nvs_set_blob(h, NOTES_INDEX_KEY, &notes_index, sizeof(notes_index)) == ESP_OK;
+}
+
+static bool write_note(nvs_handle_t h, int idx, const note_data_t *note)
+{
+    uint8_t * rec = heap_caps_malloc(sizeof(uint32_t) + notes_codec_max_bytes(note), MALLOC_CAP_SPIRAM);
+    if (!rec) return false;
+
+    uint32_t version = NOTE_FORMAT_VERSION;
+    memcpy(rec, &version, sizeof(uint32_t));
+    size_t bytes = notes_codec_write(note, rec + sizeof(uint32_t)) - rec;
+
+    char key[8];
+    note_key(idx, key);
+    bool ok = nvs_set_blob(h, key, rec, bytes) == ESP_OK;
+    heap_caps_free(rec);
+    if (!ok) return false;
+
+    notes_index.in_use |= 1u << idx;
+    notes_index.bytes[idx] = bytes;
+    return true;
+}
+
+// Splits the old all-notes blob into per-note records, then drops it.
+// The notes it held stay loaded in db.
+static void migrate_legacy(nvs_handle_t h, note_data_t *db)
+{
+    nvs_handle_t old;
+    if (nvs_open(NOTES_NAMESPACE, NVS_READWRITE, &old) != ESP_OK) return;
+
+    size_t len = 0;
+    if (nvs_get_blob(old, NOTES_LEGACY_KEY, NULL, &len) != ESP_OK || len < sizeof(uint32_t)) {
+        nvs_close(old);
+        return;
+    }
+    uint8_t * blob = heap_caps_malloc(len, MALLOC_CAP_SPIRAM);
+    if (!blob || nvs_get_blob(old, NOTES_LEGACY_KEY, blob, &len) != ESP_OK) {
+        heap_caps_free(blob);
+        nvs_close(old);
+        return;
+    }
+
+    const uint8_t * ptr = blob;
+    const uint8_t * end = blob + len;
+    uint32_t version = 0;
+    memcpy(&version, ptr, sizeof(uint32_t)); ptr += sizeof(uint32_t);
+
+    bool ok = version == 1 || version == 2;
+    int moved = 0;
+    for (int i = 0; ok && i < MAX_NOTES; i++) {
+        if (ptr >= end) { ok = false; break; }
+        bool in_use = *ptr++ != 0;
+        if (!in_use) continue;
+
+        ptr = notes_codec_read(&db[i], version, ptr, end);
+        if (!ptr) { ok = false; break; }
+        db[i].in_use = true;
+        db[i].loaded = true;
+        ok = write_note(h, i, &db[i]);
+        moved++;
+    }
+
+    // The old blob goes only once every note is safely in its own record
+    if (ok && write_index(h) && nvs_commit(h) == ESP_OK) {
+        nvs_erase_key(old, NOTES_LEGACY_KEY);
+        nvs_commit(old);
+        printf("Notes: Moved %d notes to per-note records\n", moved);
+    } else {
+        printf("Notes: Could not move the old notes blob, keeping it\n");
+    }
+    heap_caps_free(blob);
+    nvs_close(old);
+}
+
+bool notes_store_init(note_data_t *db)
+{
+    // Boards flashed with the old partition table have no "notes"
+    // partition; the records then go to the default one
+    esp_err_t err = nvs_flash_init_partition(NOTES_PARTITION);
+    if (err == ESP_ERR_NVS_NO_FREE_PAGES || err == ESP_ERR_NVS_NEW_VERSION_FOUND) {
+        nvs_flash_erase_partition(NOTES_PARTITION);
+        err = nvs_flash_init_partition(NOTES_PARTITION);
+    }
+    if (err != ESP_OK) {
+        printf("Notes: No \"notes\" partition, using the default NVS\n");
+        part_name = NVS_DEFAULT_PART_NAME;
+    }
+
+    nvs_handle_t h;
+    if (store_open(NVS_READWRITE, &h) != ESP_OK) return false;
+    store_ok = true;
+
+    size_t len = sizeof(notes_index);
+    if (nvs_get_blob(h, NOTES_INDEX_KEY, &notes_index, &len) != ESP_OK ||
+        len != sizeof(notes_index) || notes_index.version != NOTES_INDEX_VERSION) {
+        memset(&notes_index, 0, sizeof(notes_index));
+        notes_index.version = NOTES_INDEX_VERSION;
+        migrate_legacy(h, db);
+    }
+    nvs_close(h);
+
+    for (int i = 0; i < MAX_NOTES; i++) {
+        if (notes_index.in_use & (1u << i)) db[i].in_use = true;
+    }
+    return true;
+}
+
+bool notes_store_load(int idx, note_data_t *note)
+{
+    note->stroke_cnt = 0;
+    if (!store_ok) return false;
+    if (!(notes_index.in_use & (1u << idx))) {
+        note->loaded = true;
+        return true;
+    }
+
+    nvs_handle_t h;
+    if (store_open(NVS_READONLY, &h) != ESP_OK) return false;
+
+    char key[8];
+    note_key(idx, key);
+    size_t len = 0;
+    uint8_t * rec = NULL;
+    bool ok = nvs_get_blob(h, key, NULL, &len) == ESP_OK && len >= sizeof(uint32_t) &&
+              (rec = heap_caps_malloc(len, MALLOC_CAP_SPIRAM)) != NULL &&
+              nvs_get_blob(h, key, rec, &len) == ESP_OK;
+    nvs_close(h);
+
+    uint32_t version = 0;
+    if (ok) {
+        memcpy(&version, rec, sizeof(uint32_t));
+        ok = notes_codec_read(note, version, rec + sizeof(uint32_t), rec + len) != NULL;
+    }
+    heap_caps_free(rec);
+    if (!ok) {
+        printf("Notes: Could not read note %d\n", idx);
+        return false;
+    }
+    note->loaded = true;
+
+    if (version != NOTE_FORMAT_VERSION) notes_store_save(idx, note);
+    return true;
+}
+
+bool notes_store_save(int idx, const note_data_t *note)
+{
+    // A note whose strokes could not be read would overwrite its record
+    // with nothing
+    if (!store_ok || idx < 0 || idx >= MAX_NOTES || !note->loaded) return false;
+
+    nvs_handle_t h;
+    if (store_open(NVS_READWRITE, &h) != ESP_OK) return false;
+
+    // A thumbnail left over from before this save would show stale ink;
+    // without one the menu draws it again from the strokes
+    char key[8];
+    thumb_key(idx, key);
+    nvs_erase_key(h, key);
+
+    bool ok = write_note(h, idx, note) && write_index(h) && nvs_commit(h) == ESP_OK;
+    nvs_close(h);
+    if (!ok) printf("Notes: Could not save note %d\n", idx);
+    return ok;
+}
+
+bool notes_store_delete(int idx)
+{
+    if (!store_ok || idx < 0 || idx >= MAX_NOTES) return false;
+
+    nvs_handle_t h;
+    if (store_open(NVS_READWRITE, &h) != ESP_OK) return false;
+
+    // Index first, so a note whose record is gone is never listed
+    notes_index.in_use &= ~(1u << idx);
+    notes_index.bytes[idx] = 0;
+    bool ok = write_index(h);
+    char key[8];
+    note_key(idx, key);
+    nvs_erase_key(h, key);
+    thumb_key(idx, key);
+    nvs_erase_key(h, key);
+    ok = nvs_commit(h) == ESP_OK && ok;
+    nvs_close(h);
+    return ok;
+}
+
+// ---------------------------------------------------------------------
+// Thumbnails: runs of a varint length and an RGB565 pixel
+// ---------------------------------------------------------------------
+// Codes px into out, or only measures it if out is NULL; returns the bytes
+static size_t thumb_rle(const uint16_t *px, uint32_t count, uint8_t *out)
+{
+    uint8_t tmp[NOTES_VARINT_MAX_BYTES];
+    size_t bytes = 0;
+    uint32_t i = 0;
+    while (i < count) {
+        uint32_t run = 1;
+        while (i + run < count && px[i + run] == px[i]) run++;
+        uint8_t * ptr = out ? out + bytes : tmp;
+        size_t vlen = notes_put_varint(ptr, run) - ptr;
+        if (out) {
+            ptr[vlen] = (uint8_t)px[i];
+            ptr[vlen + 1] = (uint8_t)(px[i] >> 8);
+        }
+        bytes += vlen + 2;
+        i += run;
+    }
+    return bytes;
+}
+
+bool notes_store_save_thumb(int idx, const uint16_t *px, uint32_t count)
+{
+    if (!store_ok || idx < 0 || idx >= MAX_NOTES || count == 0) return false;
+
+    size_t bytes = thumb_rle(px, count, NULL);
+    uint8_t * rec = heap_caps_malloc(bytes, MALLOC_CAP_SPIRAM);
+    if (!rec) return false;
+    thumb_rle(px, count, rec);
+
+    nvs_handle_t h;
+    bool ok = store_open(NVS_READWRITE, &h) == ESP_OK;
+    if (ok) {
+        char key[8];
+        thumb_key(idx, key);
+        ok = nvs_set_blob(h, key, rec, bytes) == ESP_OK && nvs_commit(h) == ESP_OK;
+        nvs_close(h);
+    }
+    heap_caps_free(rec);
+    return ok;
+}
+
+bool notes_store_load_thumb(int idx, uint16_t *px, uint32_t count)
+{
+    if (!store_ok || idx < 0 || idx >= MAX_NOTES) return false;
+
+    nvs_handle_t h;
+    if (store_open(NVS_READONLY, &h) != ESP_OK) return false;
+
+    char key[8];
+    thumb_key(idx, key);
+    size_t len = 0;
+    uint8_t * rec = NULL;
+    bool ok = nvs_get_blob(h, key, NULL, &len) == ESP_OK &&
+              (rec = heap_caps_malloc(len, MALLOC_CAP_SPIRAM)) != NULL &&
+              nvs_get_blob(h, key, rec, &len) == ESP_OK;
+    nvs_close(h);
+
+    // The runs must cover the image exactly
+    uint32_t i = 0;
+    const uint8_t * ptr = rec;
+    const uint8_t * end = rec + len;
+    while (ok && ptr < end) {
+        uint64_t run = 0;
+        ptr = notes_get_varint(ptr, end, &run);
+        if (!ptr || end - ptr < 2 || run == 0 || run > count - i) {
+            ok = false;
+            break;
+        }
+        uint16_t c = (uint16_t)(ptr[0] | (ptr[1] << 8));
+        ptr += 2;
+        for (uint32_t k = 0; k < run; k++) px[i++] = c;
+    }
+    heap_caps_free(rec);
+    return ok && i == count;
+}
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "lvgl.h"
+
+#define MAX_NOTES 10
+#define MAX_STROKES_PER_NOTE 100
+
+typedef struct {
+    lv_point_precise_t * points;
+    uint32_t point_cnt;
+    uint32_t point_cap;
+    lv_color_t color;
+    uint16_t width;
+    lv_obj_t * edit_line_obj;
+} note_stroke_t;
+
+typedef struct {
+    bool in_use;
+    bool loaded;            // strokes have been read from flash
+    note_stroke_t strokes[MAX_STROKES_PER_NOTE];
+    uint32_t stroke_cnt;
+} note_data_t;
+
+// Notes are kept as one NVS record per note plus a small index, in the
+// "notes" NVS partition. Saving or deleting a note rewrites only that
+// note's record and the index.
+
+// Opens the store, moving notes out of the old single-blob format if one
+// is found. Only the index is read: db gets the notes in use, and their
+// strokes are read by notes_store_load when first needed.
+bool notes_store_init(note_data_t *db);
+
+// Reads a note's strokes and sets loaded. On failure the note is left
+// without strokes and not loaded, so it must not be saved over its record.
+bool notes_store_load(int idx, note_data_t *note);
+bool notes_store_save(int idx, const note_data_t *note);
+bool notes_store_delete(int idx);
+
+// Thumbnails are kept next to the notes as run-length coded RGB565, so the
+// notes menu can be drawn without reading any strokes. Saving a note drops
+// its old thumbnail; deleting it drops both.
+bool notes_store_load_thumb(int idx, uint16_t *px, uint32_t count);
+bool notes_store_save_thumb(int idx, const uint16_t *px, uint32_t count);
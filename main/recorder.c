@@ -0,0 +1,214 @@
+#include "recorder.h"
+#include "task_topology.h"
+#include <stdio.h>
+#include <string.h>
+#include <sys/stat.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/queue.h"
+#include "esp_heap_caps.h"
+
+typedef enum {
+    REC_MSG_OPEN = 0,
+    REC_MSG_DATA,
+    REC_MSG_CLOSE
+} rec_msg_type_t;
+
+typedef struct {
+    uint8_t type;      // rec_msg_type_t
+    uint8_t buf;       // buffer index for REC_MSG_DATA
+    uint32_t samples;
+} rec_msg_t;
+
+static char rec_dir[16];
+static int rec_sample_rate = 16000;
+static QueueHandle_t rec_queue = NULL;
+
+static int16_t * bufs[2] = { NULL, NULL };
+// Set by the capture side when a buffer is handed over, cleared by the
+// writer once it is on the card
+static volatile bool buf_busy[2] = { false, false };
+
+// Capture side state
+static int cur_buf = 0;
+static int cur_fill = 0;
+static bool taking = false;
+
+static volatile recorder_stats_t stats;
+
+static void wav_header(uint8_t *h, int sample_rate, uint32_t data_bytes)
+{
+    uint32_t byte_rate = (uint32_t)sample_rate * 2;
+    uint32_t riff_size = 36 + data_bytes;
+    memcpy(h, "RIFF", 4);
+    memcpy(h + 4, &riff_size, 4);
+    memcpy(h + 8, "WAVEfmt ", 8);
+    const uint32_t fmt_size = 16;
+    const uint16_t pcm = 1, channels = 1, align = 2, bits = 16;
+    memcpy(h + 16, &fmt_size, 4);
+    memcpy(h + 20, &pcm, 2);
+    memcpy(h + 22, &channels, 2);
+    uint32_t sr = (uint32_t)sample_rate;
+    memcpy(h + 24, &sr, 4);
+    memcpy(h + 28, &byte_rate, 4);
+    memcpy(h + 32, &align, 2);
+    memcpy(h + 34, &bits, 2);
+    memcpy(h + 36, "data", 4);
+    memcpy(h + 40, &data_bytes, 4);
+}
+
+// First unused RECnnnnn.WAV name (8.3, long file names are off)
+static void next_path(char *out, size_t len)
+{
+    struct stat st;
+    for (int i = 1; i < 100000; i++) {
+        snprintf(out, len, "%s/REC%05d.WAV", rec_dir, i);
+        if (stat(out, &st) != 0) return;
+    }
+}
+
+static void writer_task(void *arg)
+{
+    FILE * f = NULL;
+    uint32_t data_bytes = 0;
+    uint8_t header[44];
+    rec_msg_t msg;
+
+    while (1) {
+        if (xQueueReceive(rec_queue, &msg, portMAX_DELAY) != pdTRUE) continue;
+
+        switch (msg.type) {
+            case REC_MSG_OPEN:
+                if (f) fclose(f);
+                data_bytes = 0;
+                next_path((char *)stats.path, sizeof(stats.path));
+                f = fopen((const char *)stats.path, "wb");
+                if (!f) {
+                    printf("Recorder: Failed to open %s\n", stats.path);
+                    stats.write_errors++;
+                    break;
+                }
+                // Sizes are patched in on close
+                wav_header(header, rec_sample_rate, 0);
+                fwrite(header, 1, sizeof(header), f);
+                break;
+
+            case REC_MSG_DATA:
+                if (f) {
+                    size_t bytes = msg.samples * sizeof(int16_t);
+                    if (fwrite(bufs[msg.buf], 1, bytes, f) == bytes) {
+                        data_bytes += bytes;
+                        stats.blocks_written++;
+                    } else {
+                        stats.write_errors++;
+                    }
+                }
+                buf_busy[msg.buf] = false;
+                break;
+
+            case REC_MSG_CLOSE:
+                if (f) {
+                    wav_header(header, rec_sample_rate, data_bytes);
+                    fseek(f, 0, SEEK_SET);
+                    fwrite(header, 1, sizeof(header), f);
+                    fclose(f);
+                    f = NULL;
+                    printf("Recorder: Wrote %lu bytes to %s\n", (unsigned long)data_bytes, stats.path);
+                }
+                stats.active = false;
+                break;
+        }
+    }
+}
+
+bool recorder_init(const char *dir, int sample_rate)
+{
+    if (rec_queue) return true;
+
+    strncpy(rec_dir, dir, sizeof(rec_dir) - 1);
+    rec_sample_rate = sample_rate;
+
+    for (int i = 0; i < 2; i++) {
+        bufs[i] = heap_caps_malloc(RECORDER_BUF_SAMPLES * sizeof(int16_t), MALLOC_CAP_SPIRAM);
+        if (!bufs[i]) {
+            printf("Recorder: Failed to allocate buffers\n");
+            return false;
+        }
+    }
+
+    // Two data buffers plus open and close can be in flight at once
+    rec_queue = xQueueCreate(8, sizeof(rec_msg_t));
+    if (!rec_queue) return false;
+
+    return task_topology_start(TASK_REC_WRITER, writer_task, NULL);
+}
+
+static void hand_over(int samples)
+{
+    rec_msg_t msg = { .type = REC_MSG_DATA, .buf = (uint8_t)cur_buf, .samples = (uint32_t)samples };
+    buf_busy[cur_buf] = true;
+    xQueueSend(rec_queue, &msg, 0);
+    cur_buf ^= 1;
+    cur_fill = 0;
+}
+
+bool recorder_start(void)
+{
+    // The writer clears active once the previous take is finalized
+    if (!rec_queue || taking || stats.active) return false;
+
+    memset((void *)&stats, 0, sizeof(stats));
+    stats.active = true;
+    cur_fill = 0;
+    rec_msg_t msg = { .type = REC_MSG_OPEN };
+    if (xQueueSend(rec_queue, &msg, 0) != pdTRUE) {
+        stats.active = false;
+        return false;
+    }
+    taking = true;
+    return true;
+}
+
+void recorder_write(const int16_t *samples, int n)
+{
+    if (!taking) return;
+
+    // Both buffers still queued for the card: drop the whole block rather
+    // than wait, the capture side must never block on storage
+    if (buf_busy[cur_buf]) {
+        stats.dropped++;
+        return;
+    }
+
+    while (n > 0) {
+        int chunk = RECORDER_BUF_SAMPLES - cur_fill;
+        if (chunk > n) chunk = n;
+        memcpy(&bufs[cur_buf][cur_fill], samples, chunk * sizeof(int16_t));
+        cur_fill += chunk;
+        samples += chunk;
+        n -= chunk;
+        stats.samples += chunk;
+
+        if (cur_fill == RECORDER_BUF_SAMPLES) {
+            hand_over(cur_fill);
+            if (n > 0 && buf_busy[cur_buf]) {
+                stats.dropped++;
+                return;
+            }
+        }
+    }
+}
+
+void recorder_stop(void)
+{
+    if (!taking) return;
+    taking = false;
+
+    if (cur_fill > 0) hand_over(cur_fill);
+    rec_msg_t msg = { .type = REC_MSG_CLOSE };
+    xQueueSend(rec_queue, &msg, portMAX_DELAY);
+}
+
+void recorder_get_stats(recorder_stats_t *out)
+{
+    memcpy(out, (const void *)&stats, sizeof(*out));
+}
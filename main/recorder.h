@@ -0,0 +1,30 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// Streams 16-bit mono audio to a WAV file on a FAT volume. The capture side
+// fills one of two PSRAM buffers while a writer task flushes the other, so
+// a take is bounded by free space on the card rather than by RAM.
+#define RECORDER_BUF_SAMPLES 16384   // per ping-pong buffer, ~1 s at 16 kHz
+
+typedef struct {
+    bool active;
+    char path[32];
+    uint64_t samples;           // accepted by the capture side
+    uint32_t blocks_written;    // buffers flushed to the file
+    uint32_t dropped;           // capture blocks lost because both buffers were full
+    uint32_t write_errors;
+} recorder_stats_t;
+
+// Allocates the buffers and starts the writer task. dir is the FAT mount
+// point, e.g. BSP_SD_MOUNT_POINT.
+bool recorder_init(const char *dir, int sample_rate);
+
+// Capture task side. start/stop bracket a take; the file is opened and
+// finalized on the writer task, so none of these block on the card.
+bool recorder_start(void);
+void recorder_write(const int16_t *samples, int n);
+void recorder_stop(void);
+
+void recorder_get_stats(recorder_stats_t *out);
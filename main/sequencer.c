@@ -0,0 +1,192 @@
+#include "sequencer.h"
+#include <math.h>
+#include <stdatomic.h>
+
+// Step positions are absolute sample counts in 48.16 fixed point, so step
+// lengths at any tempo accumulate without drift. A note starts on the first
+// whole sample at or after its position.
+#define SEQ_FRAC_BITS 16
+#define SEQ_GATE      0.5f  // share of the step a note is held for
+
+_Static_assert(SEQ_NOTE_BASE >= SEQ_MAX_NOTES && SEQ_NOTE_BASE + SEQ_MAX_NOTES <= SYNTH_MAX_NOTES,
+               "sequencer notes must not overlap the keys and must fit the synth");
+
+// Written by the UI, read by the audio thread
+static volatile int mode = SEQ_MODE_OFF;
+static volatile float bpm = 120.0f;
+static volatile int8_t steps[SEQ_STEPS] = {
+    0, SEQ_REST, 4, SEQ_REST, 7, SEQ_REST, 12, SEQ_REST,
+    7, SEQ_REST, 4, SEQ_REST, 0, SEQ_REST, 7, SEQ_REST,
+};
+static atomic_uint held = 0;
+
+// Written by the audio thread, read by the UI
+static volatile int current_step = -1;
+
+// Audio thread state
+static float seq_sample_rate = 16000.0f;
+static int64_t sample_clock = 0;    // first sample of the next block
+static int64_t next_step_fp = 0;
+static int64_t gate_off_fp = 0;
+static int step_idx = 0;
+static int arp_pos = 0;
+static int sounding_note = SEQ_REST;
+static int active_mode = SEQ_MODE_OFF;
+
+void sequencer_init(float sample_rate)
+{
+    seq_sample_rate = sample_rate;
+    sample_clock = 0;
+    sounding_note = SEQ_REST;
+    active_mode = SEQ_MODE_OFF;
+    current_step = -1;
+}
+
+void sequencer_set_mode(seq_mode_t m)
+{
+    mode = m;
+}
+
+seq_mode_t sequencer_get_mode(void)
+{
+    return (seq_mode_t)mode;
+}
+
+void sequencer_set_bpm(float b)
+{
+    if (b < 20.0f) b = 20.0f;
+    if (b > 300.0f) b = 300.0f;
+    bpm = b;
+}
+
+void sequencer_set_step(int step, int note_idx)
+{
+    if (step < 0 || step >= SEQ_STEPS) return;
+    if (note_idx < 0 || note_idx >= SEQ_MAX_NOTES) note_idx = SEQ_REST;
+    steps[step] = (int8_t)note_idx;
+}
+
+int sequencer_get_step(int step)
+{
+    if (step < 0 || step >= SEQ_STEPS) return SEQ_REST;
+    return steps[step];
+}
+
+void sequencer_hold(int note_idx, bool down)
+{
+    if (note_idx < 0 || note_idx >= SEQ_MAX_NOTES) return;
+    if (down) atomic_fetch_or(&held, 1u << note_idx);
+    else atomic_fetch_and(&held, ~(1u << note_idx));
+}
+
+int sequencer_current_step(void)
+{
+    return current_step;
+}
+
+float sequencer_note_freq(int note_idx)
+{
+    return 261.63f * powf(2.0f, (float)note_idx / 12.0f);
+}
+
+// Next note of the arpeggio, or SEQ_REST when no keys are held
+static int arp_next(int m)
+{
+    unsigned mask = atomic_load(&held);
+    int notes[SEQ_MAX_NOTES];
+    int count = 0;
+    for (int i = 0; i < SEQ_MAX_NOTES; i++) {
+        if (mask & (1u << i)) notes[count++] = i;
+    }
+    if (count == 0) return SEQ_REST;
+
+    int idx;
+    if (m == SEQ_MODE_ARP_UP) {
+        idx = arp_pos % count;
+    } else if (m == SEQ_MODE_ARP_DOWN) {
+        idx = count - 1 - arp_pos % count;
+    } else {
+        // Ping-pong without repeating the end notes
+        int period = count > 1 ? 2 * count - 2 : 1;
+        idx = arp_pos % period;
+        if (idx >= count) idx = period - idx;
+    }
+    arp_pos++;
+    return notes[idx];
+}
+
+static int64_t step_len_fp(void)
+{
+    // Once per step, so the double maths is cheap; float would lose the
+    // fraction bits at long step lengths
+    double samples = (double)seq_sample_rate * 60.0 / ((double)bpm * 4.0);
+    return (int64_t)(samples * (double)(1 << SEQ_FRAC_BITS));
+}
+
+static int64_t to_sample(int64_t pos_fp)
+{
+    return (pos_fp + (1 << SEQ_FRAC_BITS) - 1) >> SEQ_FRAC_BITS;
+}
+
+static int emit(synth_timed_event_t *out, int count, int max_events,
+                int64_t sample, uint8_t type, int note)
+{
+    if (count >= max_events) return count;
+    synth_timed_event_t * te = &out[count];
+    te->offset = (int)(sample - sample_clock);
+    te->ev.time_us = 0;
+    te->ev.type = type;
+    te->ev.param = 0;
+    te->ev.note_idx = (int16_t)(SEQ_NOTE_BASE + note);
+    te->ev.value = type == SYNTH_EV_NOTE_ON ? sequencer_note_freq(note) : 0.0f;
+    return count + 1;
+}
+
+int sequencer_render(synth_timed_event_t *out, int max_events, int n)
+{
+    int count = 0;
+    int m = mode;
+    int64_t block_end = sample_clock + n;
+
+    if (m != active_mode) {
+        // Stopping or switching modes releases the current note right away;
+        // starting puts the first step at the beginning of this block
+        if (sounding_note != SEQ_REST) {
+            count = emit(out, count, max_events, sample_clock, SYNTH_EV_NOTE_OFF, sounding_note);
+            sounding_note = SEQ_REST;
+        }
+        if (active_mode == SEQ_MODE_OFF) {
+            next_step_fp = sample_clock << SEQ_FRAC_BITS;
+            step_idx = 0;
+            arp_pos = 0;
+        }
+        active_mode = m;
+        if (m == SEQ_MODE_OFF) current_step = -1;
+    }
+
+    while (m != SEQ_MODE_OFF) {
+        bool gate_due = sounding_note != SEQ_REST && gate_off_fp <= next_step_fp;
+        int64_t at = gate_due ? gate_off_fp : next_step_fp;
+        if (to_sample(at) >= block_end) break;
+
+        if (gate_due) {
+            count = emit(out, count, max_events, to_sample(at), SYNTH_EV_NOTE_OFF, sounding_note);
+            sounding_note = SEQ_REST;
+            continue;
+        }
+
+        int64_t len = step_len_fp();
+        int note = m == SEQ_MODE_PATTERN ? steps[step_idx] : arp_next(m);
+        if (note != SEQ_REST) {
+            count = emit(out, count, max_events, to_sample(at), SYNTH_EV_NOTE_ON, note);
+            sounding_note = note;
+            gate_off_fp = at + (int64_t)((float)len * SEQ_GATE);
+        }
+        current_step = step_idx;
+        step_idx = (step_idx + 1) % SEQ_STEPS;
+        next_step_fp = at + len;
+    }
+
+    sample_clock = block_end;
+    return count;
+}
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <stdbool.h>
+#include "synth.h"
+
+// 16th-note steps, one bar per pattern
+#define SEQ_STEPS       16
+#define SEQ_REST        -1
+#define SEQ_MAX_NOTES   32  // note indices the arpeggiator can hold
+// The sequencer plays note n as synth note SEQ_NOTE_BASE + n, so its notes
+// never release or retrigger a key the user is holding
+#define SEQ_NOTE_BASE   64
+
+typedef enum {
+    SEQ_MODE_OFF = 0,
+    SEQ_MODE_PATTERN,     // plays the step table
+    SEQ_MODE_ARP_UP,      // cycles through held notes, lowest first
+    SEQ_MODE_ARP_DOWN,
+    SEQ_MODE_ARP_UPDOWN
+} seq_mode_t;
+
+void sequencer_init(float sample_rate);
+
+// UI side. Single-word writes picked up by the audio thread at the next step.
+void sequencer_set_mode(seq_mode_t mode);
+seq_mode_t sequencer_get_mode(void);
+void sequencer_set_bpm(float bpm);
+void sequencer_set_step(int step, int note_idx);   // SEQ_REST clears it
+int sequencer_get_step(int step);
+// Arpeggiator key state; keys are routed here instead of the synth while
+// an arp mode is active
+void sequencer_hold(int note_idx, bool down);
+// Step that sounded last, or -1 when stopped
+int sequencer_current_step(void);
+
+// Frequency of a note index, 0 = C4
+float sequencer_note_freq(int note_idx);
+
+// Audio thread only. Advances the sample clock by n samples and writes the
+// note events falling inside that block, sorted by offset, to out. Returns
+// the number of events written.
+int sequencer_render(synth_timed_event_t *out, int max_events, int n);
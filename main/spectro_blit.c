@@ -0,0 +1,98 @@
+#include "spectro_blit.h"
+
+static uint16_t lut[256];
+static spectro_palette_t current = SPECTRO_PALETTE_COUNT;
+
+static uint16_t rgb565(uint8_t r, uint8_t g, uint8_t b)
+{
+    return (uint16_t)(((r >> 3) << 11) | ((g >> 2) << 5) | (b >> 3));
+}
+
+// Black - blue - magenta - red - yellow - white in four equal segments
+static uint16_t heatmap(float t)
+{
+    uint8_t r = 0, g = 0, b = 0;
+    if (t < 0.25f) {
+        b = (uint8_t)(t / 0.25f * 255.0f);
+    } else if (t < 0.5f) {
+        float u = (t - 0.25f) / 0.25f;
+        r = (uint8_t)(u * 255.0f);
+        b = (uint8_t)((1.0f - u) * 255.0f);
+    } else if (t < 0.75f) {
+        r = 255;
+        g = (uint8_t)((t - 0.5f) / 0.25f * 255.0f);
+    } else {
+        r = 255;
+        g = 255;
+        b = (uint8_t)((t - 0.75f) / 0.25f * 255.0f);
+    }
+    return rgb565(r, g, b);
+}
+
+// matplotlib viridis sampled at ten evenly spaced points
+static const uint8_t viridis_stops[10][3] = {
+    {0x44, 0x01, 0x54}, {0x48, 0x28, 0x78}, {0x3e, 0x49, 0x89}, {0x31, 0x68, 0x8e},
+    {0x26, 0x82, 0x8e}, {0x1f, 0x9e, 0x89}, {0x35, 0xb7, 0x79}, {0x6e, 0xce, 0x58},
+    {0xb5, 0xde, 0x2b}, {0xfd, 0xe7, 0x25},
+};
+
+static uint16_t viridis(float t)
+{
+    float pos = t * 9.0f;
+    int i = (int)pos;
+    if (i >= 9) i = 8;
+    float u = pos - (float)i;
+    uint8_t c[3];
+    for (int k = 0; k < 3; k++) {
+        float a = viridis_stops[i][k];
+        float b = viridis_stops[i + 1][k];
+        c[k] = (uint8_t)(a + (b - a) * u + 0.5f);
+    }
+    return rgb565(c[0], c[1], c[2]);
+}
+
+void spectro_set_palette(spectro_palette_t palette)
+{
+    if (palette >= SPECTRO_PALETTE_COUNT) palette = SPECTRO_PALETTE_HEATMAP;
+    if (palette == current) return;
+
+    for (int i = 0; i < 256; i++) {
+        float t = (float)i / 255.0f;
+        switch (palette) {
+            case SPECTRO_PALETTE_GRAYSCALE: lut[i] = rgb565(i, i, i); break;
+            case SPECTRO_PALETTE_VIRIDIS:   lut[i] = viridis(t); break;
+            default:                        lut[i] = heatmap(t); break;
+        }
+    }
+    current = palette;
+}
+
+spectro_palette_t spectro_get_palette(void)
+{
+    return current;
+}
+
+void spectro_blit_column(uint16_t *dst, int stride, int x, const uint8_t *levels, int h)
+{
+    if (current == SPECTRO_PALETTE_COUNT) spectro_set_palette(SPECTRO_PALETTE_HEATMAP);
+
+    uint16_t * p = dst + x;
+    for (int y = 0; y < h; y++) {
+        *p = lut[levels[y]];
+        p += stride;
+    }
+}
+
+void spectro_blit(uint16_t *dst, int stride, const uint8_t *levels, int w, int h)
+{
+    if (current == SPECTRO_PALETTE_COUNT) spectro_set_palette(SPECTRO_PALETTE_HEATMAP);
+
+    // Row-major walk so the destination is written sequentially
+    for (int y = 0; y < h; y++) {
+        uint16_t * row = dst + y * stride;
+        const uint8_t * src = levels + y;
+        for (int x = 0; x < w; x++) {
+            row[x] = lut[src[x * h]];
+        }
+    }
+}
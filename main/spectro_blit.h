@@ -0,0 +1,32 @@
+#pragma once
+
+#include <stdint.h>
+
+// Spectrogram render stage: intensities are quantized to 8-bit levels and
+// mapped through a 256-entry RGB565 palette straight into a canvas buffer.
+typedef enum {
+    SPECTRO_PALETTE_HEATMAP = 0,
+    SPECTRO_PALETTE_GRAYSCALE,
+    SPECTRO_PALETTE_VIRIDIS,
+    SPECTRO_PALETTE_COUNT
+} spectro_palette_t;
+
+// Rebuilds the lookup table; cheap enough to call from a UI callback
+void spectro_set_palette(spectro_palette_t palette);
+spectro_palette_t spectro_get_palette(void);
+
+// 0.0 to 1.0 mapped to a palette index, clamped
+static inline uint8_t spectro_quantize(float intensity)
+{
+    if (intensity <= 0.0f) return 0;
+    if (intensity >= 1.0f) return 255;
+    return (uint8_t)(intensity * 255.0f + 0.5f);
+}
+
+// Writes h pixels of column x, top to bottom, into an RGB565 buffer with
+// the given row stride in pixels
+void spectro_blit_column(uint16_t *dst, int stride, int x, const uint8_t *levels, int h);
+
+// Redraws a whole w x h image from a column-major level matrix, h levels
+// per column
+void spectro_blit(uint16_t *dst, int stride, const uint8_t *levels, int w, int h);
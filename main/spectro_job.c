@@ -0,0 +1,127 @@
+#include "spectro_job.h"
+#include "task_topology.h"
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/queue.h"
+
+// Let the idle task in every this many frames so the task watchdog stays fed
+#define SPECTRO_YIELD_FRAMES 64
+
+typedef struct {
+    uint32_t id;
+    spectro_job_t job;
+    const fft_plan_t * plan;
+    const freq_map_t * fmap;
+} job_msg_t;
+
+static QueueHandle_t job_queue = NULL;
+// Id of the job allowed to run; bumped by start and cancel
+static atomic_uint current_id;
+static uint32_t next_id = 0;
+// Progress of the job with done_id
+static atomic_uint done_id;
+static atomic_int done_frames;
+
+static bool still_current(uint32_t id)
+{
+    return atomic_load_explicit(&current_id, memory_order_relaxed) == id;
+}
+
+static void run_job(uint32_t id, const job_msg_t *msg)
+{
+    const spectro_job_t * job = &msg->job;
+    const stft_cache_t * cache = job->cache;
+    float * vReal = malloc(cache->fft_size * sizeof(float));
+    float * mags = malloc((cache->fft_size / 2) * sizeof(float));
+    float * rows = malloc(cache->rows * sizeof(float));
+    if (!vReal || !mags || !rows) {
+        printf("Spectrogram: Out of memory for a %d point job\n", cache->fft_size);
+        goto out;
+    }
+
+    for (int f = 0; f < cache->frames && still_current(id); f++) {
+        int start_idx = f * cache->hop;
+
+        // Fill FFT buffer; the plan applies its cached Hann window
+        for (int i = 0; i < cache->fft_size; i++) {
+            int s = start_idx + i;
+            vReal[i] = s < job->count ? (float)job->samples[s] : 0.0f;
+        }
+
+        stft_analyze_frame(msg->plan, msg->fmap, vReal, mags, rows, stft_cache_frame(cache, f));
+
+        // Publish the frame only after its codes are written
+        atomic_store_explicit(&done_frames, f + 1, memory_order_release);
+
+        if ((f + 1) % SPECTRO_YIELD_FRAMES == 0) vTaskDelay(1);
+    }
+
+out:
+    free(vReal);
+    free(mags);
+    free(rows);
+}
+
+static void spectro_task(void *arg)
+{
+    job_msg_t msg;
+    while (1) {
+        if (xQueueReceive(job_queue, &msg, portMAX_DELAY) != pdTRUE) continue;
+        if (!still_current(msg.id)) continue;
+
+        atomic_store_explicit(&done_frames, 0, memory_order_relaxed);
+        atomic_store_explicit(&done_id, msg.id, memory_order_release);
+        run_job(msg.id, &msg);
+    }
+}
+
+bool spectro_job_init(void)
+{
+    if (job_queue) return true;
+
+    // Only the newest job matters, so one slot that start overwrites
+    job_queue = xQueueCreate(1, sizeof(job_msg_t));
+    if (!job_queue) return false;
+
+    return task_topology_start(TASK_SPECTRO, spectro_task, NULL);
+}
+
+uint32_t spectro_job_start(const spectro_job_t *job)
+{
+    const stft_cache_t * cache = job->cache;
+    if (!job_queue || !cache || !cache->codes) return 0;
+
+    // The plan and map caches are not locked, so look them up here on the
+    // UI thread rather than on the worker
+    job_msg_t msg = {
+        .job = *job,
+        .plan = fft_plan_get(cache->fft_size),
+        .fmap = freq_map_get(cache->fft_size, cache->rows, cache->scale, cache->sample_rate),
+    };
+    if (!msg.plan || !msg.fmap) {
+        printf("Spectrogram: No tables for a %d point job\n", cache->fft_size);
+        return 0;
+    }
+
+    // UI thread only, so the counter needs no lock; 0 means "no job"
+    if (++next_id == 0) next_id = 1;
+    msg.id = next_id;
+    atomic_store_explicit(&current_id, msg.id, memory_order_relaxed);
+    xQueueOverwrite(job_queue, &msg);
+    return msg.id;
+}
+
+void spectro_job_cancel(void)
+{
+    atomic_store_explicit(&current_id, 0, memory_order_relaxed);
+}
+
+int spectro_job_frames_done(uint32_t id)
+{
+    if (id == 0 || !still_current(id)) return -1;
+    // Queued but not picked up yet
+    if (atomic_load_explicit(&done_id, memory_order_acquire) != id) return 0;
+    return atomic_load_explicit(&done_frames, memory_order_acquire);
+}
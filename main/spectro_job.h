@@ -0,0 +1,29 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "stft_cache.h"
+
+// Fills a recording's STFT cache on a background task. Frames are written
+// in order, and the UI thread polls how many are final so it can draw them
+// while the rest are still being analysed.
+typedef struct {
+    const int16_t * samples;    // must stay valid until the job ends
+    int count;
+    stft_cache_t * cache;       // frames for count samples, see stft_cache_reset()
+} spectro_job_t;
+
+// Starts the worker task
+bool spectro_job_init(void);
+
+// UI thread only. Supersedes any running job. Returns the job id, or 0 if
+// the job could not be queued. The job is copied, not the buffers it points to.
+uint32_t spectro_job_start(const spectro_job_t *job);
+
+// Stops the running job at its next frame, e.g. before its samples are
+// overwritten
+void spectro_job_cancel(void);
+
+// Frames [0, n) of job id are final in its cache. Returns -1 once the job
+// has been cancelled or superseded.
+int spectro_job_frames_done(uint32_t id);
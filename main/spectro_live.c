@@ -0,0 +1,144 @@
+#include "spectro_live.h"
+#include "audio_ring.h"
+#include "task_topology.h"
+#include <stdatomic.h>
+#include <stdio.h>
+#include <string.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "esp_timer.h"
+#include "esp_heap_caps.h"
+
+// About a quarter second at 16 kHz, several hops of slack
+#define LIVE_RING_SAMPLES 4096
+
+static spectro_live_cfg_t cfg;
+static const fft_plan_t * plan = NULL;
+static const freq_map_t * fmap = NULL;
+static audio_ring_t ring;
+static SemaphoreHandle_t wake = NULL;
+// Held by the analyzer while it works through frames, so the UI can wait
+// for it to be idle before touching the frame count or the code matrix
+static SemaphoreHandle_t busy = NULL;
+
+// Analyzer task state: the last fft_size samples, newest at the end
+static int16_t * history = NULL;
+static float * frame = NULL;
+static float * mags = NULL;
+static float * rows = NULL;
+
+static atomic_bool active;
+static atomic_uint frames_done;
+static volatile spectro_live_stats_t stats;
+static uint32_t overflow_base = 0;
+
+static void analyze_frame(void)
+{
+    int64_t t0 = esp_timer_get_time();
+
+    memmove(history, &history[cfg.hop], (cfg.fft_size - cfg.hop) * sizeof(int16_t));
+    audio_ring_read(&ring, &history[cfg.fft_size - cfg.hop], cfg.hop);
+    for (int i = 0; i < cfg.fft_size; i++) frame[i] = (float)history[i];
+
+    uint32_t f = atomic_load_explicit(&frames_done, memory_order_relaxed);
+    uint8_t * column = &cfg.codes[(f % cfg.width) * cfg.height];
+    stft_analyze_frame(plan, fmap, frame, mags, rows, column);
+    atomic_store_explicit(&frames_done, f + 1, memory_order_release);
+
+    uint32_t us = (uint32_t)(esp_timer_get_time() - t0);
+    stats.frames = f + 1;
+    stats.busy_us += us;
+    if (us > stats.max_us) stats.max_us = us;
+}
+
+static void analyzer_task(void *arg)
+{
+    while (1) {
+        xSemaphoreTake(wake, portMAX_DELAY);
+
+        xSemaphoreTake(busy, portMAX_DELAY);
+        while (atomic_load(&active) && audio_ring_available(&ring) >= cfg.hop) {
+            analyze_frame();
+        }
+        xSemaphoreGive(busy);
+    }
+}
+
+bool spectro_live_init(const spectro_live_cfg_t *c)
+{
+    if (wake) return true;
+    if (!c->codes || c->hop <= 0 || c->hop > c->fft_size) return false;
+
+    cfg = *c;
+    // Looked up on the UI thread, which owns the table caches
+    plan = fft_plan_get(cfg.fft_size);
+    fmap = freq_map_get(cfg.fft_size, cfg.height, cfg.scale, cfg.sample_rate);
+    history = heap_caps_calloc(cfg.fft_size, sizeof(int16_t), MALLOC_CAP_INTERNAL);
+    frame = heap_caps_malloc(cfg.fft_size * sizeof(float), MALLOC_CAP_INTERNAL);
+    mags = heap_caps_malloc((cfg.fft_size / 2) * sizeof(float), MALLOC_CAP_INTERNAL);
+    rows = heap_caps_malloc(cfg.height * sizeof(float), MALLOC_CAP_INTERNAL);
+    if (!plan || !fmap || !history || !frame || !mags || !rows ||
+        !audio_ring_init(&ring, LIVE_RING_SAMPLES)) {
+        printf("Live analyzer: Failed to allocate buffers\n");
+        return false;
+    }
+
+    wake = xSemaphoreCreateBinary();
+    busy = xSemaphoreCreateMutex();
+    if (!wake || !busy) return false;
+    return task_topology_start(TASK_ANALYZER, analyzer_task, NULL);
+}
+
+void spectro_live_start(void)
+{
+    if (!wake) return;
+
+    // With the analyzer parked, its state can be reset from here; whatever
+    // was left in the ring from the previous run is dropped
+    xSemaphoreTake(busy, portMAX_DELAY);
+    audio_ring_skip(&ring, audio_ring_available(&ring));
+    memset(history, 0, cfg.fft_size * sizeof(int16_t));
+    memset((void *)&stats, 0, sizeof(stats));
+    overflow_base = ring.overflows;
+    atomic_store(&frames_done, 0);
+    atomic_store(&active, true);
+    xSemaphoreGive(busy);
+    xSemaphoreGive(wake);
+}
+
+void spectro_live_stop(void)
+{
+    if (!wake) return;
+    atomic_store(&active, false);
+    // The analyzer checks active before each frame, so this waits for at
+    // most the frame in progress
+    xSemaphoreTake(busy, portMAX_DELAY);
+    xSemaphoreGive(busy);
+}
+
+bool spectro_live_active(void)
+{
+    return atomic_load(&active);
+}
+
+void spectro_live_push(const int16_t *samples, int n)
+{
+    if (!atomic_load(&active)) return;
+
+    // Overflows are counted by the ring; the analyzer simply skips ahead
+    audio_ring_write(&ring, samples, n);
+    if (audio_ring_available(&ring) >= cfg.hop) xSemaphoreGive(wake);
+}
+
+uint32_t spectro_live_frames(void)
+{
+    return atomic_load_explicit(&frames_done, memory_order_acquire);
+}
+
+void spectro_live_get_stats(spectro_live_stats_t *out)
+{
+    out->frames = stats.frames;
+    out->busy_us = stats.busy_us;
+    out->max_us = stats.max_us;
+    out->overflows = ring.overflows - overflow_base;
+}
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "stft_cache.h"
+
+// Live scrolling spectrogram. The capture side pushes mic blocks; an
+// analyzer task computes one overlapping STFT frame per hop and writes its
+// codes (see stft_cache.h) into a circular matrix, frame f going to column
+// f % width.
+typedef struct {
+    int fft_size;           // power of two
+    int hop;                // samples between frames
+    int width;              // columns in the circular matrix
+    int height;             // rows, top row highest frequency
+    freq_scale_t scale;
+    float sample_rate;
+    uint8_t * codes;        // width x height, column-major
+} spectro_live_cfg_t;
+
+typedef struct {
+    uint32_t frames;        // frames analysed since start
+    uint64_t busy_us;       // total analysis time over those frames
+    uint32_t max_us;        // slowest frame
+    uint32_t overflows;     // samples dropped because the analyzer fell behind
+} spectro_live_stats_t;
+
+// Allocates the frame buffers and starts the analyzer task. UI thread.
+bool spectro_live_init(const spectro_live_cfg_t *cfg);
+
+// UI thread. Both wait for the analyzer to finish the frame it is on, so
+// after either call it is not writing to the code matrix. Starting clears
+// the history, the frame count and the stats.
+void spectro_live_start(void);
+void spectro_live_stop(void);
+bool spectro_live_active(void);
+
+// Capture side. Drops the block when live analysis is off.
+void spectro_live_push(const int16_t *samples, int n);
+
+// Frames whose columns are final in the code matrix
+uint32_t spectro_live_frames(void);
+void spectro_live_get_stats(spectro_live_stats_t *out);
@@ -0,0 +1,74 @@
+#include "stft_cache.h"
+#include "spectro_blit.h"
+#include "audio_platform.h"
+#include <math.h>
+#include <string.h>
+
+static uint8_t level_lut[256];
+static bool level_lut_ready = false;
+
+bool stft_cache_init(stft_cache_t *c, int fft_size, int hop, int rows,
+                     freq_scale_t scale, float sample_rate, int max_samples)
+{
+    memset(c, 0, sizeof(*c));
+    c->fft_size = fft_size;
+    c->hop = hop;
+    c->rows = rows;
+    c->scale = scale;
+    c->sample_rate = sample_rate;
+    c->capacity = (max_samples + hop - 1) / hop;
+    c->codes = audio_calloc((size_t)c->capacity * rows, 1, AUDIO_MEM_BULK);
+    return c->codes != NULL;
+}
+
+int stft_cache_reset(stft_cache_t *c, int count)
+{
+    int frames = (count + c->hop - 1) / c->hop;
+    if (frames > c->capacity) frames = c->capacity;
+    c->frames = frames;
+    return frames;
+}
+
+// Code for magnitude mag against the frame reference, as 20 log10 of the
+// ratio in STFT_DB_STEP units
+static inline uint8_t mag_code(float mag, float inv_ref)
+{
+    float ratio = mag * inv_ref;
+    if (ratio <= 1e-6f) return STFT_CODE_MIN;
+    float code = -20.0f / STFT_DB_STEP * log10f(ratio);
+    if (code <= 0.0f) return 0;
+    if (code >= (float)STFT_CODE_MIN) return STFT_CODE_MIN;
+    return (uint8_t)(code + 0.5f);
+}
+
+void stft_analyze_frame(const fft_plan_t *plan, const freq_map_t *fmap,
+                        float *frame, float *mags, float *rows, uint8_t *codes)
+{
+    fft_magnitude(plan, frame, mags);
+
+    // Reference is the loudest bin of the frame, ignoring DC
+    float ref = 0.0f;
+    for (int i = 1; i < plan->n / 2; i++) {
+        if (mags[i] > ref) ref = mags[i];
+    }
+    if (ref < STFT_REF_FLOOR) ref = STFT_REF_FLOOR;
+    float inv_ref = 1.0f / ref;
+
+    // Each row is the RMS of its band of bins, top row highest
+    freq_map_apply(fmap, mags, rows);
+    for (int y = 0; y < fmap->rows; y++) {
+        codes[y] = mag_code(rows[y], inv_ref);
+    }
+}
+
+void stft_codes_to_levels(const uint8_t *codes, uint8_t *levels, int n)
+{
+    if (!level_lut_ready) {
+        for (int i = 0; i < 256; i++) {
+            float ratio = powf(10.0f, -(float)i * STFT_DB_STEP / 20.0f);
+            level_lut[i] = i == STFT_CODE_MIN ? 0 : spectro_quantize(ratio / 0.7f);
+        }
+        level_lut_ready = true;
+    }
+    for (int i = 0; i < n; i++) levels[i] = level_lut[codes[i]];
+}
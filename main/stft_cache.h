@@ -0,0 +1,49 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "fft.h"
+#include "freq_map.h"
+
+// A recording's short-time spectrum, computed once at a fixed hop and kept
+// as 8-bit log magnitudes so any view of it is a lookup, not an FFT.
+// Code 0 is the loudest bin of the frame (at least STFT_REF_FLOOR); each
+// code is STFT_DB_STEP dB quieter, and 255 means at or below the floor.
+#define STFT_DB_STEP   0.25f
+#define STFT_REF_FLOOR 1000.0f
+#define STFT_CODE_MIN  255
+
+typedef struct {
+    int fft_size;
+    int hop;
+    int rows;               // top row highest frequency
+    freq_scale_t scale;
+    float sample_rate;
+    int capacity;           // frames allocated
+    int frames;             // frames of the current recording
+    uint8_t * codes;        // capacity x rows, frame-major
+} stft_cache_t;
+
+// Allocates room for max_samples worth of frames in PSRAM
+bool stft_cache_init(stft_cache_t *c, int fft_size, int hop, int rows,
+                     freq_scale_t scale, float sample_rate, int max_samples);
+
+// Sizes the cache for a new recording of count samples and returns the
+// frame count. Frame f starts at sample f * hop.
+int stft_cache_reset(stft_cache_t *c, int count);
+
+static inline uint8_t * stft_cache_frame(const stft_cache_t *c, int f)
+{
+    return &c->codes[f * c->rows];
+}
+
+// Windows and transforms the fft_size samples in frame (overwritten), maps
+// the bins onto the rows of fmap and writes one code per row. mags holds
+// fft_size / 2 floats and rows fmap->rows floats of scratch.
+void stft_analyze_frame(const fft_plan_t *plan, const freq_map_t *fmap,
+                        float *frame, float *mags, float *rows, uint8_t *codes);
+
+// Palette levels for n codes, on the same scale the spectrogram has always
+// used: linear in magnitude, full scale at 70% of the frame's loudest bin.
+// Builds its table on first use; call from one task only.
+void stft_codes_to_levels(const uint8_t *codes, uint8_t *levels, int n);
@@ -0,0 +1,121 @@
+#include "stroke_simplify.h"
+#include <math.h>
+#include <stdlib.h>
+
+// Squared distance from p to the segment a-b
+static float seg_dist2(const lv_point_precise_t *p, const lv_point_precise_t *a, const lv_point_precise_t *b)
+{
+    float dx = (float)(b->x - a->x);
+    float dy = (float)(b->y - a->y);
+    float px = (float)(p->x - a->x);
+    float py = (float)(p->y - a->y);
+    float len2 = dx * dx + dy * dy;
+
+    float t = len2 > 0.0f ? (px * dx + py * dy) / len2 : 0.0f;
+    if (t < 0.0f) t = 0.0f;
+    else if (t > 1.0f) t = 1.0f;
+    float ex = px - t * dx;
+    float ey = py - t * dy;
+    return ex * ex + ey * ey;
+}
+
+uint32_t stroke_simplify(lv_point_precise_t *pts, uint32_t n, float tolerance)
+{
+    if (n < 3) return n;
+
+    // Spans still to split, worked off a stack rather than by recursion so
+    // a long stroke cannot run the UI task out of stack
+    uint8_t * keep = calloc(n, 1);
+    uint32_t * stack = malloc(2 * n * sizeof(uint32_t));
+    if (!keep || !stack) {
+        free(keep);
+        free(stack);
+        return n;
+    }
+
+    float tol2 = tolerance * tolerance;
+    int top = 0;
+    keep[0] = keep[n - 1] = 1;
+    stack[top++] = 0;
+    stack[top++] = n - 1;
+
+    while (top > 0) {
+        uint32_t last = stack[--top];
+        uint32_t first = stack[--top];
+
+        float worst = tol2;
+        uint32_t split = 0;
+        for (uint32_t i = first + 1; i < last; i++) {
+            float d2 = seg_dist2(&pts[i], &pts[first], &pts[last]);
+            if (d2 > worst) {
+                worst = d2;
+                split = i;
+            }
+        }
+        if (split) {
+            keep[split] = 1;
+            stack[top++] = first;
+            stack[top++] = split;
+            stack[top++] = split;
+            stack[top++] = last;
+        }
+    }
+
+    uint32_t m = 0;
+    for (uint32_t i = 0; i < n; i++) {
+        if (keep[i]) pts[m++] = pts[i];
+    }
+    free(keep);
+    free(stack);
+    return m;
+}
+
+uint32_t stroke_smooth_max(uint32_t n, int max_steps)
+{
+    return n < 2 ? n : (n - 1) * (uint32_t)max_steps + 1;
+}
+
+uint32_t stroke_smooth(const lv_point_precise_t *pts, uint32_t n, float tolerance, int max_steps,
+                       lv_point_precise_t *out)
+{
+    if (n < 3) {
+        for (uint32_t i = 0; i < n; i++) out[i] = pts[i];
+        return n;
+    }
+
+    uint32_t m = 0;
+    out[m++] = pts[0];
+    for (uint32_t i = 0; i + 1 < n; i++) {
+        // The end points stand in for the missing neighbours
+        const lv_point_precise_t * p0 = &pts[i > 0 ? i - 1 : 0];
+        const lv_point_precise_t * p1 = &pts[i];
+        const lv_point_precise_t * p2 = &pts[i + 1];
+        const lv_point_precise_t * p3 = &pts[i + 2 < n ? i + 2 : n - 1];
+
+        // The curve bows (p1 + p2 - p0 - p3) / 16 away from the chord at
+        // its middle, and splitting it in k pieces cuts that by k^2, so
+        // nearly straight segments are left as they are
+        float bx = (float)(p1->x + p2->x - p0->x - p3->x) / 16.0f;
+        float by = (float)(p1->y + p2->y - p0->y - p3->y) / 16.0f;
+        int steps = (int)ceilf(sqrtf(sqrtf(bx * bx + by * by) / tolerance));
+        if (steps < 1) steps = 1;
+        if (steps > max_steps) steps = max_steps;
+
+        for (int s = 1; s < steps; s++) {
+            float t = (float)s / (float)steps;
+            float t2 = t * t;
+            float t3 = t2 * t;
+            float x = 0.5f * (2.0f * p1->x + (p2->x - p0->x) * t
+                              + (2.0f * p0->x - 5.0f * p1->x + 4.0f * p2->x - p3->x) * t2
+                              + (3.0f * p1->x - p0->x - 3.0f * p2->x + p3->x) * t3);
+            float y = 0.5f * (2.0f * p1->y + (p2->y - p0->y) * t
+                              + (2.0f * p0->y - 5.0f * p1->y + 4.0f * p2->y - p3->y) * t2
+                              + (3.0f * p1->y - p0->y - 3.0f * p2->y + p3->y) * t3);
+            lv_point_precise_t q = { (lv_value_precise_t)lrintf(x), (lv_value_precise_t)lrintf(y) };
+            // Steps shorter than a pixel round onto the same point
+            if (q.x != out[m - 1].x || q.y != out[m - 1].y) out[m++] = q;
+        }
+        out[m++] = *p2;
+    }
+    return m;
+}
@@ -0,0 +1,22 @@
+#pragma once
+
+#include <stdint.h>
+#include "lvgl.h"
+
+// Pen-up clean-up of drawn strokes: Ramer-Douglas-Peucker drops points that
+// lie within a tolerance of the line through their neighbours, and
+// Catmull-Rom resampling rounds the corners of what is left.
+
+// Simplifies pts in place and returns the number of points kept. The first
+// and last point are always kept. Returns n unchanged if scratch memory
+// cannot be had.
+uint32_t stroke_simplify(lv_point_precise_t *pts, uint32_t n, float tolerance);
+
+// Most points stroke_smooth can write for n control points
+uint32_t stroke_smooth_max(uint32_t n, int max_steps);
+
+// Catmull-Rom spline through all n points. Each segment is split into as
+// many pieces (at most max_steps) as it takes for the line to stay within
+// tolerance px of the curve. Returns the number of points written to out.
+uint32_t stroke_smooth(const lv_point_precise_t *pts, uint32_t n, float tolerance, int max_steps,
+                       lv_point_precise_t *out);
@@ -0,0 +1,360 @@
+#include "synth.h"
+#include "voice_alloc.h"
+#include "wavetable.h"
+#include <math.h>
+#include <stdbool.h>
+#include <string.h>
+
+typedef enum {
+    ENV_IDLE = 0,
+    ENV_ATTACK,
+    ENV_DECAY,
+    ENV_SUSTAIN,
+    ENV_RELEASE,
+    ENV_FADE      // stolen voice ramping out quickly
+} env_state_t;
+
+// A stolen voice hands its state to one of these extra slots, which fades
+// it to silence over SYNTH_STEAL_FADE_SAMPLES instead of cutting it off.
+// There is one per voice, so even a full pool stolen on one sample fades.
+#define SYNTH_FADE_VOICES        SYNTH_MAX_VOICES
+#define SYNTH_STEAL_FADE_SAMPLES 32
+#define SYNTH_TOTAL_VOICES       (SYNTH_MAX_VOICES + SYNTH_FADE_VOICES)
+
+// Voice state in structure-of-arrays form so each per-voice block loop
+// streams through contiguous memory.
+static struct {
+    uint32_t phase[SYNTH_TOTAL_VOICES];
+    uint32_t phase_inc[SYNTH_TOTAL_VOICES];
+    float env_val[SYNTH_TOTAL_VOICES];
+    float fade_step[SYNTH_TOTAL_VOICES];
+    uint8_t env_state[SYNTH_TOTAL_VOICES];
+    int note_idx[SYNTH_TOTAL_VOICES];
+} voices;
+
+static voice_alloc_t voice_pool;
+static int8_t note_voice[SYNTH_MAX_NOTES]; // sounding voice per note, or VOICE_NONE
+static uint8_t fade_free[SYNTH_FADE_VOICES];   // idle fade slots, used as a stack
+static int fade_free_count = 0;
+
+typedef struct {
+    int waveform;      // wt_wave_t
+    float a_time;      // seconds
+    float d_time;      // seconds
+    float s_level;     // 0.0 to 1.0
+    float r_time;      // seconds
+    float volume;      // 0.0 to 1.0
+} synth_params_t;
+
+// Only ever touched by the audio thread; the UI changes it through events
+static synth_params_t params = {
+    .waveform = WT_SQUARE,
+    .a_time = 0.1f,
+    .d_time = 0.1f,
+    .s_level = 0.5f,
+    .r_time = 0.3f,
+    .volume = 0.4f,
+};
+
+static float synth_sample_rate = 16000.0f;
+static int64_t note_on_time_us = 0;
+static int note_on_offset = -1;
+static float env_buf[SYNTH_BLOCK_SIZE];
+static float osc_buf[SYNTH_BLOCK_SIZE];
+
+void synth_init(float sample_rate)
+{
+    synth_sample_rate = sample_rate;
+    memset(&voices, 0, sizeof(voices));
+    for (int v = 0; v < SYNTH_TOTAL_VOICES; v++) voices.note_idx[v] = -1;
+    for (int n = 0; n < SYNTH_MAX_NOTES; n++) note_voice[n] = VOICE_NONE;
+    voice_alloc_init(&voice_pool, SYNTH_MAX_VOICES);
+    fade_free_count = 0;
+    for (int v = SYNTH_TOTAL_VOICES - 1; v >= SYNTH_MAX_VOICES; v--) fade_free[fade_free_count++] = (uint8_t)v;
+}
+
+static void fade_out_voice(int v)
+{
+    int f;
+    if (fade_free_count > 0) {
+        f = fade_free[--fade_free_count];
+    } else {
+        // More steals than voices within one fade: take over the quietest
+        f = SYNTH_MAX_VOICES;
+        for (int s = SYNTH_MAX_VOICES + 1; s < SYNTH_TOTAL_VOICES; s++) {
+            if (voices.env_val[s] < voices.env_val[f]) f = s;
+        }
+    }
+
+    voices.phase[f] = voices.phase[v];
+    voices.phase_inc[f] = voices.phase_inc[v];
+    voices.env_val[f] = voices.env_val[v];
+    voices.fade_step[f] = voices.env_val[v] / (float)SYNTH_STEAL_FADE_SAMPLES;
+    voices.note_idx[f] = -1;
+    voices.env_state[f] = ENV_FADE;
+}
+
+static void synth_note_on(int note_idx, float freq)
+{
+    if (note_idx < 0 || note_idx >= SYNTH_MAX_NOTES) return;
+
+    // Retriggering a held note releases the previous voice first
+    int held = note_voice[note_idx];
+    if (held != VOICE_NONE) {
+        voices.env_state[held] = ENV_RELEASE;
+        voice_alloc_release(&voice_pool, held);
+        note_voice[note_idx] = VOICE_NONE;
+    }
+
+    bool stolen;
+    int v = voice_alloc_note_on(&voice_pool, &stolen);
+    if (v == VOICE_NONE) return;
+
+    if (stolen) {
+        fade_out_voice(v);
+        int old_note = voices.note_idx[v];
+        if (old_note >= 0 && note_voice[old_note] == v) note_voice[old_note] = VOICE_NONE;
+    }
+
+    voices.phase_inc[v] = wavetable_phase_inc(freq, synth_sample_rate);
+    voices.note_idx[v] = note_idx;
+    voices.env_state[v] = ENV_ATTACK;
+    voices.env_val[v] = 0.0f;
+    voices.phase[v] = 0;
+    note_voice[note_idx] = (int8_t)v;
+}
+
+static void synth_note_off(int note_idx)
+{
+    if (note_idx < 0 || note_idx >= SYNTH_MAX_NOTES) return;
+
+    int v = note_voice[note_idx];
+    if (v == VOICE_NONE) return;
+    voices.env_state[v] = ENV_RELEASE;
+    voice_alloc_release(&voice_pool, v);
+    note_voice[note_idx] = VOICE_NONE;
+}
+
+// Writes a linear ramp from *env toward target at `rate` per sample, at most
+// n samples, heading whichever way the target lies. Returns the number of
+// samples written and sets *reached when the target was hit within the span
+// (the last written sample is then exact).
+static int env_ramp(float * restrict dst, int n, float *env, float rate, float target, bool *reached)
+{
+    float dist = target - *env;
+    *reached = false;
+    if (dist == 0.0f || rate <= 0.0f) {
+        *env = target;
+        *reached = true;
+        return 0;
+    }
+
+    float step = dist > 0.0f ? rate : -rate;
+    int span = n;
+    float steps = dist / step;
+    if (steps <= (float)n) {
+        span = (int)ceilf(steps);
+        *reached = true;
+    }
+
+    float e0 = *env;
+    for (int k = 0; k < span; k++) {
+        dst[k] = e0 + step * (float)(k + 1);
+    }
+
+    if (*reached) {
+        dst[span - 1] = target;
+        *env = target;
+    } else {
+        *env = dst[span - 1];
+    }
+    return span;
+}
+
+// Fills env_out with the voice envelope one segment at a time. Returns the
+// number of audible samples, which is less than n if the voice ran out.
+static int render_envelope(int v, float * restrict env_out, int n,
+                           float a_rate, float d_rate, float s_lvl, float r_rate)
+{
+    int done = 0;
+    bool reached;
+
+    while (done < n) {
+        switch (voices.env_state[v]) {
+            case ENV_ATTACK:
+                done += env_ramp(env_out + done, n - done, &voices.env_val[v], a_rate, 1.0f, &reached);
+                if (reached) voices.env_state[v] = ENV_DECAY;
+                break;
+            case ENV_DECAY:
+                // A sustain level raised above the envelope is approached
+                // at the attack rate rather than jumped to
+                done += env_ramp(env_out + done, n - done, &voices.env_val[v],
+                                 voices.env_val[v] < s_lvl ? a_rate : d_rate, s_lvl, &reached);
+                if (reached) voices.env_state[v] = ENV_SUSTAIN;
+                break;
+            case ENV_SUSTAIN:
+                // A changed sustain level is glided to through the decay
+                if (voices.env_val[v] != s_lvl) {
+                    voices.env_state[v] = ENV_DECAY;
+                    break;
+                }
+                for (int i = done; i < n; i++) env_out[i] = s_lvl;
+                done = n;
+                break;
+            case ENV_RELEASE:
+                // Release from current envelope value
+                done += env_ramp(env_out + done, n - done, &voices.env_val[v], r_rate, 0.0f, &reached);
+                if (reached) {
+                    voices.env_state[v] = ENV_IDLE;
+                    return done;
+                }
+                break;
+            case ENV_FADE:
+                done += env_ramp(env_out + done, n - done, &voices.env_val[v], voices.fade_step[v], 0.0f, &reached);
+                if (reached) {
+                    voices.env_state[v] = ENV_IDLE;
+                    return done;
+                }
+                break;
+            default:
+                return done;
+        }
+    }
+    return done;
+}
+
+typedef struct {
+    float a_rate;
+    float d_rate;
+    float s_lvl;
+    float r_rate;
+} env_rates_t;
+
+static void render_voice(float * restrict out, int n, int v, const env_rates_t *r)
+{
+    const float *table = wavetable_select(params.waveform, voices.phase_inc[v]);
+    int len = render_envelope(v, env_buf, n, r->a_rate, r->d_rate, r->s_lvl, r->r_rate);
+    if (!table || len == 0) return;
+
+    // Phase of sample i is computed directly so there is no loop-carried
+    // dependency; the accumulator wraps on overflow.
+    uint32_t phase = voices.phase[v];
+    uint32_t inc = voices.phase_inc[v];
+    for (int i = 0; i < len; i++) {
+        osc_buf[i] = wavetable_read(table, phase + (uint32_t)i * inc);
+    }
+    for (int i = 0; i < len; i++) {
+        out[i] += osc_buf[i] * env_buf[i];
+    }
+    voices.phase[v] = phase + (uint32_t)n * inc;
+}
+
+static void synth_render_block(float * restrict out, int n)
+{
+    float a_time = params.a_time < 0.01f ? 0.01f : params.a_time;
+    float d_time = params.d_time < 0.01f ? 0.01f : params.d_time;
+    float s_lvl = params.s_level < 0.01f ? 0.01f : params.s_level;
+    float r_time = params.r_time < 0.01f ? 0.01f : params.r_time;
+    // Soften to prevent clipping when multiple notes play
+    float gain = params.volume / 2.0f;
+
+    env_rates_t rates = {
+        .a_rate = 1.0f / (a_time * synth_sample_rate),
+        .d_rate = (1.0f - s_lvl) / (d_time * synth_sample_rate),
+        .s_lvl = s_lvl,
+        .r_rate = s_lvl / (r_time * synth_sample_rate),
+    };
+
+    for (int i = 0; i < n; i++) out[i] = 0.0f;
+
+    // Only live voices are visited: both allocator lists, then the fade slots
+    for (int l = VOICE_LIST_SOUNDING; l <= VOICE_LIST_RELEASING; l++) {
+        int v = voice_alloc_first(&voice_pool, l);
+        while (v != VOICE_NONE) {
+            int next = voice_alloc_next(&voice_pool, v);
+            render_voice(out, n, v, &rates);
+            if (voices.env_state[v] == ENV_IDLE) voice_alloc_free(&voice_pool, v);
+            v = next;
+        }
+    }
+    for (int v = SYNTH_MAX_VOICES; v < SYNTH_TOTAL_VOICES; v++) {
+        if (voices.env_state[v] == ENV_IDLE) continue;
+        render_voice(out, n, v, &rates);
+        if (voices.env_state[v] == ENV_IDLE) fade_free[fade_free_count++] = (uint8_t)v;
+    }
+
+    for (int i = 0; i < n; i++) out[i] *= gain;
+}
+
+void synth_apply_event(const synth_event_t *ev)
+{
+    switch (ev->type) {
+        case SYNTH_EV_NOTE_ON:
+            synth_note_on(ev->note_idx, ev->value);
+            break;
+        case SYNTH_EV_NOTE_OFF:
+            synth_note_off(ev->note_idx);
+            break;
+        case SYNTH_EV_PARAM:
+            switch (ev->param) {
+                case SYNTH_PARAM_WAVEFORM: params.waveform = (int)ev->value; break;
+                case SYNTH_PARAM_ATTACK:   params.a_time = ev->value; break;
+                case SYNTH_PARAM_DECAY:    params.d_time = ev->value; break;
+                case SYNTH_PARAM_SUSTAIN:  params.s_level = ev->value; break;
+                case SYNTH_PARAM_RELEASE:  params.r_time = ev->value; break;
+                case SYNTH_PARAM_VOLUME:   params.volume = ev->value; break;
+            }
+            break;
+    }
+}
+
+// Renders up to sample offset `to` and applies the event there
+static void synth_render_until(float *out, int *pos, int to, const synth_event_t *ev)
+{
+    if (to > *pos) {
+        synth_render_block(out + *pos, to - *pos);
+        *pos = to;
+    }
+    synth_apply_event(ev);
+}
+
+void synth_render(float *out, int n, int64_t window_start_us,
+                  const synth_timed_event_t *timed, int timed_count)
+{
+    if (n > SYNTH_BLOCK_SIZE) n = SYNTH_BLOCK_SIZE;
+
+    int pos = 0;
+    int t = 0;
+    synth_event_t ev;
+    note_on_offset = -1;
+    while (synth_events_pop(&ev)) {
+        int64_t ofs = ((ev.time_us - window_start_us) * (int64_t)synth_sample_rate) / 1000000;
+        if (ofs < pos) ofs = pos;
+        if (ofs > n - 1) ofs = n - 1;
+        // Queue offsets only move forward, so the two streams merge in order
+        for (; t < timed_count && timed[t].offset <= ofs; t++) {
+            synth_render_until(out, &pos, timed[t].offset < pos ? pos : timed[t].offset, &timed[t].ev);
+        }
+        // Only key presses count towards the latency measurement
+        if (ev.type == SYNTH_EV_NOTE_ON && note_on_offset < 0) {
+            note_on_time_us = ev.time_us;
+            note_on_offset = (int)ofs;
+        }
+        synth_render_until(out, &pos, (int)ofs, &ev);
+    }
+    for (; t < timed_count; t++) {
+        int ofs = timed[t].offset;
+        if (ofs < pos) ofs = pos;
+        if (ofs > n - 1) ofs = n - 1;
+        synth_render_until(out, &pos, ofs, &timed[t].ev);
+    }
+    if (pos < n) synth_render_block(out + pos, n - pos);
+}
+
+bool synth_last_note_on(int64_t *time_us, int *offset)
+{
+    if (note_on_offset < 0) return false;
+    *time_us = note_on_time_us;
+    *offset = note_on_offset;
+    return true;
+}
@@ -0,0 +1,32 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "synth_events.h"
+
+#define SYNTH_MAX_VOICES 64
+#define SYNTH_BLOCK_SIZE 256
+#define SYNTH_MAX_NOTES  128  // note indices 0..127, each sounding on at most one voice
+
+void synth_init(float sample_rate);
+void synth_apply_event(const synth_event_t *ev);
+
+// Event generated inside the audio thread for a known sample offset of the
+// block about to be rendered, e.g. by the sequencer.
+typedef struct {
+    int offset;
+    synth_event_t ev;
+} synth_timed_event_t;
+
+// Audio thread only. Drains the event queue and renders up to
+// SYNTH_BLOCK_SIZE samples of the volume-scaled voice mix into out. Events
+// are placed at the sample offset their timestamp falls on relative to
+// window_start_us, so timing is preserved with one block of fixed latency.
+// timed holds timed_count events sorted by offset, applied at exactly
+// that offset; it may be NULL.
+void synth_render(float *out, int n, int64_t window_start_us,
+                  const synth_timed_event_t *timed, int timed_count);
+
+// Earliest note-on applied by the last synth_render() call: the UI timestamp
+// of the key press and the sample offset the note started at.
+bool synth_last_note_on(int64_t *time_us, int *offset);
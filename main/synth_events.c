@@ -0,0 +1,30 @@
+#include "synth_events.h"
+#include <stdatomic.h>
+
+static synth_event_t ring[SYNTH_EVENT_QUEUE_LEN];
+static atomic_uint head = 0; // next slot to write, owned by the producer
+static atomic_uint tail = 0; // next slot to read, owned by the consumer
+
+bool synth_events_push(const synth_event_t *ev)
+{
+    unsigned h = atomic_load_explicit(&head, memory_order_relaxed);
+    unsigned t = atomic_load_explicit(&tail, memory_order_acquire);
+    if (h - t >= SYNTH_EVENT_QUEUE_LEN) return false;
+
+    ring[h & (SYNTH_EVENT_QUEUE_LEN - 1)] = *ev;
+    // Publish the slot only after its contents are written
+    atomic_store_explicit(&head, h + 1, memory_order_release);
+    return true;
+}
+
+bool synth_events_pop(synth_event_t *ev)
+{
+    unsigned t = atomic_load_explicit(&tail, memory_order_relaxed);
+    unsigned h = atomic_load_explicit(&head, memory_order_acquire);
+    if (t == h) return false;
+
+    *ev = ring[t & (SYNTH_EVENT_QUEUE_LEN - 1)];
+    // Hand the slot back only after it has been copied out
+    atomic_store_explicit(&tail, t + 1, memory_order_release);
+    return true;
+}
@@ -0,0 +1,35 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// Must be a power of two
+#define SYNTH_EVENT_QUEUE_LEN 256
+
+typedef enum {
+    SYNTH_EV_NOTE_ON = 0,
+    SYNTH_EV_NOTE_OFF,
+    SYNTH_EV_PARAM
+} synth_event_type_t;
+
+typedef enum {
+    SYNTH_PARAM_WAVEFORM = 0,
+    SYNTH_PARAM_ATTACK,
+    SYNTH_PARAM_DECAY,
+    SYNTH_PARAM_SUSTAIN,
+    SYNTH_PARAM_RELEASE,
+    SYNTH_PARAM_VOLUME
+} synth_param_t;
+
+typedef struct {
+    int64_t time_us;   // esp_timer time the event was generated
+    uint8_t type;      // synth_event_type_t
+    uint8_t param;     // synth_param_t for SYNTH_EV_PARAM
+    int16_t note_idx;
+    float value;       // frequency for NOTE_ON, parameter value for PARAM
+} synth_event_t;
+
+// Single-producer / single-consumer, lock-free. Only the UI (LVGL) thread
+// may push and only the audio thread may pop.
+bool synth_events_push(const synth_event_t *ev);
+bool synth_events_pop(synth_event_t *ev);
@@ -0,0 +1,124 @@
+#include "task_topology.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static const task_slot_t topology[TASK_COUNT] = {
+    [TASK_UI]         = { "taskLVGL",     0, 4,  7168 },
+    [TASK_AUDIO]      = { "audio_task",   1, 10, 4096 },
+    [TASK_SENSOR]     = { "bmp280_task",  0, 3,  4096 },
+    // Capture shares the audio core so a redraw cannot delay the mic read
+    [TASK_CAPTURE]    = { "capture_task", 1, 9,  4096 },
+    // Card writes stall for tens of milliseconds; run them low on core 0
+    [TASK_REC_WRITER] = { "rec_writer",   0, 2,  4096 },
+    // Long FFT batches soak up what the audio tasks leave of core 1,
+    // so the LVGL task never competes with them
+    [TASK_SPECTRO]    = { "spectro_task", 1, 1,  4096 },
+    // One frame per hop, just above the batch jobs so it keeps up
+    [TASK_ANALYZER]   = { "analyzer",     1, 2,  4096 },
+    // Flash erases are slow and user-triggered; same slot as the SD writer
+    [TASK_CLIP_STORE] = { "clip_store",   0, 2,  4096 },
+};
+
+const task_slot_t * task_topology_get(task_id_t id)
+{
+    if (id < 0 || id >= TASK_COUNT) return NULL;
+    return &topology[id];
+}
+
+bool task_topology_start(task_id_t id, TaskFunction_t fn, void *arg)
+{
+    const task_slot_t * slot = task_topology_get(id);
+    if (!slot) return false;
+
+    if (xTaskCreatePinnedToCore(fn, slot->name, slot->stack, arg, slot->priority, NULL, slot->core) != pdPASS) {
+        printf("Tasks: Failed to start %s\n", slot->name);
+        return false;
+    }
+    return true;
+}
+
+#if configGENERATE_RUN_TIME_STATS && configUSE_TRACE_FACILITY
+
+// Run-time counters are cumulative, so keep the previous sample per task
+// handle and report deltas
+#define TASK_SNAPSHOT_MAX 40
+
+typedef struct {
+    TaskHandle_t handle;
+    configRUN_TIME_COUNTER_TYPE runtime;
+} task_prev_t;
+
+static TaskStatus_t status_buf[TASK_SNAPSHOT_MAX];
+static task_prev_t prev[TASK_SNAPSHOT_MAX];
+static int prev_count = 0;
+static configRUN_TIME_COUNTER_TYPE prev_total = 0;
+
+static configRUN_TIME_COUNTER_TYPE prev_runtime(TaskHandle_t handle)
+{
+    for (int i = 0; i < prev_count; i++) {
+        if (prev[i].handle == handle) return prev[i].runtime;
+    }
+    return 0;
+}
+
+static int cmp_load_desc(const void *a, const void *b)
+{
+    float la = ((const task_load_t *)a)->load;
+    float lb = ((const task_load_t *)b)->load;
+    return (la < lb) - (la > lb);
+}
+
+bool task_stats_sample(task_stats_t *out)
+{
+    configRUN_TIME_COUNTER_TYPE total;
+    UBaseType_t n = uxTaskGetSystemState(status_buf, TASK_SNAPSHOT_MAX, &total);
+    if (n == 0) return false;
+
+    bool have_prev = prev_count > 0;
+    float elapsed = (float)(configRUN_TIME_COUNTER_TYPE)(total - prev_total);
+
+    memset(out, 0, sizeof(*out));
+    if (have_prev && elapsed > 0.0f) {
+        for (int c = 0; c < portNUM_PROCESSORS; c++) out->core_load[c] = 1.0f;
+
+        for (UBaseType_t i = 0; i < n; i++) {
+            TaskStatus_t * t = &status_buf[i];
+            float load = (float)(configRUN_TIME_COUNTER_TYPE)(t->ulRunTimeCounter - prev_runtime(t->xHandle)) / elapsed;
+
+            for (int c = 0; c < portNUM_PROCESSORS; c++) {
+                if (t->xHandle == xTaskGetIdleTaskHandleForCore(c)) out->core_load[c] -= load;
+            }
+
+            if (out->count < TASK_STATS_MAX) {
+                task_load_t * tl = &out->tasks[out->count++];
+                strncpy(tl->name, t->pcTaskName, sizeof(tl->name) - 1);
+                tl->core = xTaskGetCoreID(t->xHandle);
+                tl->load = load;
+            }
+        }
+        for (int c = 0; c < portNUM_PROCESSORS; c++) {
+            if (out->core_load[c] < 0.0f) out->core_load[c] = 0.0f;
+        }
+        qsort(out->tasks, out->count, sizeof(task_load_t), cmp_load_desc);
+    }
+
+    for (UBaseType_t i = 0; i < n; i++) {
+        prev[i].handle = status_buf[i].xHandle;
+        prev[i].runtime = status_buf[i].ulRunTimeCounter;
+    }
+    prev_count = (int)n;
+    prev_total = total;
+
+    return have_prev && elapsed > 0.0f;
+}
+
+#else
+
+bool task_stats_sample(task_stats_t *out)
+{
+    memset(out, 0, sizeof(*out));
+    return false;
+}
+
+#endif
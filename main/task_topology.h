@@ -0,0 +1,54 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+// Where every long-running task lives. Audio and mic capture get core 1;
+// the LVGL port task, sensors, SD writes and the Wi-Fi stack share core 0,
+// so a heavy redraw can never preempt a block render.
+typedef enum {
+    TASK_UI = 0,      // LVGL port task, created by the BSP
+    TASK_AUDIO,
+    TASK_SENSOR,
+    TASK_CAPTURE,     // microphone reads
+    TASK_REC_WRITER,  // flushes recorder buffers to the SD card
+    TASK_SPECTRO,     // spectrogram jobs
+    TASK_ANALYZER,    // live scrolling spectrogram
+    TASK_CLIP_STORE,  // writes the clip library to flash
+    TASK_COUNT
+} task_id_t;
+
+typedef struct {
+    const char * name;
+    BaseType_t core;        // or tskNO_AFFINITY
+    UBaseType_t priority;
+    uint32_t stack;         // bytes
+} task_slot_t;
+
+const task_slot_t * task_topology_get(task_id_t id);
+
+// Creates the task with the core, priority and stack from its table entry.
+// Not used for TASK_UI, which the BSP creates from the lvgl_port config.
+bool task_topology_start(task_id_t id, TaskFunction_t fn, void *arg);
+
+// Run-time stats sampled from FreeRTOS, as a share of one core over the
+// interval since the previous task_stats_sample() call.
+#define TASK_STATS_MAX 24
+
+typedef struct {
+    char name[configMAX_TASK_NAME_LEN];
+    BaseType_t core;        // pinned core, or tskNO_AFFINITY
+    float load;             // 1.0 = one core fully busy
+} task_load_t;
+
+typedef struct {
+    float core_load[portNUM_PROCESSORS];
+    int count;              // tasks, sorted by load, busiest first
+    task_load_t tasks[TASK_STATS_MAX];
+} task_stats_t;
+
+// Returns false until two samples exist, or when run-time stats are not
+// enabled in the FreeRTOS configuration.
+bool task_stats_sample(task_stats_t *out);
@@ -0,0 +1,65 @@
+#include "voice_alloc.h"
+
+static void list_remove(voice_alloc_t *va, int v)
+{
+    int l = va->list[v];
+    int p = va->prev[v];
+    int n = va->next[v];
+    if (p != VOICE_NONE) va->next[p] = n; else va->head[l] = n;
+    if (n != VOICE_NONE) va->prev[n] = p; else va->tail[l] = p;
+    va->count[l]--;
+}
+
+static void list_append(voice_alloc_t *va, int v, voice_list_t l)
+{
+    va->list[v] = l;
+    va->next[v] = VOICE_NONE;
+    va->prev[v] = va->tail[l];
+    if (va->tail[l] != VOICE_NONE) va->next[va->tail[l]] = v; else va->head[l] = v;
+    va->tail[l] = v;
+    va->count[l]++;
+}
+
+void voice_alloc_init(voice_alloc_t *va, int num_voices)
+{
+    if (num_voices > VOICE_ALLOC_MAX) num_voices = VOICE_ALLOC_MAX;
+    va->num_voices = num_voices;
+    for (int l = 0; l < VOICE_LIST_COUNT; l++) {
+        va->head[l] = VOICE_NONE;
+        va->tail[l] = VOICE_NONE;
+        va->count[l] = 0;
+    }
+    for (int v = 0; v < num_voices; v++) {
+        list_append(va, v, VOICE_LIST_FREE);
+    }
+}
+
+int voice_alloc_note_on(voice_alloc_t *va, bool *stolen)
+{
+    int v = va->head[VOICE_LIST_FREE];
+    *stolen = false;
+    if (v == VOICE_NONE) {
+        v = va->head[VOICE_LIST_RELEASING];
+        if (v == VOICE_NONE) v = va->head[VOICE_LIST_SOUNDING];
+        if (v == VOICE_NONE) return VOICE_NONE;
+        *stolen = true;
+    }
+
+    list_remove(va, v);
+    list_append(va, v, VOICE_LIST_SOUNDING);
+    return v;
+}
+
+void voice_alloc_release(voice_alloc_t *va, int v)
+{
+    if (v < 0 || v >= va->num_voices || va->list[v] != VOICE_LIST_SOUNDING) return;
+    list_remove(va, v);
+    list_append(va, v, VOICE_LIST_RELEASING);
+}
+
+void voice_alloc_free(voice_alloc_t *va, int v)
+{
+    if (v < 0 || v >= va->num_voices || va->list[v] == VOICE_LIST_FREE) return;
+    list_remove(va, v);
+    list_append(va, v, VOICE_LIST_FREE);
+}
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#define VOICE_ALLOC_MAX 64
+#define VOICE_NONE      (-1)
+
+typedef enum {
+    VOICE_LIST_FREE = 0,
+    VOICE_LIST_SOUNDING,   // attack / decay / sustain
+    VOICE_LIST_RELEASING,
+    VOICE_LIST_COUNT
+} voice_list_t;
+
+// Voices are kept on intrusive doubly-linked lists. The sounding and
+// releasing lists are in the order voices joined them, so the head of each
+// is its oldest member and every operation below is O(1).
+typedef struct {
+    int8_t next[VOICE_ALLOC_MAX];
+    int8_t prev[VOICE_ALLOC_MAX];
+    uint8_t list[VOICE_ALLOC_MAX];
+    int8_t head[VOICE_LIST_COUNT];
+    int8_t tail[VOICE_LIST_COUNT];
+    uint8_t count[VOICE_LIST_COUNT];
+    int num_voices;
+} voice_alloc_t;
+
+void voice_alloc_init(voice_alloc_t *va, int num_voices);
+
+// Takes a free voice, else steals the longest-releasing voice, else the
+// oldest sounding one. The voice is moved to the sounding list. *stolen is
+// set when the returned voice was still audible.
+int voice_alloc_note_on(voice_alloc_t *va, bool *stolen);
+
+// Sounding -> releasing. No-op for voices on other lists.
+void voice_alloc_release(voice_alloc_t *va, int v);
+
+// Returns a voice to the free list once its envelope has finished.
+void voice_alloc_free(voice_alloc_t *va, int v);
+
+static inline int voice_alloc_first(const voice_alloc_t *va, voice_list_t list)
+{
+    return va->head[list];
+}
+
+static inline int voice_alloc_next(const voice_alloc_t *va, int v)
+{
+    return va->next[v];
+}
@@ -0,0 +1,108 @@
+#include "wavetable.h"
+#include "audio_platform.h"
+#include <math.h>
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+#define WT_STRIDE (WT_TABLE_SIZE + 1)
+
+static float * sine_table = NULL;
+static float * square_tables = NULL; // WT_NUM_LEVELS x WT_STRIDE
+static float * saw_tables = NULL;
+
+static float * wt_alloc(size_t count)
+{
+    // Tables are read every sample, so prefer internal RAM over PSRAM
+    float * p = audio_calloc(count, sizeof(float), AUDIO_MEM_FAST);
+    if (!p) p = audio_calloc(count, sizeof(float), AUDIO_MEM_BULK);
+    return p;
+}
+
+// Additive synthesis of one level. Harmonic k of sample i is just
+// sine_table[(k * i) mod N], so no transcendental calls are needed here.
+// The Lanczos sigma factor tames the Gibbs overshoot of the truncated series.
+static void build_level(float *dst, int max_harm, bool odd_only, float sign)
+{
+    for (int i = 0; i < WT_TABLE_SIZE; i++) dst[i] = 0.0f;
+
+    for (int k = 1; k <= max_harm; k++) {
+        if (odd_only && (k & 1) == 0) continue;
+        float x = (float)M_PI * (float)k / (float)(max_harm + 1);
+        float sigma = sinf(x) / x;
+        float amp = sign * sigma / (float)k;
+        for (int i = 0; i < WT_TABLE_SIZE; i++) {
+            dst[i] += amp * sine_table[(k * i) & (WT_TABLE_SIZE - 1)];
+        }
+    }
+
+    float peak = 0.0f;
+    for (int i = 0; i < WT_TABLE_SIZE; i++) {
+        float a = fabsf(dst[i]);
+        if (a > peak) peak = a;
+    }
+    if (peak > 0.0f) {
+        float norm = 1.0f / peak;
+        for (int i = 0; i < WT_TABLE_SIZE; i++) dst[i] *= norm;
+    }
+    dst[WT_TABLE_SIZE] = dst[0];
+}
+
+bool wavetable_init(void)
+{
+    if (sine_table) return true;
+
+    float * sine = wt_alloc(WT_STRIDE);
+    float * square = wt_alloc(WT_NUM_LEVELS * WT_STRIDE);
+    float * saw = wt_alloc(WT_NUM_LEVELS * WT_STRIDE);
+    if (!sine || !square || !saw) {
+        audio_free(sine);
+        audio_free(square);
+        audio_free(saw);
+        return false;
+    }
+
+    for (int i = 0; i < WT_TABLE_SIZE; i++) {
+        sine[i] = sinf(2.0f * (float)M_PI * (float)i / (float)WT_TABLE_SIZE);
+    }
+    sine[WT_TABLE_SIZE] = sine[0];
+    sine_table = sine;
+
+    for (int l = 0; l < WT_NUM_LEVELS; l++) {
+        int max_harm = (WT_TABLE_SIZE / 4) >> l;
+        build_level(&square[l * WT_STRIDE], max_harm, true, 1.0f);
+        // Rising ramp (2 * phase - 1) has the negated 1/k sine series
+        build_level(&saw[l * WT_STRIDE], max_harm, false, -1.0f);
+    }
+    square_tables = square;
+    saw_tables = saw;
+    return true;
+}
+
+uint32_t wavetable_phase_inc(float freq, float sample_rate)
+{
+    float inc = freq / sample_rate;
+    if (inc <= 0.0f) return 0;
+    if (inc >= 0.5f) return 0x80000000u;
+    return (uint32_t)(inc * 4294967296.0f);
+}
+
+const float * wavetable_select(int wave, uint32_t phase_inc)
+{
+    if (wave == WT_SINE) return sine_table;
+
+    // Level l holds H = (N / 4) >> l harmonics, which stays below Nyquist
+    // while H * phase_inc <= 2^31, i.e. phase_inc <= 2^(23 + l).
+    int level = 0;
+    if (phase_inc > 1) {
+        int ceil_log2 = 32 - __builtin_clz(phase_inc - 1);
+        level = ceil_log2 - (31 - (WT_TABLE_BITS - 2));
+        if (level < 0) level = 0;
+        if (level >= WT_NUM_LEVELS) level = WT_NUM_LEVELS - 1;
+    }
+
+    if (wave == WT_SQUARE) return square_tables ? &square_tables[level * WT_STRIDE] : NULL;
+    if (wave == WT_SAW) return saw_tables ? &saw_tables[level * WT_STRIDE] : NULL;
+    return NULL;
+}
@@ -0,0 +1,37 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// One cycle per table, plus a guard sample so interpolation never wraps.
+#define WT_TABLE_BITS   10
+#define WT_TABLE_SIZE   (1 << WT_TABLE_BITS)
+#define WT_FRAC_BITS    (32 - WT_TABLE_BITS)
+
+// One mip level per octave; level 0 holds WT_TABLE_SIZE / 4 harmonics,
+// each following level holds half as many.
+#define WT_NUM_LEVELS   9
+
+typedef enum {
+    WT_SINE = 0,
+    WT_SQUARE,
+    WT_SAW,
+    WT_NUM_WAVES
+} wt_wave_t;
+
+bool wavetable_init(void);
+
+// Phase increment of a 32-bit phase accumulator for the given frequency.
+uint32_t wavetable_phase_inc(float freq, float sample_rate);
+
+// Returns the band-limited table for the waveform whose highest harmonic
+// stays below Nyquist at the given phase increment, or NULL if not initialized.
+const float * wavetable_select(int wave, uint32_t phase_inc);
+
+static inline float wavetable_read(const float *table, uint32_t phase)
+{
+    uint32_t idx = phase >> WT_FRAC_BITS;
+    float frac = (float)(phase & ((1u << WT_FRAC_BITS) - 1)) * (1.0f / (float)(1u << WT_FRAC_BITS));
+    float a = table[idx];
+    return a + (table[idx + 1] - a) * frac;
+}